@@ -0,0 +1,438 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include "ZAssert.h"
+
+namespace ZSharp {
+
+// World space units each leaf is grown by, lets objects move a little before the tree has to change.
+static constexpr float BoundsMargin = 1.f;
+
+// A balanced tree never gets close to this, even with millions of leaves.
+static constexpr size_t MaxTraversalDepth = 128;
+
+static void UnionBounds(const float aMin[3], const float aMax[3], const float bMin[3], const float bMax[3], float outMin[3], float outMax[3]) {
+  for (size_t i = 0; i < 3; ++i) {
+    outMin[i] = (aMin[i] < bMin[i]) ? aMin[i] : bMin[i];
+    outMax[i] = (aMax[i] > bMax[i]) ? aMax[i] : bMax[i];
+  }
+}
+
+static float SurfaceArea(const float min[3], const float max[3]) {
+  const float x = max[0] - min[0];
+  const float y = max[1] - min[1];
+  const float z = max[2] - min[2];
+  return 2.f * ((x * y) + (y * z) + (z * x));
+}
+
+static float UnionSurfaceArea(const float aMin[3], const float aMax[3], const float bMin[3], const float bMax[3]) {
+  float min[3];
+  float max[3];
+  UnionBounds(aMin, aMax, bMin, bMax, min, max);
+  return SurfaceArea(min, max);
+}
+
+static void PushIndex(Array<int32>& indices, size_t& count, int32 index) {
+  if (indices.Size() <= count) {
+    indices.Resize((count + 1) * 2);
+  }
+
+  indices[count] = index;
+  ++count;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() {
+}
+
+void BoundingVolumeHierarchy::Clear() {
+  mNodes.Clear();
+  mRoot = NullNode;
+  mFreeList = NullNode;
+}
+
+int32 BoundingVolumeHierarchy::Insert(const AABB& bounds, int32 userData) {
+  const int32 leaf = AllocateNode();
+
+  Node& node = mNodes[leaf];
+  for (size_t i = 0; i < 3; ++i) {
+    node.min[i] = bounds.MinBounds()[i] - BoundsMargin;
+    node.max[i] = bounds.MaxBounds()[i] + BoundsMargin;
+  }
+
+  node.userData = userData;
+  node.height = 0;
+
+  InsertLeaf(leaf);
+  return leaf;
+}
+
+void BoundingVolumeHierarchy::Remove(int32 proxy) {
+  ZAssert(mNodes[proxy].height == 0);
+
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+}
+
+bool BoundingVolumeHierarchy::Move(int32 proxy, const AABB& bounds) {
+  Node& node = mNodes[proxy];
+  ZAssert(node.height == 0);
+
+  const Vec3& min = bounds.MinBounds();
+  const Vec3& max = bounds.MaxBounds();
+
+  bool contained = true;
+  bool oversized = false;
+  for (size_t i = 0; i < 3; ++i) {
+    contained = contained && (node.min[i] <= min[i]) && (node.max[i] >= max[i]);
+
+    // A leaf that shrank a lot would keep testing positive against things it no longer touches.
+    oversized = oversized || ((min[i] - node.min[i]) > (4.f * BoundsMargin)) || ((node.max[i] - max[i]) > (4.f * BoundsMargin));
+  }
+
+  if (contained && !oversized) {
+    return false;
+  }
+
+  RemoveLeaf(proxy);
+
+  for (size_t i = 0; i < 3; ++i) {
+    node.min[i] = min[i] - BoundsMargin;
+    node.max[i] = max[i] + BoundsMargin;
+  }
+
+  InsertLeaf(proxy);
+  return true;
+}
+
+int32 BoundingVolumeHierarchy::GetUserData(int32 proxy) const {
+  return mNodes[proxy].userData;
+}
+
+int32 BoundingVolumeHierarchy::GetHeight() const {
+  return (mRoot == NullNode) ? 0 : mNodes[mRoot].height;
+}
+
+void BoundingVolumeHierarchy::CullFrustum(const float planes[6][4], Array<int32>& inside, size_t& numInside, Array<int32>& partial, size_t& numPartial) const {
+  numInside = 0;
+  numPartial = 0;
+
+  if (mRoot == NullNode) {
+    return;
+  }
+
+  // Planes a node is entirely inside of are dropped from the mask for its children.
+  struct StackEntry {
+    int32 node;
+    uint32 planeMask;
+  };
+
+  StackEntry stack[MaxTraversalDepth];
+  size_t stackSize = 0;
+  stack[stackSize++] = { mRoot, 0x3F };
+
+  while (stackSize > 0) {
+    const StackEntry entry = stack[--stackSize];
+    const Node& node = mNodes[entry.node];
+
+    bool outside = false;
+    uint32 childMask = 0;
+
+    for (size_t p = 0; (p < 6) && !outside; ++p) {
+      if ((entry.planeMask & (1 << p)) == 0) {
+        continue;
+      }
+
+      float nearest = planes[p][3];
+      float farthest = planes[p][3];
+
+      for (size_t axis = 0; axis < 3; ++axis) {
+        const float minDist = planes[p][axis] * node.min[axis];
+        const float maxDist = planes[p][axis] * node.max[axis];
+        nearest += (minDist < maxDist) ? minDist : maxDist;
+        farthest += (minDist < maxDist) ? maxDist : minDist;
+      }
+
+      if (farthest < 0.f) {
+        outside = true;
+      }
+      else if (nearest < 0.f) {
+        childMask |= (1 << p);
+      }
+    }
+
+    if (outside) {
+      continue;
+    }
+
+    if (childMask == 0) {
+      CollectLeaves(entry.node, inside, numInside);
+    }
+    else if (node.height == 0) {
+      PushIndex(partial, numPartial, node.userData);
+    }
+    else {
+      ZAssert((stackSize + 2) <= MaxTraversalDepth);
+      stack[stackSize++] = { node.left, childMask };
+      stack[stackSize++] = { node.right, childMask };
+    }
+  }
+}
+
+int32 BoundingVolumeHierarchy::AllocateNode() {
+  if (mFreeList == NullNode) {
+    const size_t oldSize = mNodes.Size();
+    const size_t newSize = (oldSize == 0) ? 16 : (oldSize * 2);
+    mNodes.Resize(newSize);
+
+    for (size_t i = oldSize; i < newSize; ++i) {
+      mNodes[i].parent = (i == (newSize - 1)) ? NullNode : (int32)(i + 1);
+      mNodes[i].height = -1;
+    }
+
+    mFreeList = (int32)oldSize;
+  }
+
+  const int32 node = mFreeList;
+  Node& freeNode = mNodes[node];
+  mFreeList = freeNode.parent;
+
+  freeNode.parent = NullNode;
+  freeNode.left = NullNode;
+  freeNode.right = NullNode;
+  freeNode.height = 0;
+  freeNode.userData = -1;
+  return node;
+}
+
+void BoundingVolumeHierarchy::FreeNode(int32 node) {
+  mNodes[node].parent = mFreeList;
+  mNodes[node].height = -1;
+  mFreeList = node;
+}
+
+void BoundingVolumeHierarchy::InsertLeaf(int32 leaf) {
+  if (mRoot == NullNode) {
+    mRoot = leaf;
+    mNodes[leaf].parent = NullNode;
+    return;
+  }
+
+  // Walk down picking whichever side grows the total surface area the least.
+  int32 index = mRoot;
+  while (mNodes[index].height > 0) {
+    const Node& node = mNodes[index];
+    const Node& leafNode = mNodes[leaf];
+    const Node& left = mNodes[node.left];
+    const Node& right = mNodes[node.right];
+
+    const float area = SurfaceArea(node.min, node.max);
+    const float combinedArea = UnionSurfaceArea(node.min, node.max, leafNode.min, leafNode.max);
+
+    // Cost of making a new parent for this node and the leaf.
+    const float cost = 2.f * combinedArea;
+
+    // Minimum cost of pushing the leaf further down the tree.
+    const float inheritanceCost = 2.f * (combinedArea - area);
+
+    float costLeft = UnionSurfaceArea(left.min, left.max, leafNode.min, leafNode.max) + inheritanceCost;
+    if (left.height > 0) {
+      costLeft -= SurfaceArea(left.min, left.max);
+    }
+
+    float costRight = UnionSurfaceArea(right.min, right.max, leafNode.min, leafNode.max) + inheritanceCost;
+    if (right.height > 0) {
+      costRight -= SurfaceArea(right.min, right.max);
+    }
+
+    if ((cost < costLeft) && (cost < costRight)) {
+      break;
+    }
+
+    index = (costLeft < costRight) ? node.left : node.right;
+  }
+
+  const int32 sibling = index;
+
+  // Allocating may move the nodes, don't hold onto any references across it.
+  const int32 newParent = AllocateNode();
+  const int32 oldParent = mNodes[sibling].parent;
+
+  Node& parentNode = mNodes[newParent];
+  parentNode.parent = oldParent;
+  parentNode.left = sibling;
+  parentNode.right = leaf;
+  parentNode.height = mNodes[sibling].height + 1;
+  UnionBounds(mNodes[sibling].min, mNodes[sibling].max, mNodes[leaf].min, mNodes[leaf].max, parentNode.min, parentNode.max);
+
+  if (oldParent != NullNode) {
+    if (mNodes[oldParent].left == sibling) {
+      mNodes[oldParent].left = newParent;
+    }
+    else {
+      mNodes[oldParent].right = newParent;
+    }
+  }
+  else {
+    mRoot = newParent;
+  }
+
+  mNodes[sibling].parent = newParent;
+  mNodes[leaf].parent = newParent;
+
+  for (index = newParent; index != NullNode; index = mNodes[index].parent) {
+    index = Balance(index);
+    Refit(index);
+  }
+}
+
+void BoundingVolumeHierarchy::RemoveLeaf(int32 leaf) {
+  if (leaf == mRoot) {
+    mRoot = NullNode;
+    return;
+  }
+
+  const int32 parent = mNodes[leaf].parent;
+  const int32 grandParent = mNodes[parent].parent;
+  const int32 sibling = (mNodes[parent].left == leaf) ? mNodes[parent].right : mNodes[parent].left;
+
+  FreeNode(parent);
+
+  if (grandParent == NullNode) {
+    mRoot = sibling;
+    mNodes[sibling].parent = NullNode;
+    return;
+  }
+
+  if (mNodes[grandParent].left == parent) {
+    mNodes[grandParent].left = sibling;
+  }
+  else {
+    mNodes[grandParent].right = sibling;
+  }
+
+  mNodes[sibling].parent = grandParent;
+
+  for (int32 index = grandParent; index != NullNode; index = mNodes[index].parent) {
+    index = Balance(index);
+    Refit(index);
+  }
+}
+
+int32 BoundingVolumeHierarchy::Balance(int32 node) {
+  Node& a = mNodes[node];
+  if (a.height < 2) {
+    return node;
+  }
+
+  const int32 indexB = a.left;
+  const int32 indexC = a.right;
+  Node& b = mNodes[indexB];
+  Node& c = mNodes[indexC];
+
+  const int32 balance = c.height - b.height;
+
+  // Rotate C up.
+  if (balance > 1) {
+    const int32 indexF = c.left;
+    const int32 indexG = c.right;
+    Node& f = mNodes[indexF];
+    Node& g = mNodes[indexG];
+
+    c.left = node;
+    c.parent = a.parent;
+    a.parent = indexC;
+
+    if (c.parent != NullNode) {
+      if (mNodes[c.parent].left == node) {
+        mNodes[c.parent].left = indexC;
+      }
+      else {
+        mNodes[c.parent].right = indexC;
+      }
+    }
+    else {
+      mRoot = indexC;
+    }
+
+    // The taller grandchild stays with C.
+    const bool keepF = f.height > g.height;
+    const int32 indexKeep = keepF ? indexF : indexG;
+    const int32 indexMove = keepF ? indexG : indexF;
+    Node& keep = mNodes[indexKeep];
+    Node& move = mNodes[indexMove];
+
+    c.right = indexKeep;
+    a.right = indexMove;
+    move.parent = node;
+
+    UnionBounds(b.min, b.max, move.min, move.max, a.min, a.max);
+    UnionBounds(a.min, a.max, keep.min, keep.max, c.min, c.max);
+    a.height = 1 + ((b.height > move.height) ? b.height : move.height);
+    c.height = 1 + ((a.height > keep.height) ? a.height : keep.height);
+    return indexC;
+  }
+
+  // Rotate B up.
+  if (balance < -1) {
+    const int32 indexD = b.left;
+    const int32 indexE = b.right;
+    Node& d = mNodes[indexD];
+    Node& e = mNodes[indexE];
+
+    b.left = node;
+    b.parent = a.parent;
+    a.parent = indexB;
+
+    if (b.parent != NullNode) {
+      if (mNodes[b.parent].left == node) {
+        mNodes[b.parent].left = indexB;
+      }
+      else {
+        mNodes[b.parent].right = indexB;
+      }
+    }
+    else {
+      mRoot = indexB;
+    }
+
+    const bool keepD = d.height > e.height;
+    const int32 indexKeep = keepD ? indexD : indexE;
+    const int32 indexMove = keepD ? indexE : indexD;
+    Node& keep = mNodes[indexKeep];
+    Node& move = mNodes[indexMove];
+
+    b.right = indexKeep;
+    a.left = indexMove;
+    move.parent = node;
+
+    UnionBounds(c.min, c.max, move.min, move.max, a.min, a.max);
+    UnionBounds(a.min, a.max, keep.min, keep.max, b.min, b.max);
+    a.height = 1 + ((c.height > move.height) ? c.height : move.height);
+    b.height = 1 + ((a.height > keep.height) ? a.height : keep.height);
+    return indexB;
+  }
+
+  return node;
+}
+
+void BoundingVolumeHierarchy::Refit(int32 node) {
+  Node& current = mNodes[node];
+  const Node& left = mNodes[current.left];
+  const Node& right = mNodes[current.right];
+
+  UnionBounds(left.min, left.max, right.min, right.max, current.min, current.max);
+  current.height = 1 + ((left.height > right.height) ? left.height : right.height);
+}
+
+void BoundingVolumeHierarchy::CollectLeaves(int32 node, Array<int32>& leaves, size_t& numLeaves) const {
+  const Node& current = mNodes[node];
+
+  if (current.height == 0) {
+    PushIndex(leaves, numLeaves, current.userData);
+  }
+  else {
+    CollectLeaves(current.left, leaves, numLeaves);
+    CollectLeaves(current.right, leaves, numLeaves);
+  }
+}
+
+}
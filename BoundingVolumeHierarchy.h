@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "AABB.h"
+#include "Array.h"
+
+namespace ZSharp {
+
+/*
+Dynamic bounding volume hierarchy over world space boxes.
+Leaves store their box grown by a margin so small movements only need to check containment instead of touching the tree.
+When a box escapes its leaf it is removed and reinserted, the tree is kept balanced with rotations on the way back up.
+Node indices stay valid until the node is removed, they are what callers hold on to as proxies.
+*/
+class BoundingVolumeHierarchy final {
+  public:
+
+  static constexpr int32 NullNode = -1;
+
+  BoundingVolumeHierarchy();
+
+  BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+  void operator=(const BoundingVolumeHierarchy&) = delete;
+
+  void Clear();
+
+  // Returns the proxy for the new leaf.
+  int32 Insert(const AABB& bounds, int32 userData);
+
+  void Remove(int32 proxy);
+
+  // Refits the leaf to the new bounds.
+  // Returns true if the leaf had to be reinserted.
+  bool Move(int32 proxy, const AABB& bounds);
+
+  int32 GetUserData(int32 proxy) const;
+
+  int32 GetHeight() const;
+
+  // Walks the tree against planes laid out the same as Camera::GetFrustumPlanes().
+  // Subtrees entirely inside of the frustum are accepted without testing their children and their leaves go into inside.
+  // Leaves that cross a plane go into partial and still need a precise test.
+  // The arrays are grown as needed, only the first numInside/numPartial entries are written.
+  void CullFrustum(const float planes[6][4], Array<int32>& inside, size_t& numInside, Array<int32>& partial, size_t& numPartial) const;
+
+  private:
+  struct Node {
+    float min[3];
+    float max[3];
+    int32 parent; // Next free node when unused.
+    int32 left;
+    int32 right;
+    int32 height; // 0 for leaves, -1 for unused nodes.
+    int32 userData;
+  };
+
+  Array<Node> mNodes;
+  int32 mRoot = NullNode;
+  int32 mFreeList = NullNode;
+
+  int32 AllocateNode();
+
+  void FreeNode(int32 node);
+
+  void InsertLeaf(int32 leaf);
+
+  void RemoveLeaf(int32 leaf);
+
+  int32 Balance(int32 node);
+
+  void Refit(int32 node);
+
+  void CollectLeaves(int32 node, Array<int32>& leaves, size_t& numLeaves) const;
+};
+
+}
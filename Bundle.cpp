@@ -1,86 +1,134 @@
 #include "Bundle.h"
 
+#include "HashFunctions.h"
 #include "ZConfig.h"
 
+#include <cstring>
+
 namespace ZSharp {
 
-const size_t BundleVersion = 1;
+const size_t BundleVersion = 4;
 
 Bundle* GlobalBundle = nullptr;
 
 Bundle::Bundle(const FileString& filename) : mHandle(filename) {
   if (mHandle.IsOpen()) {
-    MemoryDeserializer deserializer(mHandle.GetBuffer());
-    Deserialize(deserializer);
+    Open();
+  }
+}
+
+Bundle::~Bundle() {
+  for (Asset* asset : mAssets) {
+    delete asset;
   }
 }
 
 Asset* Bundle::GetAsset(const String& name) {
-  Asset* foundAsset = nullptr;
+  if (mHeader == nullptr) {
+    return nullptr;
+  }
+
+  const uint32 nameLength = (uint32)name.Length();
+  const uint32 hash = MurmurHash3_32(name.Str(), (int32)nameLength, 0);
+  const uint64 mask = mHeader->tableSize - 1;
+
+  uint64 slot = hash & mask;
+  for (uint64 probes = 0; probes < mHeader->tableSize; ++probes) {
+    const uint32 index = mTable[slot];
+    if (index == 0) {
+      return nullptr;
+    }
 
-  for (Asset& asset : mAssets) {
-    if (asset.Name() == name) {
-      foundAsset = &asset;
-      break;
+    if (index > mAssets.Size()) {
+      return nullptr;
     }
+
+    const BundleEntry& entry = mEntries[index - 1];
+    if ((entry.nameHash == hash) && (entry.nameLength == nameLength) && ValidString(entry.nameOffset, entry.nameLength)
+      && (memcmp(mStrings + entry.nameOffset, name.Str(), nameLength) == 0)) {
+      return GetAsset((size_t)(index - 1));
+    }
+
+    slot = (slot + 1) & mask;
   }
 
-  return foundAsset;
+  return nullptr;
 }
 
-const Array<Asset>& Bundle::Assets() const {
-  return mAssets;
-}
+Asset* Bundle::GetAsset(size_t index) {
+  if (index >= mAssets.Size()) {
+    return nullptr;
+  }
 
-bool Bundle::Deserialize(MemoryDeserializer& deserializer) {
-  /*
-    1) Read any header info
-      1a) Bundle Version
-      1b) Serialized Asset objects
-      1c) Read serialized block size
-    2) Read a block of serialized memory
-      2a) Size means how many bytes the next serialized blob is
-      2b) Followed by Size bytes of serialized asset data
-      2c) Repeat for N assets
-  */
-  
-  size_t bundleVersion = 0;
-  if (!deserializer.Deserialize(&bundleVersion, sizeof(bundleVersion))) {
-    return false;
+  if (mAssets[index] != nullptr) {
+    return mAssets[index];
   }
 
-  if (bundleVersion != BundleVersion) {
-    return false;
+  const BundleEntry& entry = mEntries[index];
+  const size_t fileSize = mHandle.GetSize();
+
+  if ((entry.dataOffset > fileSize) || (entry.dataSize > (fileSize - entry.dataOffset))
+    || !ValidString(entry.nameOffset, entry.nameLength)
+    || !ValidString(entry.extensionOffset, entry.extensionLength)
+    || !ValidString(entry.loosePathOffset, entry.loosePathLength)) {
+    return nullptr;
   }
 
-  size_t numAssets = 0;
-  deserializer.Deserialize(&numAssets, sizeof(numAssets));
-  mAssets.Resize(numAssets);
-  for (size_t i = 0; i < numAssets; ++i) {
-    mAssets[i].Deserialize(deserializer);
+  String name(mStrings, entry.nameOffset, entry.nameLength);
+  String extension(mStrings, entry.extensionOffset, entry.extensionLength);
+  String loosePath(mStrings, entry.loosePathOffset, entry.loosePathLength);
+
+  Asset* asset = new Asset(entry.dataSize, name, extension, entry.loose != 0, FileString(loosePath), (AssetType)entry.type);
+  asset->SetLoaderOffset((void*)(mHandle.GetBuffer() + entry.dataOffset), entry.dataSize);
+
+  mAssets[index] = asset;
+  return asset;
+}
+
+size_t Bundle::NumAssets() const {
+  return mAssets.Size();
+}
+
+bool Bundle::Open() {
+  const size_t fileSize = mHandle.GetSize();
+  if (fileSize < sizeof(BundleHeader)) {
+    return false;
   }
 
-  const size_t padding = SerializerPadding;
+  const char* base = mHandle.GetBuffer();
+  const BundleHeader* header = (const BundleHeader*)base;
 
-  // Skip over memory block size.
-  deserializer.Reassign(deserializer.BaseAddress() + deserializer.Offset() + padding);
+  if ((header->versionSize != sizeof(header->version)) || (header->version != BundleVersion)) {
+    return false;
+  }
 
-  for (size_t i = 0; i < mAssets.Size(); ++i) {
-    size_t serializedSize = 0;
-    if (!deserializer.Deserialize(&serializedSize, sizeof(serializedSize))) {
-      return false;
-    }
+  // Everything past here is read without further checks, make sure the directory fits in the file.
+  const uint64 numAssets = header->numAssets;
+  const uint64 tableSize = header->tableSize;
+  const bool validTable = (tableSize > 0) && ((tableSize & (tableSize - 1)) == 0) && (tableSize >= numAssets);
+  const bool validEntries = (header->entriesOffset <= fileSize) && (numAssets <= ((fileSize - header->entriesOffset) / sizeof(BundleEntry)));
+  const bool validSlots = (header->tableOffset <= fileSize) && (tableSize <= ((fileSize - header->tableOffset) / sizeof(uint32)));
+  const bool validStrings = (header->stringsOffset <= fileSize) && (header->stringsSize <= (fileSize - header->stringsOffset));
 
-    Asset& asset = mAssets[i];
-    uint8* offset = deserializer.BaseAddress() + deserializer.Offset() + padding;
+  if (!validTable || !validEntries || !validSlots || !validStrings) {
+    return false;
+  }
+
+  mHeader = header;
+  mEntries = (const BundleEntry*)(base + header->entriesOffset);
+  mTable = (const uint32*)(base + header->tableOffset);
+  mStrings = base + header->stringsOffset;
 
-    // Set the asset load point and skip ahead to the next block of memory.
-    asset.SetLoaderOffset(offset, serializedSize);
-    deserializer.Reassign(offset + serializedSize);
+  // Zeroed pointers, nothing is created until it's looked up.
+  if (numAssets > 0) {
+    mAssets.Resize((size_t)numAssets);
   }
 
   return true;
 }
 
+bool Bundle::ValidString(uint32 offset, uint32 length) const {
+  return ((uint64)offset + (uint64)length) <= mHeader->stringsSize;
 }
 
+}
@@ -12,29 +12,77 @@ namespace ZSharp {
 
 extern const size_t BundleVersion;
 
+/*
+On disk layout, read in place straight out of the mapped file.
+  BundleHeader
+  BundleEntry[numAssets]
+  uint32[tableSize], open addressed on the name hash, entry index + 1 or zero if the slot is empty
+  Strings, NUL terminated names, extensions and loose paths
+  Serialized asset data, each asset is still prefixed by its serialized size
+*/
+struct BundleHeader {
+  // Laid out like a serialized size_t so v1 readers see a version they don't know.
+  uint64 versionSize;
+  uint64 version;
+  uint64 numAssets;
+  // Always a power of two, at least twice the number of assets.
+  uint64 tableSize;
+  uint64 entriesOffset;
+  uint64 tableOffset;
+  uint64 stringsOffset;
+  uint64 stringsSize;
+};
+
+struct BundleEntry {
+  // Offsets are from the start of the file for data and from the start of the strings for everything else.
+  uint64 dataOffset;
+  uint64 dataSize;
+  uint32 nameHash;
+  uint32 nameOffset;
+  uint32 nameLength;
+  uint32 extensionOffset;
+  uint32 extensionLength;
+  uint32 loosePathOffset;
+  uint32 loosePathLength;
+  uint32 type;
+  uint32 loose;
+  uint32 padding;
+};
+
 /*
 A bundle contains a collection of assets.
 These can be loose or serialized assets.
 Loose assets are not stored in the bundle itself, they are just placeholders.
-Order matters. Assets are stored sequentially in the serialized section as they appear in the header.
+Order matters. Assets are stored sequentially in the serialized section as they appear in the directory.
+Opening only checks the header, Asset objects are created the first time they are asked for.
 */
 class Bundle final {
   public:
 
   Bundle(const FileString& filename);
 
+  ~Bundle();
+
   Bundle(const Bundle&) = delete;
   void operator=(const Bundle&) = delete;
 
   Asset* GetAsset(const String& name);
 
-  const Array<Asset>& Assets() const;
+  Asset* GetAsset(size_t index);
+
+  size_t NumAssets() const;
 
   private:
-  Array<Asset> mAssets;
   MemoryMappedFileReader mHandle;
+  const BundleHeader* mHeader = nullptr;
+  const BundleEntry* mEntries = nullptr;
+  const uint32* mTable = nullptr;
+  const char* mStrings = nullptr;
+  Array<Asset*> mAssets;
+
+  bool Open();
 
-  bool Deserialize(MemoryDeserializer& deserializer);
+  bool ValidString(uint32 offset, uint32 length) const;
 };
 
 extern Bundle* GlobalBundle;
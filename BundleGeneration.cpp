@@ -10,130 +10,590 @@
 #include "ScopedTimer.h"
 #include "PlatformIntrinsics.h"
 #include "CommonMath.h"
+#include "HashFunctions.h"
+#include "Texture.h"
+#include "PlatformMemory.h"
+
+#include <cstring>
 
 namespace ZSharp {
 
+// Entries in the post-transform cache that Tipsify plans for.
+// The rasterizer transforms everything up front, so this mostly keeps fetches through the index list close together.
+static constexpr int32 VertexCacheSize = 16;
+
+/*
+Merges corners that have exactly the same position and attributes.
+indices gets one entry per corner, vertices gets each distinct vertex once in order of first appearance.
+*/
+static void WeldVertices(const float* corners, size_t numCorners, size_t stride, Array<int32>& indices, Array<float>& vertices) {
+  const size_t vertexBytes = stride * sizeof(float);
+
+  // Open addressing, kept at most half full so probes stay short.
+  size_t tableSize = 16;
+  while (tableSize < (numCorners * 2)) {
+    tableSize <<= 1;
+  }
+
+  Array<int32> table(tableSize);
+  memset(table.GetData(), 0xFF, tableSize * sizeof(int32));
+
+  indices.Resize(numCorners);
+  vertices.Resize(numCorners * stride);
+
+  int32 numUnique = 0;
+  for (size_t i = 0; i < numCorners; ++i) {
+    const float* vertex = corners + (i * stride);
+    size_t slot = MurmurHash3_32(vertex, (int32)vertexBytes, 0) & (tableSize - 1);
+
+    while (true) {
+      const int32 existing = table[slot];
+      if (existing < 0) {
+        memcpy(vertices.GetData() + (numUnique * stride), vertex, vertexBytes);
+        table[slot] = numUnique;
+        indices[i] = numUnique;
+        ++numUnique;
+        break;
+      }
+      else if (memcmp(vertices.GetData() + (existing * stride), vertex, vertexBytes) == 0) {
+        indices[i] = existing;
+        break;
+      }
+
+      slot = (slot + 1) & (tableSize - 1);
+    }
+  }
+
+  vertices.Resize(numUnique * stride);
+}
+
+static int32 SkipDeadEnd(const Array<int32>& liveTriangles, Array<int32>& deadEnds, size_t& numDeadEnds, int32& cursor) {
+  // Recently used vertices first, they are the most likely to still be in the cache.
+  while (numDeadEnds > 0) {
+    --numDeadEnds;
+    const int32 vertex = deadEnds[numDeadEnds];
+    if (liveTriangles[vertex] > 0) {
+      return vertex;
+    }
+  }
+
+  const int32 numVerts = (int32)liveTriangles.Size();
+  for (; cursor < numVerts; ++cursor) {
+    if (liveTriangles[cursor] > 0) {
+      return cursor;
+    }
+  }
+
+  return -1;
+}
+
+/*
+Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+Fans out around one vertex at a time, emitting all of its remaining triangles, then moves to whichever neighbor will still be in the cache.
+Runs in linear time, which matters for the multi-million triangle sources.
+*/
+static void OptimizeVertexCache(Array<int32>& indices, size_t numVerts) {
+  const size_t numIndices = indices.Size();
+  const size_t numTriangles = numIndices / 3;
+
+  // Triangles using each vertex, packed into one list with an offset per vertex.
+  Array<int32> liveTriangles(numVerts);
+  for (size_t i = 0; i < numIndices; ++i) {
+    ++liveTriangles[indices[i]];
+  }
+
+  Array<int32> adjacencyOffsets(numVerts + 1);
+  for (size_t i = 0; i < numVerts; ++i) {
+    adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+  }
+
+  Array<int32> adjacency(numIndices);
+  Array<int32> adjacencyFill(numVerts);
+  for (size_t i = 0; i < numIndices; ++i) {
+    const int32 vertex = indices[i];
+    adjacency[adjacencyOffsets[vertex] + adjacencyFill[vertex]] = (int32)(i / 3);
+    ++adjacencyFill[vertex];
+  }
+
+  Array<int32> cacheTime(numVerts);
+  Array<uint8> emitted(numTriangles);
+  Array<int32> deadEnds(numIndices);
+  Array<int32> candidates(numIndices);
+  Array<int32> output(numIndices);
+
+  size_t numDeadEnds = 0;
+  size_t numOutput = 0;
+  int32 timeStamp = VertexCacheSize + 1;
+  int32 cursor = 1;
+  int32 fanVertex = 0;
+
+  while (fanVertex >= 0) {
+    size_t numCandidates = 0;
+
+    for (int32 i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; ++i) {
+      const int32 triangle = adjacency[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+
+      for (int32 j = 0; j < 3; ++j) {
+        const int32 vertex = indices[(triangle * 3) + j];
+        output[numOutput] = vertex;
+        ++numOutput;
+        deadEnds[numDeadEnds] = vertex;
+        ++numDeadEnds;
+        candidates[numCandidates] = vertex;
+        ++numCandidates;
+        --liveTriangles[vertex];
+
+        if ((timeStamp - cacheTime[vertex]) > VertexCacheSize) {
+          cacheTime[vertex] = timeStamp;
+          ++timeStamp;
+        }
+      }
+
+      emitted[triangle] = 1;
+    }
+
+    // Prefer the candidate that has been in the cache longest but will still be there after its own fan is emitted.
+    int32 nextVertex = -1;
+    int32 bestPriority = -1;
+    for (size_t i = 0; i < numCandidates; ++i) {
+      const int32 vertex = candidates[i];
+      if (liveTriangles[vertex] > 0) {
+        int32 priority = 0;
+        if ((timeStamp - cacheTime[vertex] + (2 * liveTriangles[vertex])) <= VertexCacheSize) {
+          priority = timeStamp - cacheTime[vertex];
+        }
+
+        if (priority > bestPriority) {
+          bestPriority = priority;
+          nextVertex = vertex;
+        }
+      }
+    }
+
+    if (nextVertex < 0) {
+      nextVertex = SkipDeadEnd(liveTriangles, deadEnds, numDeadEnds, cursor);
+    }
+
+    fanVertex = nextVertex;
+  }
+
+  ZAssert(numOutput == numIndices);
+  memcpy(indices.GetData(), output.GetData(), numIndices * sizeof(int32));
+}
+
+// Renumbers vertices in the order the index list first touches them, so the vertex table is walked front to back.
+static void ReorderVerticesByFirstUse(Array<int32>& indices, Array<float>& vertices, size_t stride) {
+  const size_t numVerts = vertices.Size() / stride;
+
+  Array<int32> remap(numVerts);
+  memset(remap.GetData(), 0xFF, numVerts * sizeof(int32));
+
+  Array<float> reordered(vertices.Size());
+
+  int32 nextVertex = 0;
+  for (size_t i = 0; i < indices.Size(); ++i) {
+    const int32 vertex = indices[i];
+    if (remap[vertex] < 0) {
+      remap[vertex] = nextVertex;
+      memcpy(reordered.GetData() + (nextVertex * stride), vertices.GetData() + (vertex * stride), stride * sizeof(float));
+      ++nextVertex;
+    }
+
+    indices[i] = remap[vertex];
+  }
+
+  Swap(vertices, reordered);
+}
+
+static uint32 AppendBundleString(Array<char>& strings, const String& value) {
+  const uint32 offset = (uint32)strings.Size();
+  const char* data = value.Str();
+  for (size_t i = 0; i < value.Length(); ++i) {
+    strings.PushBack(data[i]);
+  }
+
+  strings.PushBack('\0');
+  return offset;
+}
+
+// Atlas pages are at most this wide and tall, the shaders address them with 32 bit texel offsets either way.
+static constexpr size_t AtlasPageSize = 2048;
+
+// Only textures up to this size get packed, bigger ones already fill most of a page on their own.
+static constexpr size_t AtlasMaxTextureSize = 512;
+
+// Levels baked into every page, each one halves the gutter so this stops while there is still a texel of it left.
+static constexpr size_t AtlasMipLevels = 4;
+
+// Texels of edge replication around every texture, keeps filtering at the lower mips from picking up its neighbors.
+static constexpr size_t AtlasGutter = 1ULL << (AtlasMipLevels - 1);
+
+struct AtlasTexture {
+  size_t source = 0;
+  uint8* pixels = nullptr;
+  size_t width = 0;
+  size_t height = 0;
+  size_t cellWidth = 0;
+  size_t cellHeight = 0;
+  size_t page = 0;
+  size_t x = 0;
+  size_t y = 0;
+};
+
+struct SkylineSegment {
+  size_t x = 0;
+  size_t y = 0;
+  size_t width = 0;
+};
+
+struct AtlasPage {
+  Array<SkylineSegment> skyline;
+  size_t width = 0;
+  size_t height = 0;
+};
+
+// Decodes a PNG or JPG to 4 channel BGR, the same thing TexturePool ends up with at runtime.
+static uint8* DecodeTextureBGRA(const FileString& filename, size_t& width, size_t& height) {
+  const String extension(filename.GetExtension());
+  uint8* pixels = nullptr;
+  size_t channels = 0;
+  bool swapRedBlue = false;
+
+  if (extension == "png") {
+    // The PNG swizzle assumes 4 channels, so RGB sources get their alpha first and are swapped after.
+    PNG png(filename);
+    pixels = png.Decompress(ChannelOrderPNG::RGB);
+    width = png.GetWidth();
+    height = png.GetHeight();
+    channels = png.GetNumChannels();
+    swapRedBlue = true;
+  }
+  else if (extension == "jpg") {
+    JPEG jpg(filename);
+    pixels = jpg.Decompress(ChannelOrderJPG::BGR);
+    width = jpg.GetWidth();
+    height = jpg.GetHeight();
+    channels = jpg.GetNumChannels();
+  }
+
+  if ((pixels != nullptr) && (channels == 3)) {
+    pixels = InsertAlphaChannel(pixels, width, height);
+    channels = 4;
+  }
+
+  if ((pixels != nullptr) && (channels != 4)) {
+    PlatformFree(pixels);
+    return nullptr;
+  }
+
+  if ((pixels != nullptr) && swapRedBlue) {
+    Unaligned_RGBAToBGRA((uint32*)pixels, width, height);
+  }
+
+  return pixels;
+}
+
+// The shaders clamp UVs, so a mesh that wraps its texture can't be moved into an atlas without sampling its neighbors.
+static bool UVsInUnitRange(const Mesh& mesh) {
+  const Array<float>& vertices = mesh.GetVertTable();
+  const size_t stride = mesh.Stride();
+  for (size_t i = 0; i < vertices.Size(); i += stride) {
+    const float u = vertices[i + 4];
+    const float v = vertices[i + 5];
+    if ((u < 0.f) || (u > 1.f) || (v < 0.f) || (v > 1.f)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+Skyline bottom left: the page keeps the top edge of everything placed so far as a list of segments.
+Each cell goes where its bottom lands lowest, ties go to the leftmost spot.
+Returns false if the page has no room left for it.
+*/
+static bool SkylinePlace(AtlasPage& page, size_t cellWidth, size_t cellHeight, size_t& outX, size_t& outY) {
+  Array<SkylineSegment>& skyline = page.skyline;
+
+  size_t bestSegment = skyline.Size();
+  size_t bestY = AtlasPageSize;
+  for (size_t i = 0; i < skyline.Size(); ++i) {
+    const size_t x = skyline[i].x;
+    if ((x + cellWidth) > AtlasPageSize) {
+      break;
+    }
+
+    // The cell rests on the highest segment it spans.
+    size_t y = 0;
+    for (size_t j = i, spanned = 0; (spanned < cellWidth) && (j < skyline.Size()); ++j) {
+      y = (skyline[j].y > y) ? skyline[j].y : y;
+      spanned += skyline[j].width;
+    }
+
+    if (((y + cellHeight) <= AtlasPageSize) && (y < bestY)) {
+      bestY = y;
+      bestSegment = i;
+    }
+  }
+
+  if (bestSegment == skyline.Size()) {
+    return false;
+  }
+
+  outX = skyline[bestSegment].x;
+  outY = bestY;
+
+  // Rebuild the skyline with the cell's top edge replacing whatever it covers.
+  const size_t left = outX;
+  const size_t right = outX + cellWidth;
+  Array<SkylineSegment> next;
+  for (size_t i = 0; i < skyline.Size(); ++i) {
+    const SkylineSegment& segment = skyline[i];
+    const size_t segmentRight = segment.x + segment.width;
+
+    if (i == bestSegment) {
+      next.PushBack({ left, outY + cellHeight, cellWidth });
+    }
+
+    if ((segmentRight <= left) || (segment.x >= right)) {
+      next.PushBack(segment);
+    }
+    else if (segmentRight > right) {
+      next.PushBack({ right, segment.y, segmentRight - right });
+    }
+  }
+
+  // Neighbors at the same height become one segment so later cells can span them.
+  skyline.Clear();
+  for (size_t i = 0; i < next.Size(); ++i) {
+    if ((skyline.Size() > 0) && (skyline[skyline.Size() - 1].y == next[i].y)) {
+      skyline[skyline.Size() - 1].width += next[i].width;
+    }
+    else {
+      skyline.PushBack(next[i]);
+    }
+  }
+
+  page.width = (right > page.width) ? right : page.width;
+  page.height = ((outY + cellHeight) > page.height) ? (outY + cellHeight) : page.height;
+  return true;
+}
+
+// Copies the texture into its cell, the gutter and the alignment padding repeat the nearest edge texel.
+static void BlitAtlasCell(uint32* page, size_t pageWidth, const AtlasTexture& texture) {
+  const uint32* src = (const uint32*)texture.pixels;
+  const size_t cellX = texture.x - AtlasGutter;
+  const size_t cellY = texture.y - AtlasGutter;
+
+  for (size_t y = 0; y < texture.cellHeight; ++y) {
+    const size_t srcY = (y < AtlasGutter) ? 0 : (((y - AtlasGutter) < texture.height) ? (y - AtlasGutter) : (texture.height - 1));
+    uint32* destRow = page + ((cellY + y) * pageWidth) + cellX;
+    const uint32* srcRow = src + (srcY * texture.width);
+
+    for (size_t x = 0; x < texture.cellWidth; ++x) {
+      const size_t srcX = (x < AtlasGutter) ? 0 : (((x - AtlasGutter) < texture.width) ? (x - AtlasGutter) : (texture.width - 1));
+      destRow[x] = srcRow[srcX];
+    }
+  }
+}
+
 bool GenerateBundle(const FileString& filename, Array<Asset>& assets, MemorySerializer& data) {
-  FileSerializer fileSerializer(filename);
-  if (!fileSerializer.Serialize(&BundleVersion, sizeof(BundleVersion))) {
+  const size_t numAssets = assets.Size();
+
+  size_t tableSize = 16;
+  while (tableSize < (numAssets * 2)) {
+    tableSize <<= 1;
+  }
+
+  BundleHeader header{};
+  header.versionSize = sizeof(header.version);
+  header.version = BundleVersion;
+  header.numAssets = numAssets;
+  header.tableSize = tableSize;
+  header.entriesOffset = sizeof(BundleHeader);
+  header.tableOffset = header.entriesOffset + (numAssets * sizeof(BundleEntry));
+  header.stringsOffset = header.tableOffset + (tableSize * sizeof(uint32));
+
+  Array<BundleEntry> entries(numAssets);
+  Array<uint32> table(tableSize);
+  Array<char> strings;
+
+  for (size_t i = 0; i < numAssets; ++i) {
+    Asset& asset = assets[i];
+    BundleEntry& entry = entries[i];
+
+    const String& name = asset.Name();
+    const String& extension = asset.Extension();
+    const String loosePath(asset.LoosePath().GetAbsolutePath());
+
+    entry.nameHash = MurmurHash3_32(name.Str(), (int32)name.Length(), 0);
+    entry.nameOffset = AppendBundleString(strings, name);
+    entry.nameLength = (uint32)name.Length();
+    entry.extensionOffset = AppendBundleString(strings, extension);
+    entry.extensionLength = (uint32)extension.Length();
+    entry.loosePathOffset = AppendBundleString(strings, loosePath);
+    entry.loosePathLength = (uint32)loosePath.Length();
+    entry.type = (uint32)asset.Type();
+    entry.loose = asset.IsLoose() ? 1 : 0;
+
+    size_t slot = entry.nameHash & (tableSize - 1);
+    while (table[slot] != 0) {
+      slot = (slot + 1) & (tableSize - 1);
+    }
+
+    table[slot] = (uint32)(i + 1);
+  }
+
+  // Keep the data section 8 byte aligned.
+  while ((strings.Size() % 8) != 0) {
+    strings.PushBack('\0');
+  }
+
+  header.stringsSize = strings.Size();
+  const size_t dataStart = header.stringsOffset + header.stringsSize;
+
+  /*
+  Each asset in data was written as its serialized size followed by its serialized block.
+  Both are framed by the serializer, so the block itself starts three size_t in.
+  */
+  const size_t padding = SerializerPadding;
+  size_t recordOffset = 0;
+  for (size_t i = 0; i < numAssets; ++i) {
+    if ((recordOffset + (3 * padding)) > data.Size()) {
+      return false;
+    }
+
+    size_t serializedSize = 0;
+    memcpy(&serializedSize, data.Data() + recordOffset + padding, sizeof(serializedSize));
+
+    entries[i].dataOffset = dataStart + recordOffset + (3 * padding);
+    entries[i].dataSize = serializedSize;
+    recordOffset += (3 * padding) + serializedSize;
+  }
+
+  SystemBufferedFileWriter writer(filename, 0);
+  if (!writer.Write(&header, sizeof(header))) {
+    return false;
+  }
+
+  if ((numAssets > 0) && !writer.Write(entries.GetData(), numAssets * sizeof(BundleEntry))) {
     return false;
   }
 
-  size_t numAssets = assets.Size();
-  fileSerializer.Serialize(&numAssets, sizeof(numAssets));
-  for (Asset& asset : assets) {
-    asset.Serialize(fileSerializer);
+  if (!writer.Write(table.GetData(), tableSize * sizeof(uint32))) {
+    return false;
   }
 
-  if (!fileSerializer.Serialize(data.Data(), data.Size())) {
+  if ((strings.Size() > 0) && !writer.Write(strings.GetData(), strings.Size())) {
+    return false;
+  }
+
+  if ((data.Size() > 0) && !writer.Write(data.Data(), data.Size())) {
     return false;
   }
 
   return true;
 }
 
-void SerializeOBJFile(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory) {
-  // Open and parse the OBJ file.
-  // Pack data into runtime format for mesh rendering.
-  // Serialize all necessary fields to a block of memory.
-  // Save an asset object in the header of the bundle.
-  // Append this serialized block of memory to main bundle memory block.
+// Parses the OBJ file and packs it into the runtime format for mesh rendering.
+static void BakeOBJModel(const FileString& filename, Model& model, ThreadPool& threadPool) {
   OBJFile objfile;
-  objfile.LoadFromFile(filename);
+  objfile.LoadFromFile(filename, threadPool);
 
-  Model model;
   Mesh& mesh = model.GetMesh();
 
-  const int32 numVerts = (int32)objfile.Verts().Size();
+  const size_t numVerts = objfile.Verts().Size();
   const float* vertData = (const float*)objfile.Verts().GetData();
 
   // NOTE: We calculate the AABB on the packed vert data from the OBJ file.
   //  This lets us use a wider optimized version of the algorithm.
   model.BoundingBox() = ComputeBoundingBox(4, vertData, numVerts * 4);
 
-  if (!objfile.AlbedoTexture().IsEmpty()) {
-    ShaderDefinition shader(4, 4, ShadingMethod::UV);
-    mesh.SetShader(shader);
+  const bool textured = !objfile.AlbedoTexture().IsEmpty();
+  ShaderDefinition shader(4, 4, textured ? ShadingMethod::UV : ShadingMethod::RGB);
+  mesh.SetShader(shader);
 
-    // NOTE: Stride changes depending on bound shader, we must check after applying.
-    const size_t stride = mesh.Stride();
+  // NOTE: Stride changes depending on bound shader, we must check after applying.
+  const size_t stride = mesh.Stride();
 
-    mesh.Resize(objfile.Verts().Size() * stride, objfile.Faces().Size());
-    const float* uvData = (const float*)objfile.UVs().GetData();
+  const Array<OBJFace>& faceList = objfile.Faces();
+  const size_t numUVs = objfile.UVs().Size();
+  const float* uvData = (numUVs > 0) ? (const float*)objfile.UVs().GetData() : nullptr;
 
-    for (int32 i = 0; i < numVerts; ++i) {
-      ZAssert(vertData[3] == 1.f);
+  const float Colors[3][3] = {
+    { 1.f, 0.f, 0.f },
+    { 0.f, 1.f, 0.f },
+    { 0.f, 0.f, 1.f }
+  };
 
-      const size_t index = i * stride;
+  // Expand every face corner into a full vertex, welding then merges the ones that come out identical.
+  Array<float> corners(faceList.Size() * 3 * stride);
+  size_t numCorners = 0;
 
-      mesh.SetData(vertData, index, 4 * sizeof(float));
-      mesh.SetData(uvData, index + 4, 2 * sizeof(float));
+  for (const OBJFace& face : faceList) {
+    const OBJFaceElement* elements = face.triangleFace;
 
-      vertData += 4;
-      uvData += 3;
+    // The runtime has no way to catch indices outside of the vertex list, drop those triangles here.
+    if ((elements[0].vertexIndex >= numVerts) || (elements[1].vertexIndex >= numVerts) || (elements[2].vertexIndex >= numVerts)) {
+      continue;
     }
-  }
-  else {
-    ShaderDefinition shader(4, 4, ShadingMethod::RGB);
-    mesh.SetShader(shader);
-
-    // NOTE: Stride changes depending on bound shader, we must check after applying.
-    const size_t stride = mesh.Stride();
 
-    mesh.Resize(objfile.Verts().Size() * stride, objfile.Faces().Size());
+    for (int32 i = 0; i < 3; ++i) {
+      const OBJFaceElement& element = elements[i];
+      float* vertex = corners.GetData() + (numCorners * stride);
+      ++numCorners;
 
-    const float R[] = { 1.f, 0.f, 0.f };
-    const float G[] = { 0.f, 1.f, 0.f };
-    const float B[] = { 0.f, 0.f, 1.f };
+      const float* position = vertData + (element.vertexIndex * 4);
+      ZAssert(position[3] == 1.f);
+      memcpy(vertex, position, 4 * sizeof(float));
 
-    for (int32 i = 0, triIndex = 0; i < numVerts; ++i) {
-      ZAssert(vertData[3] == 1.f);
-
-      const size_t index = i * stride;
-      mesh.SetData(vertData, index, 4 * sizeof(float));
-
-      switch (triIndex) {
-        case 0:
-        {
-          mesh.SetData(R, index + 4, sizeof(R));
+      if (textured) {
+        // Faces without their own UV index share the position's.
+        const size_t uvIndex = (element.uvIndex < numUVs) ? element.uvIndex : element.vertexIndex;
+        if (uvIndex < numUVs) {
+          memcpy(vertex + 4, uvData + (uvIndex * 3), 2 * sizeof(float));
         }
-        break;
-        case 1:
-        {
-          mesh.SetData(G, index + 4, sizeof(G));
-        }
-        break;
-        case 2:
-        {
-          mesh.SetData(B, index + 4, sizeof(B));
-        }
-        break;
-        default:
-          break;
       }
-
-      vertData += 4;
-      triIndex = (triIndex == 2) ? 0 : ++triIndex;
+      else {
+        memcpy(vertex + 4, Colors[element.vertexIndex % 3], sizeof(Colors[0]));
+      }
     }
   }
 
-  const int32 stride = (int32)mesh.Stride();
-  int32 indexSize = (int32)objfile.Faces().Size();
-
-  const Array<OBJFace>& faceList = objfile.Faces();
-  for (int32 triIndex = 0; triIndex < indexSize; ++triIndex) {
-    Triangle triangle(static_cast<int32>(faceList[triIndex].triangleFace[0].vertexIndex) * stride,
-      static_cast<int32>(faceList[triIndex].triangleFace[1].vertexIndex) * stride,
-      static_cast<int32>(faceList[triIndex].triangleFace[2].vertexIndex) * stride
-    );
-    mesh.SetTriangle(triangle, triIndex);
+  const size_t numTriangles = numCorners / 3;
+
+  if (numCorners > 0) {
+    Array<int32> indices;
+    Array<float> vertices;
+    WeldVertices(corners.GetData(), numCorners, stride, indices, vertices);
+    OptimizeVertexCache(indices, vertices.Size() / stride);
+    ReorderVerticesByFirstUse(indices, vertices, stride);
+
+    mesh.Resize(vertices.Size(), numTriangles);
+    mesh.SetData(vertices.GetData(), 0, vertices.Size() * sizeof(float));
+
+    for (size_t triIndex = 0; triIndex < numTriangles; ++triIndex) {
+      const int32* triangleIndices = indices.GetData() + (triIndex * 3);
+      Triangle triangle(triangleIndices[0] * (int32)stride,
+        triangleIndices[1] * (int32)stride,
+        triangleIndices[2] * (int32)stride
+      );
+      mesh.SetTriangle(triangle, triIndex);
+    }
   }
 
   // TODO: Avoid duplicating this state at some point.
   //  The OBJ to TexturePool mapping isn't set up until the texture is loaded at runtime.
   //  We could make the order more deterministic during bundling.
   mesh.AlbedoTexture() = objfile.AlbedoTexture();
+}
 
+// Serializes the model to its own block, records the asset and appends the block to the bundle memory.
+static void SerializeModelAsset(const FileString& filename, Model& model, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory) {
   MemorySerializer modelSerializer;
   model.Serialize(modelSerializer);
 
@@ -148,6 +608,12 @@ void SerializeOBJFile(const FileString& filename, Array<Asset>& bundleAssets, Me
   bundleMemory.Serialize(modelSerializer.Data(), modelSerializerSize);
 }
 
+void SerializeOBJFile(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory, ThreadPool& threadPool) {
+  Model model;
+  BakeOBJModel(filename, model, threadPool);
+  SerializeModelAsset(filename, model, bundleAssets, bundleMemory);
+}
+
 void SerializeTexturePNG(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory) {
   PNG png(filename);
   MemorySerializer pngSerializer;
@@ -182,4 +648,163 @@ void SerializeTextureJPG(const FileString& filename, Array<Asset>& bundleAssets,
   bundleMemory.Serialize(pngSerializer.Data(), pngSerializerSize);
 }
 
+
+void SerializeAtlasedOBJFiles(const Array<FileString>& objFiles, const Array<FileString>& textureFiles, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory, ThreadPool& threadPool) {
+  NamedScopedTimer(AtlasBundling);
+
+  Array<Model> models(objFiles.Size());
+  for (size_t i = 0; i < objFiles.Size(); ++i) {
+    BakeOBJModel(objFiles[i], models[i], threadPool);
+  }
+
+  // Pick out the textures that can share a page, everything else is bundled as is further down.
+  Array<AtlasTexture> packed;
+  Array<uint8> isPacked(textureFiles.Size());
+  for (size_t t = 0; t < textureFiles.Size(); ++t) {
+    const String name(textureFiles[t].GetFilename());
+
+    size_t numUsers = 0;
+    bool unitRange = true;
+    for (size_t i = 0; i < models.Size(); ++i) {
+      Mesh& mesh = models[i].GetMesh();
+      if (mesh.AlbedoTexture() == name) {
+        ++numUsers;
+        unitRange = unitRange && UVsInUnitRange(mesh);
+      }
+    }
+
+    if ((numUsers == 0) || !unitRange) {
+      continue;
+    }
+
+    AtlasTexture texture;
+    texture.source = t;
+    texture.pixels = DecodeTextureBGRA(textureFiles[t], texture.width, texture.height);
+    if (texture.pixels == nullptr) {
+      continue;
+    }
+
+    if ((texture.width > AtlasMaxTextureSize) || (texture.height > AtlasMaxTextureSize)) {
+      PlatformFree(texture.pixels);
+      continue;
+    }
+
+    // Cells stay aligned to the gutter so every texture starts on a whole texel at each baked level.
+    texture.cellWidth = RoundUpNearestMultiple(texture.width, AtlasGutter) + (AtlasGutter * 2);
+    texture.cellHeight = RoundUpNearestMultiple(texture.height, AtlasGutter) + (AtlasGutter * 2);
+    packed.PushBack(texture);
+    isPacked[t] = 1;
+  }
+
+  // Tallest first keeps the skyline flat.
+  packed.Sort([](const AtlasTexture& lhs, const AtlasTexture& rhs) {
+    return (lhs.cellHeight != rhs.cellHeight) ? (lhs.cellHeight > rhs.cellHeight) : (lhs.cellWidth > rhs.cellWidth);
+  });
+
+  Array<AtlasPage> pages;
+  for (size_t i = 0; i < packed.Size(); ++i) {
+    AtlasTexture& texture = packed[i];
+
+    size_t cellX = 0;
+    size_t cellY = 0;
+    bool placed = false;
+    for (size_t p = 0; (p < pages.Size()) && !placed; ++p) {
+      if (SkylinePlace(pages[p], texture.cellWidth, texture.cellHeight, cellX, cellY)) {
+        texture.page = p;
+        placed = true;
+      }
+    }
+
+    if (!placed) {
+      AtlasPage& page = pages.EmplaceBack();
+      page.skyline.PushBack({ 0, 0, AtlasPageSize });
+      SkylinePlace(page, texture.cellWidth, texture.cellHeight, cellX, cellY);
+      texture.page = pages.Size() - 1;
+    }
+
+    texture.x = cellX + AtlasGutter;
+    texture.y = cellY + AtlasGutter;
+  }
+
+  Array<String> pageNames(pages.Size());
+  for (size_t p = 0; p < pages.Size(); ++p) {
+    const AtlasPage& page = pages[p];
+    pageNames[p] = String::FromFormat("atlas{0}", p);
+
+    uint8* pixels = (uint8*)PlatformCalloc(page.width * page.height * 4);
+    for (size_t i = 0; i < packed.Size(); ++i) {
+      if (packed[i].page == p) {
+        BlitAtlasCell((uint32*)pixels, page.width, packed[i]);
+      }
+    }
+
+    // Unused space is left black, no texture samples it and the gutters keep the lower mips from reaching it.
+    Texture atlas(pixels, 4, page.width, page.height);
+    atlas.GenerateMips(TextureLayout::Linear, AtlasMipLevels);
+
+    MemorySerializer atlasSerializer;
+    atlas.Serialize(atlasSerializer);
+
+    bundleAssets.EmplaceBack(atlasSerializer.Size(),
+      pageNames[p],
+      String("ztex"),
+      false,
+      FileString(""),
+      AssetType::Texture);
+
+    const size_t atlasSerializerSize = atlasSerializer.Size();
+    bundleMemory.Serialize(&atlasSerializerSize, sizeof(atlasSerializerSize));
+    bundleMemory.Serialize(atlasSerializer.Data(), atlasSerializerSize);
+
+    PlatformFree(pixels);
+  }
+
+  // Move each packed texture's UVs into its rect on the page, using the same u * (width - 1) mapping the shaders do.
+  for (size_t i = 0; i < models.Size(); ++i) {
+    Mesh& mesh = models[i].GetMesh();
+    for (size_t j = 0; j < packed.Size(); ++j) {
+      const AtlasTexture& texture = packed[j];
+      if (mesh.AlbedoTexture() != textureFiles[texture.source].GetFilename()) {
+        continue;
+      }
+
+      const AtlasPage& page = pages[texture.page];
+      const float uScale = (float)(texture.width - 1) / (float)(page.width - 1);
+      const float vScale = (float)(texture.height - 1) / (float)(page.height - 1);
+      const float uOffset = (float)texture.x / (float)(page.width - 1);
+      const float vOffset = (float)texture.y / (float)(page.height - 1);
+
+      Array<float>& vertices = mesh.GetVertTable();
+      const size_t stride = mesh.Stride();
+      for (size_t v = 0; v < vertices.Size(); v += stride) {
+        vertices[v + 4] = uOffset + (vertices[v + 4] * uScale);
+        vertices[v + 5] = vOffset + (vertices[v + 5] * vScale);
+      }
+
+      mesh.AlbedoTexture() = pageNames[texture.page];
+      break;
+    }
+
+    SerializeModelAsset(objFiles[i], models[i], bundleAssets, bundleMemory);
+  }
+
+  for (size_t i = 0; i < packed.Size(); ++i) {
+    PlatformFree(packed[i].pixels);
+  }
+
+  for (size_t t = 0; t < textureFiles.Size(); ++t) {
+    if (isPacked[t]) {
+      continue;
+    }
+
+    const String extension(textureFiles[t].GetExtension());
+    if (extension == "png") {
+      SerializeTexturePNG(textureFiles[t], bundleAssets, bundleMemory);
+    }
+    else if (extension == "jpg") {
+      SerializeTextureJPG(textureFiles[t], bundleAssets, bundleMemory);
+    }
+  }
+}
+
 }
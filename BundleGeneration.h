@@ -5,15 +5,23 @@
 #include "Array.h"
 #include "Asset.h"
 #include "Serializer.h"
+#include "ThreadPool.h"
 
 namespace ZSharp {
 
 bool GenerateBundle(const FileString& filename, Array<Asset>& assets, MemorySerializer& data);
 
-void SerializeOBJFile(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory);
+void SerializeOBJFile(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory, ThreadPool& threadPool);
 
 void SerializeTexturePNG(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory);
 
 void SerializeTextureJPG(const FileString& filename, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory);
 
+/*
+Bundles the OBJ files along with the PNG/JPG textures they use, packing the small textures into shared atlas pages.
+Packed textures are replaced by "atlasN" ztex assets with a baked mip chain and the models' UVs are remapped onto them.
+Textures that are too big, unused or sampled outside of [0..1] are bundled on their own like SerializeTexturePNG/JPG.
+*/
+void SerializeAtlasedOBJFiles(const Array<FileString>& objFiles, const Array<FileString>& textureFiles, Array<Asset>& bundleAssets, MemorySerializer& bundleMemory, ThreadPool& threadPool);
+
 }
@@ -1,6 +1,7 @@
 #include "Camera.h"
 
 #include <cmath>
+#include <cstring>
 
 #include "CommonMath.h"
 #include "Constants.h"
@@ -14,6 +15,11 @@
 #define ROTATE_CAMERA_WORLD_CENTER 1
 
 namespace ZSharp {
+static_assert((int32)ClipBounds::Inside == FrustumInside, "ClipBounds must match the frustum cull kernels.");
+static_assert((int32)ClipBounds::Outside == FrustumOutside, "ClipBounds must match the frustum cull kernels.");
+static_assert((int32)ClipBounds::ClippedNear == FrustumClippedNear, "ClipBounds must match the frustum cull kernels.");
+static_assert((int32)ClipBounds::ClippedNDC == FrustumClippedNDC, "ClipBounds must match the frustum cull kernels.");
+
 ConsoleVariable<bool> BackfaceCull("BackfaceCull", true);
 
 Camera::Camera() 
@@ -41,6 +47,10 @@ Vec3 Camera::GetLook() const {
   return mLook;
 }
 
+void Camera::SetLook(const Vec3& look) {
+  mLook = look;
+}
+
 Vec3 Camera::GetUp() const {
   return mUp;
 }
@@ -105,7 +115,29 @@ void Camera::Tick() {
   unhing[2][3] = standardNearPlane;
   unhing[3][2] = -(standardFarPlane - standardNearPlane);
 
-  mPerspectiveTransform = Mat4x4::Combine(unhing, scale, uToE, translation);
+  const Mat4x4 perspectiveTransform(Mat4x4::Combine(unhing, scale, uToE, translation));
+
+  // Anything that changes the screen space result of a projection bumps the version, cached projections key off of it.
+  if ((memcmp(*perspectiveTransform, *mPerspectiveTransform, sizeof(float) * 16) != 0) || (*BackfaceCull != mBackfaceCull)) {
+    mPerspectiveTransform = perspectiveTransform;
+    mBackfaceCull = *BackfaceCull;
+    ++mProjectionVersion;
+  }
+
+  // Each plane is a combination of rows of the perspective transform, matching the regions the clipper keeps.
+  // W is negative in front of the camera which flips the usual signs of the side planes.
+  // Near keeps Z > -mStandardNearPlane before homogenizing, the rest keep -1 < X/W, Y/W < 1 and Z/W > -1 after.
+  const Mat4x4& clip = mPerspectiveTransform;
+  for (size_t i = 0; i < 4; ++i) {
+    mFrustumPlanes[0][i] = clip[2][i];
+    mFrustumPlanes[1][i] = -clip[2][i] - clip[3][i];
+    mFrustumPlanes[2][i] = -clip[0][i] - clip[3][i];
+    mFrustumPlanes[3][i] = clip[0][i] - clip[3][i];
+    mFrustumPlanes[4][i] = -clip[1][i] - clip[3][i];
+    mFrustumPlanes[5][i] = clip[1][i] - clip[3][i];
+  }
+
+  mFrustumPlanes[0][3] += mStandardNearPlane;
 }
 
 void Camera::PerspectiveProjection(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, ClipBounds clipBounds, const Mat4x4& objectTransform) {
@@ -117,29 +149,36 @@ void Camera::PerspectiveProjection(VertexBuffer& vertexBuffer, IndexBuffer& inde
     return;
   }
 
+  // Apply the perspective projection transform to all input vertices.
+  const int32 stride = vertexBuffer.GetStride();
+  Aligned_Mat4x4Transform((const float(*)[4])*(mPerspectiveTransform * objectTransform), vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride);
+
+  ProjectClipSpace(vertexBuffer, indexBuffer, clipBounds);
+}
+
+void Camera::ProjectClipSpace(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, ClipBounds clipBounds) {
+  NamedScopedTimer(ProjectClipSpace);
+
+  if (clipBounds == ClipBounds::Outside) {
+    vertexBuffer.Reset();
+    indexBuffer.Reset();
+    return;
+  }
+
   const int32 stride = vertexBuffer.GetStride();
   const float* windowTransformVec0 = *mWindowTransform[0];
   const float* windowTransformVec1 = *mWindowTransform[1];
 
+  if (*BackfaceCull) {
+    CullBackFacingPrimitives(vertexBuffer, indexBuffer);
+  }
+
   if (clipBounds == ClipBounds::Inside) {
     NamedScopedTimer(TransformDirect);
 
-    Aligned_Mat4x4Transform((const float(*)[4])*(mPerspectiveTransform * objectTransform), vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride);
-
-    if (*BackfaceCull) {
-      CullBackFacingPrimitives(vertexBuffer, indexBuffer);
-    }
-
     Aligned_HomogenizeTransformScreenSpace(vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride, windowTransformVec0, windowTransformVec1, mWidth, mHeight);
   }
   else {
-    // Apply the perspective projection transform to all input vertices.
-    Aligned_Mat4x4Transform((const float(*)[4])*(mPerspectiveTransform * objectTransform), vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride);
-
-    if (*BackfaceCull) {
-      CullBackFacingPrimitives(vertexBuffer, indexBuffer);
-    }
-
     // Clip against near plane to avoid things behind camera reappearing.
     // This clip is special because it needs to append clip data and shuffle it back to the beginning.
     // The near clip edge must be > 0, hence we negate the plane.
@@ -174,43 +213,60 @@ void Camera::PerspectiveProjection(VertexBuffer& vertexBuffer, IndexBuffer& inde
   }
 }
 
-ClipBounds Camera::ClipBoundsCheck(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const Mat4x4& objectTransform) {
-  NamedScopedTimer(ClipBoundsCheck);
+const Mat4x4& Camera::GetPerspectiveTransform() const {
+  return mPerspectiveTransform;
+}
 
-  const int32 stride = vertexBuffer.GetStride();
-  const int32 inIndexSize = indexBuffer.GetIndexSize();
+uint32 Camera::GetProjectionVersion() const {
+  return mProjectionVersion;
+}
 
-  // Apply the perspective projection transform to all input vertices.
-  Aligned_Mat4x4Transform((const float(*)[4])*(mPerspectiveTransform * objectTransform), vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride);
+bool Camera::ProjectAABB(const AABB& aabb, float screenMin[2], float screenMax[2], float& nearestDepth) const {
+  Vec3 points[8];
+  aabb.ToPoints(points);
 
-  // Clip against near plane to avoid things behind camera reappearing.
-  // This clip is special because it needs to append clip data and shuffle it back to the beginning.
-  // The near clip edge must be > 0, hence we negate the plane.
-  ClipTrianglesNearPlane(vertexBuffer, indexBuffer, -mStandardNearPlane);
+  screenMin[0] = mWidth;
+  screenMin[1] = mHeight;
+  screenMax[0] = 0.f;
+  screenMax[1] = 0.f;
+  nearestDepth = -1.f;
 
-  if (indexBuffer.GetIndexSize() == 0) {
-    return ClipBounds::Outside;
-  }
-  else if (indexBuffer.GetIndexSize() != inIndexSize) {
-    return ClipBounds::ClippedNear;
-  }
+  for (size_t i = 0; i < 8; ++i) {
+    const Vec4 clipPoint(mPerspectiveTransform * Vec4(points[i], 1.f));
 
-  // Points at this stage must have Z > 0.
-  // If Z < 0, points will re-appear in front of the camera.
-  // If Z = 0, divide by 0 occurs and trashes the results.
-  Aligned_Vec4Homogenize(vertexBuffer[0], stride, vertexBuffer.GetVertSize() * stride);
+    // W is negative and Z positive for anything in front of the camera.
+    if ((clipPoint[2] <= 0.f) || (clipPoint[3] >= 0.f)) {
+      return false;
+    }
 
-  ClipTriangles(vertexBuffer, indexBuffer);
-  
-  if (indexBuffer.GetClipLength() == 0) {
-    return ClipBounds::Outside;
-  }
-  else if (indexBuffer.GetClipLength() != inIndexSize) {
-    return ClipBounds::ClippedNDC;
-  }
-  else {
-    return ClipBounds::Inside;
+    // Same as the raster path, screen space is found by dividing through by Z.
+    const Vec3 screenPoint(mWindowTransform.ApplyTransform(Vec3(clipPoint[0] / clipPoint[2], clipPoint[1] / clipPoint[2], 1.f)));
+
+    screenMin[0] = (screenPoint[0] < screenMin[0]) ? screenPoint[0] : screenMin[0];
+    screenMin[1] = (screenPoint[1] < screenMin[1]) ? screenPoint[1] : screenMin[1];
+    screenMax[0] = (screenPoint[0] > screenMax[0]) ? screenPoint[0] : screenMax[0];
+    screenMax[1] = (screenPoint[1] > screenMax[1]) ? screenPoint[1] : screenMax[1];
+
+    // Depth is linear in W so the nearest point of the box is always one of its corners.
+    nearestDepth = (clipPoint[3] > nearestDepth) ? clipPoint[3] : nearestDepth;
   }
+
+  screenMin[0] = (screenMin[0] < 0.f) ? 0.f : screenMin[0];
+  screenMin[1] = (screenMin[1] < 0.f) ? 0.f : screenMin[1];
+  screenMax[0] = (screenMax[0] > mWidth) ? mWidth : screenMax[0];
+  screenMax[1] = (screenMax[1] > mHeight) ? mHeight : screenMax[1];
+
+  return true;
+}
+
+void Camera::ClipBoundsCheck(const float* const boxMin[3], const float* const boxMax[3], size_t count, ClipBounds* outClipBounds) const {
+  NamedScopedTimer(ClipBoundsCheck);
+
+  FrustumCullAABBImpl(mFrustumPlanes, boxMin, boxMax, count, reinterpret_cast<int32*>(outClipBounds));
+}
+
+void Camera::GetFrustumPlanes(float planes[6][4]) const {
+  memcpy(planes, mFrustumPlanes, sizeof(mFrustumPlanes));
 }
 
 void Camera::OnResize(size_t width, size_t height) {
@@ -221,6 +277,7 @@ void Camera::OnResize(size_t width, size_t height) {
   mWindowTransform *= 0.5f;
   mWidth = (float)width;
   mHeight = (float)height;
+  ++mProjectionVersion;
 }
   
 }
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "ZBaseTypes.h"
+#include "AABB.h"
 #include "IndexBuffer.h"
 #include "Mat2x3.h"
 #include "Mat4x4.h"
@@ -11,7 +12,7 @@
 
 namespace ZSharp {
 
-enum class ClipBounds {
+enum class ClipBounds : int32 {
   Inside,
   Outside,
   ClippedNear,
@@ -28,6 +29,8 @@ class Camera final : public WorldObject {
 
   Vec3 GetLook() const;
 
+  void SetLook(const Vec3& look);
+
   Vec3 GetUp() const;
 
   void RotateCamera(const Quaternion& quat);
@@ -36,7 +39,25 @@ class Camera final : public WorldObject {
 
   void PerspectiveProjection(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, ClipBounds clipBounds, const Mat4x4& objectTransform);
 
-  ClipBounds ClipBoundsCheck(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const Mat4x4& objectTransform);
+  // Finishes the projection for vertices that have already been transformed by GetPerspectiveTransform().
+  void ProjectClipSpace(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, ClipBounds clipBounds);
+
+  const Mat4x4& GetPerspectiveTransform() const;
+
+  // Changes whenever the screen space result of projecting the same vertices would change.
+  uint32 GetProjectionVersion() const;
+
+  // Classifies world space boxes against the view frustum in batches.
+  // boxMin/boxMax hold one array per component, each with count entries.
+  void ClipBoundsCheck(const float* const boxMin[3], const float* const boxMax[3], size_t count, ClipBounds* outClipBounds) const;
+
+  // World space planes, near and far first followed by the four sides.
+  // A point is inside when dot(plane.xyz, point) + plane.w > 0.
+  void GetFrustumPlanes(float planes[6][4]) const;
+
+  // Projects a world space box to a screen space rectangle along with the nearest depth the box can have.
+  // Returns false if any corner is behind the camera, the rectangle is meaningless then.
+  bool ProjectAABB(const AABB& aabb, float screenMin[2], float screenMax[2], float& nearestDepth) const;
 
   private:
   Vec3 mLook;
@@ -55,6 +76,11 @@ class Camera final : public WorldObject {
   Mat4x4 mPerspectiveTransform;
   Mat2x3 mWindowTransform;
 
+  float mFrustumPlanes[6][4];
+
+  uint32 mProjectionVersion = 0;
+  bool mBackfaceCull = false;
+
   void OnResize(size_t width, size_t height);
 };
 }
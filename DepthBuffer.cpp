@@ -24,6 +24,10 @@ DepthBuffer::~DepthBuffer() {
     PlatformAlignedFree(mData);
   }
 
+  if (mHiZ != nullptr) {
+    PlatformAlignedFree(mHiZ);
+  }
+
   OnWindowSizeChangedDelegate().Remove(Delegate<size_t, size_t>::FromMember<DepthBuffer, &DepthBuffer::OnResize>(this));
 }
 
@@ -48,12 +52,35 @@ void DepthBuffer::Clear(size_t begin, size_t size) {
   for (size_t i = nearestSize >> 2; i < (size >> 2); ++i) {
     *(mData + i) = clearValue;
   }
+
+  // Reset every coarse row that overlaps the cleared range.
+  // Neighboring ranges may share a row but they all write the same value.
+  if (size > 0) {
+    const size_t firstRow = ((begin / sizeof(float)) / mWidth) >> HiZBlockShift;
+    const size_t lastRow = ((((begin + size) / sizeof(float)) - 1) / mWidth) >> HiZBlockShift;
+
+    for (size_t i = firstRow * mHiZWidth; i < ((lastRow + 1) * mHiZWidth); ++i) {
+      mHiZ[i] = clearValue;
+    }
+  }
 }
 
 float* DepthBuffer::GetBuffer() {
   return mData;
 }
 
+float* DepthBuffer::GetHiZ() {
+  return mHiZ;
+}
+
+size_t DepthBuffer::GetHiZWidth() const {
+  return mHiZWidth;
+}
+
+size_t DepthBuffer::GetHiZHeight() const {
+  return mHiZHeight;
+}
+
 size_t DepthBuffer::GetWidth() const {
   return mWidth;
 }
@@ -71,6 +98,20 @@ void DepthBuffer::OnResize(size_t width, size_t height) {
   mHeight = height;
   const size_t totalSize = width * height * sizeof(float);
   mData = static_cast<float*>(PlatformAlignedMalloc(totalSize, PlatformAlignmentGranularity()));
+
+  if (mHiZ != nullptr) {
+    PlatformAlignedFree(mHiZ);
+  }
+
+  mHiZWidth = (width + HiZBlockSize - 1) >> HiZBlockShift;
+  mHiZHeight = (height + HiZBlockSize - 1) >> HiZBlockShift;
+  const size_t hiZSize = mHiZWidth * mHiZHeight * sizeof(float);
+  mHiZ = static_cast<float*>(PlatformAlignedMalloc(hiZSize, PlatformAlignmentGranularity()));
+
+  // Nothing is known about the depth until the first clear.
+  for (size_t i = 0; i < (mHiZWidth * mHiZHeight); ++i) {
+    mHiZ[i] = -1.f;
+  }
 }
 
 }
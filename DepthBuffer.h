@@ -20,6 +20,13 @@ class DepthBuffer final {
 
   float* GetBuffer();
 
+  // Coarse level holding the farthest depth of each HiZBlockSize x HiZBlockSize block, row-major.
+  float* GetHiZ();
+
+  size_t GetHiZWidth() const;
+
+  size_t GetHiZHeight() const;
+
   size_t GetWidth() const;
 
   size_t GetHeight() const;
@@ -29,6 +36,10 @@ class DepthBuffer final {
   size_t mWidth = 0;
   size_t mHeight = 0;
 
+  float* mHiZ = nullptr;
+  size_t mHiZWidth = 0;
+  size_t mHiZHeight = 0;
+
   void OnResize(size_t width, size_t height);
 };
 
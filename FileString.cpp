@@ -10,6 +10,10 @@
 static const char PlatformDirectorySeparator = '\\';
 static const char PlatformExtensionSeparator = '.';
 static const size_t PlatformMaxDrive = 3;
+#else
+static const char PlatformDirectorySeparator = '/';
+static const char PlatformExtensionSeparator = '.';
+static const size_t PlatformMaxDrive = 1;
 #endif
 
 // Exampe: C:\Users\kr\Desktop\ZSharp-Tools\src\Debug
@@ -176,11 +180,18 @@ void FileString::Initialize(const String& absoluteFilePath) {
     return;
   }
 
+#if PLATFORM_WINDOWS
   const char* volume = absoluteFilePath.FindFirst(':');
+  const size_t volumeLength = (volume != nullptr) ? (volume - absoluteFilePath.Str()) + 1 : 0;
+#else
+  // Absolute paths start at the root separator, the volume is always empty.
+  const char* volume = (absoluteFilePath.Str()[0] == PlatformDirectorySeparator) ? absoluteFilePath.Str() : nullptr;
+  const size_t volumeLength = 0;
+#endif
 
   if (volume != nullptr) {
     const char* str = absoluteFilePath.Str();
-    size_t length = (volume - str) + 1;
+    size_t length = volumeLength;
 
     if (length >= PlatformMaxDrive) {
       ZAssert(false);
@@ -6,11 +6,15 @@
 #include "DebugText.h"
 #include "DevConsole.h"
 #include "Logger.h"
+#include "PlatformFile.h"
 #include "PlatformTime.h"
 #include "PlatformMemory.h"
 #include "PlatformAudio.h"
+#include "PNG.h"
+#include "ProfilerThreads.h"
 #include "ScopedTimer.h"
 #include "TexturePool.h"
+#include "TraceEvents.h"
 #include "ZConfig.h"
 #include "ZString.h"
 
@@ -27,10 +31,12 @@ GameInstance::GameInstance()
   : 
     mFrontEnd(new FrontEnd()), mWorld(new World()), mRenderer(new Renderer()), 
     mThreadPool(new ThreadPool()), mExtraState(new ExtraState()),
-    mCameraReset(new ConsoleVariable<void>("CameraReset", Delegate<void>::FromMember<GameInstance, &GameInstance::ResetCamera>(this))) {
+    mCameraReset(new ConsoleVariable<void>("CameraReset", Delegate<void>::FromMember<GameInstance, &GameInstance::ResetCamera>(this))),
+    mScreenshot(new ConsoleVariable<void>("Screenshot", Delegate<void>::FromMember<GameInstance, &GameInstance::RequestScreenshot>(this))) {
   mExtraState->mPauseTransforms = false;
   mExtraState->mDrawStats = true;
   mExtraState->mVisualizeDepth = false;
+  mExtraState->mTakeScreenshot = false;
   mPlayer = new Player();
 }
 
@@ -39,6 +45,10 @@ GameInstance::~GameInstance() {
     delete mCameraReset;
   }
 
+  if (mScreenshot) {
+    delete mScreenshot;
+  }
+
   if (mFrontEnd) {
     delete mFrontEnd;
   }
@@ -96,14 +106,13 @@ void GameInstance::TickWorld() {
 
   size_t renderFrameTime = PlatformHighResClock();
 
-  {
-    NamedScopedTimer(ThreadPoolWait);
-    mThreadPool->WaitForJobs();
-  }
-
   Array<String> stats;
 
   size_t frameDeltaMs = (mExtraState->mLastFrameTime == 0) ? FRAMERATE_60HZ_MS : PlatformHighResClockDeltaMs(mExtraState->mLastFrameTime);
+  if (mExtraState->mFixedFrameDelta > 0) {
+    frameDeltaMs = mExtraState->mFixedFrameDelta;
+  }
+
   mExtraState->mLastFrameTime = PlatformHighResClock();
 
   GlobalLog->Log(LogCategory::Info, stats.EmplaceBack(String::FromFormat("Frame: {0}\n", mExtraState->mFrameCount)));
@@ -146,25 +155,33 @@ void GameInstance::TickWorld() {
   size_t physicsTickTime = Clamp(frameDeltaMs, (size_t)0, FRAMERATE_60HZ_MS);
 
   size_t startPhysics = PlatformHighResClockDeltaUs(mExtraState->mLastFrameTime);
-  mWorld->TickPhysics(physicsTickTime);
+  mWorld->TickPhysics(physicsTickTime, *mThreadPool);
   size_t endPhysics = PlatformHighResClockDeltaUs(mExtraState->mLastFrameTime);
 
   GlobalLog->Log(LogCategory::Info, stats.EmplaceBack(String::FromFormat("Physics time: {0}us\n", endPhysics - startPhysics)));
 
+  // Debug transforms and overlap correction move models even with physics off, culling needs the bounds either way.
+  mWorld->RefitModelHierarchy();
+
   mPlayer->Tick();
 
-  mRenderer->RenderNextFrame(*mWorld, *mPlayer->ViewCamera());
+  // The buffer clears queued after the last present overlap everything above, only block once we need to draw.
+  {
+    NamedScopedTimer(ThreadPoolWait);
+    mThreadPool->Wait(mExtraState->mFrameClearJob);
+    mThreadPool->Wait(mExtraState->mDepthClearJob);
+  }
+
+  mRenderer->RenderNextFrame(*mWorld, *mPlayer->ViewCamera(), *mThreadPool);
 
-  size_t remainingTriangles = 0;
-  for (IndexBuffer& indexBuffer : mWorld->GetIndexBuffers()) {
-    if (indexBuffer.WasClipped()) {
-      remainingTriangles += indexBuffer.GetClipLength() / 3;
-    }
-    else {
-      remainingTriangles += indexBuffer.GetIndexSize() / 3;
-    }
+  // Grab the frame before the stats and console are drawn over it.
+  if (mExtraState->mTakeScreenshot) {
+    mExtraState->mTakeScreenshot = false;
+    SaveScreenshot();
   }
 
+  const size_t remainingTriangles = mRenderer->GetRenderedTriangles();
+
   float cullRatio = (float)remainingTriangles / (float)numTriangles;
   GlobalLog->Log(LogCategory::Info, stats.EmplaceBack(String::FromFormat("Post Clip/Cull Triangles: {0}, {1:4}%\n", remainingTriangles, cullRatio)));
 
@@ -239,11 +256,35 @@ void GameInstance::ResetCamera() {
   }
 }
 
+void GameInstance::RequestScreenshot() {
+  mExtraState->mTakeScreenshot = true;
+}
+
+void GameInstance::SaveScreenshot() {
+  NamedScopedTimer(SaveScreenshot);
+
+  FileString path(PlatformGetWorkingDirectory());
+
+  String filename(PlatformGetExecutableName());
+  filename.Appendf("_screenshot_{0}.png", mExtraState->mFrameCount);
+  path.SetFilename(filename);
+
+  if (PNG::Save(path, mRenderer->GetFrameBuffer())) {
+    GlobalLog->Log(LogCategory::Info, String::FromFormat("Saved screenshot {0}\n", path.GetAbsolutePath()));
+  }
+  else {
+    GlobalLog->Log(LogCategory::Warning, String::FromFormat("Could not write screenshot {0}\n", path.GetAbsolutePath()));
+  }
+}
+
 void GameInstance::PauseTransforms() {
   mExtraState->mPauseTransforms = !(mExtraState->mPauseTransforms);
 }
 
 void GameInstance::Initialize(bool skipTitleScreen) {
+  ProfilerRegisterMainThread();
+  TraceSetThreadName("Main Thread");
+
   if (!skipTitleScreen) {
     LoadWorld();
   }
@@ -263,6 +304,9 @@ void GameInstance::Tick() {
 
     TickWorld();
   }
+
+  ScopedTimerEndFrame();
+  TraceEndFrame();
 }
 
 void GameInstance::TickAudio() {
@@ -298,8 +342,10 @@ void GameInstance::RunBackgroundJobs() {
   ParallelRange depthBufferClear = ParallelRange::FromMember<GameInstance, &GameInstance::FastClearDepthBuffer>(this);
   size_t size = mRenderer->GetFrameBuffer().GetWidth() * mRenderer->GetFrameBuffer().GetHeight();
 
-  mThreadPool->Execute(frameBufferClear, mRenderer->GetFrameBuffer().GetBuffer(), size);
-  mThreadPool->Execute(depthBufferClear, mRenderer->GetDepthBuffer().GetBuffer(), size);
+  mExtraState->mFrameClearJob = mThreadPool->CreateJob(frameBufferClear, mRenderer->GetFrameBuffer().GetBuffer(), size);
+  mExtraState->mDepthClearJob = mThreadPool->CreateJob(depthBufferClear, mRenderer->GetDepthBuffer().GetBuffer(), size);
+  mThreadPool->Submit(mExtraState->mFrameClearJob);
+  mThreadPool->Submit(mExtraState->mDepthClearJob);
 }
 
 void GameInstance::WaitForBackgroundJobs() {
@@ -307,6 +353,27 @@ void GameInstance::WaitForBackgroundJobs() {
   mThreadPool->WaitForJobs();
 }
 
+Framebuffer& GameInstance::GetFrameBuffer() {
+  return mRenderer->GetFrameBuffer();
+}
+
+void GameInstance::SetFixedFrameDelta(size_t frameDeltaMs) {
+  mExtraState->mFixedFrameDelta = frameDeltaMs;
+}
+
+Vec3 GameInstance::GetCameraPosition() {
+  return mPlayer->Position();
+}
+
+void GameInstance::SetCameraPose(const Vec3& position, const Vec3& look) {
+  mPlayer->Position() = position;
+  mPlayer->ViewCamera()->SetLook(look);
+}
+
+void GameInstance::SetDrawStats(bool drawStats) {
+  mExtraState->mDrawStats = drawStats;
+}
+
 void GameInstance::OnKeyDown(uint8 key) {
   switch (key) {
   case 'p':
@@ -373,22 +440,30 @@ void InitializeGlobals() {
   if (PlatformSupportsSIMDLanes(SIMDLaneWidth::Eight)) {
     RGBShaderImpl = &Unaligned_Shader_RGB_AVX;
     UVShaderImpl = &Unaligned_Shader_UV_AVX;
+    UVBilinearShaderImpl = &Unaligned_Shader_UV_Bilinear_AVX;
+    UVTrilinearShaderImpl = &Unaligned_Shader_UV_Trilinear_AVX;
     CalculateAABBImpl = &Unaligned_AABB_AVX;
+    FrustumCullAABBImpl = &Unaligned_FrustumCullAABB_AVX;
     DrawDebugTextImpl = &Unaligned_DrawDebugText_AVX;
     DepthBufferVisualizeImpl = &Aligned_DepthBufferVisualize_AVX;
     BlendBuffersImpl = &Unaligned_BlendBuffers_AVX;
     BilinearScaleImageImpl = &Unaligned_BilinearScaleImage_AVX;
     GenerateMipLevelImpl = &Unaligned_GenerateMipLevel_AVX;
+    PNGUnfilterRowImpl = &Unaligned_PNGUnfilterRow_AVX;
   }
   else if (PlatformSupportsSIMDLanes(SIMDLaneWidth::Four)) {
     RGBShaderImpl = &Unaligned_Shader_RGB_SSE;
     UVShaderImpl = &Unaligned_Shader_UV_SSE;
+    UVBilinearShaderImpl = &Unaligned_Shader_UV_Bilinear_SSE;
+    UVTrilinearShaderImpl = &Unaligned_Shader_UV_Trilinear_SSE;
     CalculateAABBImpl = &Unaligned_AABB_SSE;
+    FrustumCullAABBImpl = &Unaligned_FrustumCullAABB_SSE;
     DrawDebugTextImpl = &Unaligned_DrawDebugText_SSE;
     DepthBufferVisualizeImpl = &Aligned_DepthBufferVisualize_SSE;
     BlendBuffersImpl = &Unaligned_BlendBuffers_SSE;
     BilinearScaleImageImpl = &Unaligned_BilinearScaleImage_SSE;
     GenerateMipLevelImpl = &Unaligned_GenerateMipLevel_SSE;
+    PNGUnfilterRowImpl = &Unaligned_PNGUnfilterRow_SSE;
   }
   else {
     ZAssert(false);
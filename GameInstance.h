@@ -40,6 +40,17 @@ class GameInstance final {
 
   void WaitForBackgroundJobs();
 
+  Framebuffer& GetFrameBuffer();
+
+  // Replaces the measured frame delta so that runs can be repeated exactly, 0 goes back to measuring it.
+  void SetFixedFrameDelta(size_t frameDeltaMs);
+
+  Vec3 GetCameraPosition();
+
+  void SetCameraPose(const Vec3& position, const Vec3& look);
+
+  void SetDrawStats(bool drawStats);
+
   private:
   FrontEnd* mFrontEnd = nullptr;
   Player* mPlayer = nullptr;
@@ -50,15 +61,20 @@ class GameInstance final {
   struct ExtraState {
     size_t mLastFrameTime = 0;
     size_t mLastAudioTime = 0;
+    size_t mFixedFrameDelta = 0;
 
     int64 mFrameCount = 0;
     int64 mRotationAmount = 0;
     int64 mRotationSpeed = 4;
 
+    JobHandle mFrameClearJob;
+    JobHandle mDepthClearJob;
+
     struct {
       bool mPauseTransforms : 1;
       bool mDrawStats : 1;
       bool mVisualizeDepth : 1;
+      bool mTakeScreenshot : 1;
     };
   };
 
@@ -66,6 +82,8 @@ class GameInstance final {
 
   ConsoleVariable<void>* mCameraReset = nullptr;
 
+  ConsoleVariable<void>* mScreenshot = nullptr;
+
   void PauseTransforms();
 
   void LoadWorld();
@@ -87,6 +105,10 @@ class GameInstance final {
   void FastClearDepthBuffer(Span<uint8> data);
 
   void ResetCamera();
+
+  void RequestScreenshot();
+
+  void SaveScreenshot();
 };
 
 }
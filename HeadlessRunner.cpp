@@ -0,0 +1,207 @@
+#include "HeadlessRunner.h"
+
+#include "Constants.h"
+#include "Logger.h"
+#include "PlatformApplication.h"
+#include "PlatformFile.h"
+#include "PlatformMisc.h"
+#include "PlatformTime.h"
+#include "PNG.h"
+#include "ZConfig.h"
+#include "ZFile.h"
+#include "ZString.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace ZSharp {
+
+static FileString HeadlessFilePath(const String& suffix) {
+  FileString path(PlatformGetWorkingDirectory());
+
+  String filename(PlatformGetExecutableName());
+  filename.Append(suffix);
+
+  path.SetFilename(filename);
+  return path;
+}
+
+HeadlessRunner::HeadlessRunner(GameInstance& gameInstance)
+  : mGameInstance(gameInstance) {
+}
+
+int32 HeadlessRunner::Run(const HeadlessOptions& options) {
+  ZConfig* config = GlobalConfig;
+
+  const size_t width = (options.width > 0) ? options.width : config->GetViewportWidth().Value();
+  const size_t height = (options.height > 0) ? options.height : config->GetViewportHeight().Value();
+  config->SetViewportWidth(width);
+  config->SetViewportHeight(height);
+  OnWindowSizeChangedDelegate().Broadcast(width, height);
+
+  // Anything that depends on wall clock time would make the frames differ between runs.
+  mGameInstance.SetFixedFrameDelta(FRAMERATE_60HZ_MS);
+  mGameInstance.SetDrawStats(false);
+  mGameInstance.Initialize(false);
+
+  mPath.Clear();
+  if (!options.cameraPath.IsEmpty() && !LoadCameraPath(options.cameraPath)) {
+    GlobalLog->Log(LogCategory::Error, String::FromFormat("Could not load camera path {0}\n", options.cameraPath.GetAbsolutePath()));
+    return -1;
+  }
+
+  if (mPath.IsEmpty()) {
+    BuildOrbitPath(mGameInstance.GetCameraPosition());
+  }
+
+  Array<size_t> frameTimes(options.frames);
+
+  for (size_t frame = 0; frame < options.frames; ++frame) {
+    ApplyCameraPath(frame, options.frames);
+
+    const size_t frameStart = PlatformHighResClock();
+    mGameInstance.Tick();
+    frameTimes[frame] = PlatformHighResClockDeltaUs(frameStart);
+
+    for (size_t captureFrame : options.captureFrames) {
+      if (captureFrame == frame) {
+        CaptureFrame(frame);
+        break;
+      }
+    }
+
+    // Same order as the windowed loop, the buffer clears overlap the start of the next frame.
+    mGameInstance.RunBackgroundJobs();
+  }
+
+  mGameInstance.WaitForBackgroundJobs();
+
+  WriteTimings(frameTimes);
+  return 0;
+}
+
+bool HeadlessRunner::LoadCameraPath(const FileString& cameraPath) {
+  BufferedFileReader reader(cameraPath);
+  if (!reader.IsOpen()) {
+    return false;
+  }
+
+  while (reader.ReadLine() > 0) {
+    const char* line = reader.GetBuffer();
+    if ((line[0] == '#') || (line[0] == '\r') || (line[0] == '\n')) {
+      continue;
+    }
+
+    float values[6];
+    char* end = const_cast<char*>(line);
+    for (size_t i = 0; i < 6; ++i) {
+      const char* start = end;
+      values[i] = strtof(start, &end);
+      if (start == end) {
+        return false;
+      }
+    }
+
+    CameraKey& key = mPath.EmplaceBack();
+    key.position = Vec3(values[0], values[1], values[2]);
+    key.look = Vec3(values[3], values[4], values[5]);
+    key.look.Normalize();
+  }
+
+  return !mPath.IsEmpty();
+}
+
+void HeadlessRunner::BuildOrbitPath(const Vec3& start) {
+  const size_t numKeys = 16;
+
+  float radius = sqrtf((start[0] * start[0]) + (start[2] * start[2]));
+  if (radius < 1.f) {
+    radius = 10.f;
+  }
+
+  const float startAngle = atan2f(start[0], start[2]);
+
+  for (size_t i = 0; i <= numKeys; ++i) {
+    const float angle = startAngle + ((2.f * PI) * ((float)i / (float)numKeys));
+
+    CameraKey& key = mPath.EmplaceBack();
+    key.position = Vec3(sinf(angle) * radius, start[1], cosf(angle) * radius);
+    key.look = Vec3(-key.position[0], 0.f, -key.position[2]);
+    key.look.Normalize();
+  }
+}
+
+void HeadlessRunner::ApplyCameraPath(size_t frame, size_t numFrames) {
+  if ((mPath.Size() == 1) || (numFrames <= 1)) {
+    mGameInstance.SetCameraPose(mPath[0].position, mPath[0].look);
+    return;
+  }
+
+  const float t = ((float)frame / (float)(numFrames - 1)) * (float)(mPath.Size() - 1);
+  size_t index = (size_t)t;
+  index = (index >= (mPath.Size() - 1)) ? (mPath.Size() - 2) : index;
+  const float blend = t - (float)index;
+
+  const CameraKey& from = mPath[index];
+  const CameraKey& to = mPath[index + 1];
+
+  Vec3 position(from.position + ((to.position - from.position) * blend));
+  Vec3 look(from.look + ((to.look - from.look) * blend));
+  look.Normalize();
+
+  mGameInstance.SetCameraPose(position, look);
+}
+
+void HeadlessRunner::CaptureFrame(size_t frame) {
+  Framebuffer& framebuffer = mGameInstance.GetFrameBuffer();
+  const FileString path(HeadlessFilePath(String::FromFormat("_frame_{0}.png", frame)));
+
+  if (!PNG::Save(path, framebuffer)) {
+    GlobalLog->Log(LogCategory::Warning, String::FromFormat("Could not write frame {0}\n", frame));
+  }
+}
+
+void HeadlessRunner::WriteTimings(const Array<size_t>& frameTimes) {
+  const size_t numFrames = frameTimes.Size();
+  if (numFrames == 0) {
+    return;
+  }
+
+  String csv("frame,us\n");
+  for (size_t i = 0; i < numFrames; ++i) {
+    csv.Appendf("{0},{1}\n", i, frameTimes[i]);
+  }
+
+  SystemBufferedFileWriter writer(HeadlessFilePath("_headless.csv"), 0);
+  if (writer.IsOpen()) {
+    writer.Write(csv.Str(), csv.Length());
+  }
+
+  Array<size_t> sorted(frameTimes);
+  for (size_t i = 1; i < numFrames; ++i) {
+    const size_t value = sorted[i];
+
+    size_t j = i;
+    for (; (j > 0) && (sorted[j - 1] > value); --j) {
+      sorted[j] = sorted[j - 1];
+    }
+
+    sorted[j] = value;
+  }
+
+  size_t total = 0;
+  for (size_t frameTime : sorted) {
+    total += frameTime;
+  }
+
+  GlobalLog->Log(LogCategory::Perf, String::FromFormat("Headless run: frames={0}, avg={1} us, min={2} us, p50={3} us, p95={4} us, p99={5} us, max={6} us\n",
+    numFrames,
+    total / numFrames,
+    sorted[0],
+    sorted[(numFrames - 1) / 2],
+    sorted[((numFrames - 1) * 95) / 100],
+    sorted[((numFrames - 1) * 99) / 100],
+    sorted[numFrames - 1]));
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "Array.h"
+#include "FileString.h"
+#include "GameInstance.h"
+#include "Vec3.h"
+
+namespace ZSharp {
+
+struct HeadlessOptions {
+  size_t frames = 300;
+  size_t width = 0; // 0 keeps the configured viewport size.
+  size_t height = 0;
+  Array<size_t> captureFrames;
+
+  // One key per line: "px py pz lx ly lz", keys are spread evenly over the run.
+  // When empty the camera orbits the origin from where the player starts.
+  FileString cameraPath;
+};
+
+/*
+Drives the game without a window or present.
+Every frame runs with a fixed time step and a camera pose taken from the path, so two runs over the same data render the same frames.
+Frame times go to <executable>_headless.csv, captured frames to <executable>_frame_<N>.png.
+*/
+class HeadlessRunner final {
+  public:
+
+  HeadlessRunner(GameInstance& gameInstance);
+
+  HeadlessRunner(const HeadlessRunner&) = delete;
+  void operator=(const HeadlessRunner&) = delete;
+
+  int32 Run(const HeadlessOptions& options);
+
+  private:
+  struct CameraKey {
+    Vec3 position;
+    Vec3 look;
+  };
+
+  GameInstance& mGameInstance;
+  Array<CameraKey> mPath;
+
+  bool LoadCameraPath(const FileString& cameraPath);
+
+  void BuildOrbitPath(const Vec3& start);
+
+  void ApplyCameraPath(size_t frame, size_t numFrames);
+
+  void CaptureFrame(size_t frame);
+
+  void WriteTimings(const Array<size_t>& frameTimes);
+};
+
+}
@@ -32,10 +32,13 @@
 #include "ZAssert.h"
 #include "PlatformIntrinsics.h"
 
+#include <stdint.h>
 #include <string.h>
 #include <algorithm>
 
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
 #include <immintrin.h>
 
 #define JPGD_USE_SSE2 1
@@ -73,7 +76,7 @@ enum JPEG_MARKER {
 
 enum JPEG_SUBSAMPLING { JPGD_GRAYSCALE = 0, JPGD_YH1V1, JPGD_YH2V1, JPGD_YH1V2, JPGD_YH2V2 };
 
-#define JPGD_SIMD_ALIGN(type, name) __declspec(align(16)) type name
+#define JPGD_SIMD_ALIGN(type, name) alignas(16) type name
 
 #define BITS_INV_ACC 4
 #define SHIFT_INV_ROW 16 - BITS_INV_ACC
@@ -1634,6 +1637,9 @@ void jpeg_decoder::init(jpeg_decoder_stream* pStream, uint32 flags) {
 
   __cpuid(cpu_info, 7);
   m_simd = ((cpu_info[1] >> 5) & 1U) != 0U ? simd_version::AVX2 : m_simd;
+#elif defined(__GNUC__)
+  m_simd = __builtin_cpu_supports("sse2") ? simd_version::SSE2 : simd_version::NONE;
+  m_simd = __builtin_cpu_supports("avx2") ? simd_version::AVX2 : m_simd;
 #else
   m_simd = simd_version::SSE2;
 #endif
@@ -10,6 +10,8 @@
 
 #ifdef PLATFORM_WINDOWS
 #define JPGD_NORETURN __declspec(noreturn) 
+#else
+#define JPGD_NORETURN [[noreturn]]
 #endif
 
 #define JPGD_HUFF_TREE_MAX_LENGTH 512
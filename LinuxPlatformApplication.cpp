@@ -0,0 +1,112 @@
+#ifdef PLATFORM_LINUX
+
+#include "LinuxPlatformApplication.h"
+
+#include "CommandLineParser.h"
+#include "ZString.h"
+
+#include <cstdlib>
+
+LinuxPlatformApplication* GlobalApplication = nullptr;
+
+namespace ZSharp {
+
+BroadcastDelegate<size_t, size_t>& OnWindowSizeChangedDelegate() {
+  static BroadcastDelegate<size_t, size_t> instance;
+  return instance;
+}
+
+PlatformApplication* GetApplication() {
+  return GlobalApplication;
+}
+
+}
+
+int LinuxPlatformApplication::Run(int argc, const char** argv) {
+  ReadCommandLine(argc, argv);
+
+  ZSharp::HeadlessRunner runner(*mGameInstance);
+  return runner.Run(mHeadlessOptions);
+}
+
+void LinuxPlatformApplication::ApplyCursor(ZSharp::AppCursor cursor) {
+  mCurrentCursor = cursor;
+}
+
+void LinuxPlatformApplication::Shutdown() {
+  // HeadlessRunner stops on its own once the last frame is done.
+}
+
+LinuxPlatformApplication::LinuxPlatformApplication() {
+  GlobalApplication = this;
+
+  ZSharp::InitializeGlobals();
+  mGameInstance = new ZSharp::GameInstance();
+}
+
+LinuxPlatformApplication::~LinuxPlatformApplication() {
+  if (mGameInstance) {
+    delete mGameInstance;
+  }
+
+  ZSharp::FreeGlobals();
+
+  GlobalApplication = nullptr;
+}
+
+void LinuxPlatformApplication::ReadCommandLine(int argc, const char** argv) {
+  if (argc > 1) {
+    ZSharp::Array<ZSharp::CLICommand> commands;
+
+    ZSharp::Array<ZSharp::String> globalOptions;
+    globalOptions.EmplaceBack("headless");
+    globalOptions.EmplaceBack("frames");
+    globalOptions.EmplaceBack("width");
+    globalOptions.EmplaceBack("height");
+    globalOptions.EmplaceBack("capture");
+    globalOptions.EmplaceBack("camerapath");
+
+    ZSharp::CLIParser cliParser(commands, globalOptions);
+    cliParser.Evaluate(argc, argv, true);
+
+    // e.g. -frames=600 -capture=0,300 -camerapath=flythrough.txt
+    if (cliParser.WasPassed("frames")) {
+      mHeadlessOptions.frames = (size_t)atoi(cliParser.GetValue("frames").Str());
+    }
+
+    if (cliParser.WasPassed("width") && cliParser.WasPassed("height")) {
+      mHeadlessOptions.width = (size_t)atoi(cliParser.GetValue("width").Str());
+      mHeadlessOptions.height = (size_t)atoi(cliParser.GetValue("height").Str());
+    }
+
+    if (cliParser.WasPassed("capture")) {
+      const ZSharp::String captureList(cliParser.GetValue("capture"));
+      const char* next = captureList.Str();
+
+      while (*next != '\0') {
+        char* end = nullptr;
+        const long frame = strtol(next, &end, 10);
+        if (end == next) {
+          break;
+        }
+
+        mHeadlessOptions.captureFrames.PushBack((size_t)frame);
+        next = (*end == ',') ? (end + 1) : end;
+      }
+    }
+
+    if (cliParser.WasPassed("camerapath")) {
+      // FileString only understands absolute paths, resolve anything relative against the working directory.
+      char resolvedPath[PLATFORM_MAX_PATH];
+      const ZSharp::String cameraPath(cliParser.GetValue("camerapath"));
+      if (realpath(cameraPath.Str(), resolvedPath) != nullptr) {
+        mHeadlessOptions.cameraPath = ZSharp::String(resolvedPath);
+      }
+      else {
+        mHeadlessOptions.cameraPath = cameraPath;
+      }
+    }
+  }
+}
+
+#endif
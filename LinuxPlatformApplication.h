@@ -0,0 +1,36 @@
+#pragma once
+
+#ifdef PLATFORM_LINUX
+
+#include "GameInstance.h"
+#include "HeadlessRunner.h"
+#include "ZBaseTypes.h"
+#include "PlatformApplication.h"
+
+/*
+There is no window backend on Linux, every run goes through HeadlessRunner.
+Takes the same -frames, -width/-height, -capture and -camerapath options as a headless Win32 run.
+*/
+class LinuxPlatformApplication : public ZSharp::PlatformApplication {
+  public:
+
+  LinuxPlatformApplication();
+
+  ~LinuxPlatformApplication();
+
+  int Run(int argc, const char** argv);
+
+  virtual void ApplyCursor(ZSharp::AppCursor cursor) override;
+
+  virtual void Shutdown() override;
+
+  private:
+  ZSharp::GameInstance* mGameInstance = nullptr;
+  ZSharp::HeadlessOptions mHeadlessOptions;
+
+  void ReadCommandLine(int argc, const char** argv);
+};
+
+extern LinuxPlatformApplication* GlobalApplication;
+
+#endif
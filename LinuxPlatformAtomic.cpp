@@ -0,0 +1,80 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformAtomic.h"
+
+#if HW_PLATFORM_X86
+#include <emmintrin.h>
+#endif
+
+namespace ZSharp {
+
+// Backs off the spin loops below, a plain retry anywhere the hint isn't available.
+static void SpinPause() {
+#if HW_PLATFORM_X86
+  _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+int32 PlatformAtomicIncrement(volatile int32* value) {
+  return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+
+int32 PlatformAtomicDecrement(volatile int32* value) {
+  return __atomic_sub_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+
+int32 PlatformAtomicAdd(volatile int32* value, int32 amount) {
+  return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+}
+
+int64 PlatformAtomicCompareExchange(volatile int64* value, int64 exchange, int64 comparand) {
+  // On failure the current value is written back into comparand, either way it ends up holding the initial value.
+  __atomic_compare_exchange_n(value, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  return comparand;
+}
+
+void PlatformMemoryFence() {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+PlatformSemaphore::PlatformSemaphore(uint32 maxCount)
+  : mMaxCount(maxCount) {
+
+}
+
+void PlatformSemaphore::Increment() {
+  bool aquired = false;
+  while (!aquired) {
+    int32 value = __atomic_add_fetch(&mCount, 1, __ATOMIC_SEQ_CST);
+    if (value > (int32)mMaxCount) {
+      __atomic_sub_fetch(&mCount, 1, __ATOMIC_SEQ_CST);
+      SpinPause();
+    }
+    else {
+      aquired = true;
+    }
+  }
+}
+
+int32 PlatformSemaphore::Decrement() {
+  return __atomic_sub_fetch(&mCount, 1, __ATOMIC_SEQ_CST);
+}
+
+void PlatformMutex::Aquire() {
+  // Same test and test-and-set loop as Win32, spin on plain loads until the lock looks free.
+  while (__atomic_exchange_n(&mCount, (uint8)1, __ATOMIC_ACQUIRE) == 1) {
+    while (mCount) {
+      SpinPause();
+    }
+  }
+}
+
+void PlatformMutex::Release() {
+  __atomic_store_n(&mCount, (uint8)0, __ATOMIC_RELEASE);
+}
+
+}
+
+#endif
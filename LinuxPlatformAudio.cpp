@@ -0,0 +1,33 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformAudio.h"
+
+namespace ZSharp {
+
+// No audio backend on Linux yet, callers skip playback when no device comes back.
+
+PlatformAudioDevice* PlatformInitializeAudioDevice(size_t samplesPerSecond,
+  size_t numChannels,
+  size_t durationMillisecond) {
+  (void)samplesPerSecond;
+  (void)numChannels;
+  (void)durationMillisecond;
+  return nullptr;
+}
+
+size_t PlatformPlayAudio(PlatformAudioDevice* device, float* pcmSignal, size_t offset, size_t endTrack, size_t milliseconds) {
+  (void)device;
+  (void)pcmSignal;
+  (void)offset;
+  (void)endTrack;
+  (void)milliseconds;
+  return 0;
+}
+
+void PlatformReleaseAudioDevice(PlatformAudioDevice* device) {
+  (void)device;
+}
+
+}
+
+#endif
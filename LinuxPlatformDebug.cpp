@@ -0,0 +1,57 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformDebug.h"
+
+#include "ZAssert.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace ZSharp {
+
+bool PlatformHasConsole() {
+  return isatty(STDOUT_FILENO) == 1;
+}
+
+void PlatformWriteConsole(const String& msg) {
+  const char* data = msg.Str();
+  size_t remaining = msg.Length();
+
+  while (remaining > 0) {
+    ssize_t numWritten = write(STDOUT_FILENO, data, remaining);
+    if (numWritten < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      PlatformDebugPrintLastError();
+      return;
+    }
+
+    data += numWritten;
+    remaining -= (size_t)numWritten;
+  }
+}
+
+void PlatformDebugPrintLastError() {
+#ifndef NDEBUG
+  const char* errorString = strerror(errno);
+  PlatformDebugPrint(errorString);
+  PlatformDebugPrint("\n");
+#endif
+}
+
+void PlatformDebugPrint(const char* message) {
+#ifndef NDEBUG
+  // There is no debugger output channel, stderr is the closest equivalent.
+  ssize_t result = write(STDERR_FILENO, message, strlen(message));
+  (void)result;
+#else
+  (void)message;
+#endif
+}
+
+}
+
+#endif
@@ -0,0 +1,368 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformFile.h"
+#include "PlatformDebug.h"
+
+#include "ZString.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ZSharp {
+
+struct PlatformFileHandle {
+  int fileHandle = -1;
+};
+
+struct PlatformMemoryMappedFileHandle {
+  PlatformFileHandle* genericFileHandle = nullptr;
+  void* mappedData = nullptr;
+  size_t mappedSize = 0;
+};
+
+struct PlatformFileSearchHandle {
+  glob_t searchResults{};
+  size_t currentIndex = 0;
+};
+
+int SetFlags(size_t inFlags) {
+  const bool isReading = inFlags & static_cast<size_t>(FileFlags::READ);
+  bool isWriting = inFlags & static_cast<size_t>(FileFlags::WRITE);
+  const bool isAppending = inFlags & static_cast<size_t>(FileFlags::APPEND);
+
+  if (isAppending) {
+    isWriting = true;
+  }
+
+  int linuxFlags = O_CLOEXEC;
+
+  if (isReading && isWriting) {
+    linuxFlags |= O_RDWR;
+  }
+  else if (isWriting) {
+    linuxFlags |= O_WRONLY;
+  }
+  else {
+    linuxFlags |= O_RDONLY;
+  }
+
+  // Same as Win32, writing truncates and appending creates the file if it is missing.
+  if (isWriting) {
+    linuxFlags |= isAppending ? (O_APPEND | O_CREAT) : (O_CREAT | O_TRUNC);
+  }
+
+  return linuxFlags;
+}
+
+int SetMemoryMappedFlags(size_t inFlags) {
+  int linuxFlags = 0;
+
+  if (inFlags & static_cast<size_t>(FileFlags::READ)) {
+    linuxFlags |= PROT_READ;
+  }
+
+  if (inFlags & static_cast<size_t>(FileFlags::WRITE)) {
+    linuxFlags |= PROT_WRITE;
+  }
+
+  return linuxFlags;
+}
+
+static FileString FileStringFromPath(const char* path, size_t length) {
+  String strPath(path, 0, length);
+  FileString receivedPath(strPath);
+  return receivedPath;
+}
+
+// The user's home folder, falls back to the root directory when HOME is unset.
+static const char* HomeDirectory() {
+  const char* home = getenv("HOME");
+  return (home != nullptr) ? home : "/";
+}
+
+PlatformFileHandle* PlatformOpenFile(const FileString& filename, size_t flags) {
+  int fileHandle = -1;
+
+  do {
+    fileHandle = open(filename.GetAbsolutePath().Str(), SetFlags(flags), 0644);
+  } while ((fileHandle < 0) && (errno == EINTR));
+
+  if (fileHandle >= 0) {
+    PlatformFileHandle* outHandle = new PlatformFileHandle;
+    outHandle->fileHandle = fileHandle;
+    return outHandle;
+  }
+  else {
+    return nullptr;
+  }
+}
+
+void PlatformCloseFile(PlatformFileHandle* handle) {
+  close(handle->fileHandle);
+  delete handle;
+}
+
+size_t PlatformReadFile(PlatformFileHandle* handle, void* buffer, size_t length) {
+  uint8* data = (uint8*)buffer;
+  size_t bytesRead = 0;
+
+  // read() may come back short for large requests, keep going until EOF like ReadFile.
+  while (bytesRead < length) {
+    ssize_t result = read(handle->fileHandle, data + bytesRead, length - bytesRead);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return 0;
+    }
+    else if (result == 0) {
+      break;
+    }
+
+    bytesRead += (size_t)result;
+  }
+
+  return bytesRead;
+}
+
+size_t PlatformWriteFile(PlatformFileHandle* handle, const void* buffer, size_t length) {
+  const uint8* data = (const uint8*)buffer;
+  size_t bytesWritten = 0;
+
+  while (bytesWritten < length) {
+    ssize_t result = write(handle->fileHandle, data + bytesWritten, length - bytesWritten);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return 0;
+    }
+
+    bytesWritten += (size_t)result;
+  }
+
+  return bytesWritten;
+}
+
+bool PlatformFileFlush(PlatformFileHandle* handle) {
+  return fsync(handle->fileHandle) == 0;
+}
+
+void* PlatformOpenMemoryMapFile(PlatformFileHandle* handle, size_t flags, PlatformMemoryMappedFileHandle*& outMemoryMappedFileHandle, size_t size) {
+  if (handle == nullptr) {
+    return nullptr;
+  }
+
+  const bool isWriting = flags & static_cast<size_t>(FileFlags::WRITE);
+
+  // A size of zero maps the whole file, same as MapViewOfFile.
+  if (size == 0) {
+    size = PlatformGetFileSize(handle);
+  }
+
+  // CreateFileMapping grows the file to the mapped size, do the same so writes past the old end don't fault.
+  if (isWriting && (PlatformGetFileSize(handle) < size)) {
+    if (ftruncate(handle->fileHandle, (off_t)size) != 0) {
+      PlatformDebugPrintLastError();
+      PlatformCloseFile(handle);
+      return nullptr;
+    }
+  }
+
+  void* fileBuffer = mmap(nullptr, size, SetMemoryMappedFlags(flags), MAP_SHARED, handle->fileHandle, 0);
+  if (fileBuffer == MAP_FAILED) {
+    PlatformDebugPrintLastError();
+    PlatformCloseFile(handle);
+    return nullptr;
+  }
+
+  // Assets are read front to back once, let the kernel read ahead aggressively.
+  // The advice values are not flags, each one needs its own call.
+  if (!isWriting) {
+    madvise(fileBuffer, size, MADV_SEQUENTIAL);
+    madvise(fileBuffer, size, MADV_WILLNEED);
+  }
+
+  outMemoryMappedFileHandle = new PlatformMemoryMappedFileHandle;
+  outMemoryMappedFileHandle->genericFileHandle = handle;
+  outMemoryMappedFileHandle->mappedData = fileBuffer;
+  outMemoryMappedFileHandle->mappedSize = size;
+
+  return fileBuffer;
+}
+
+void PlatformCloseMemoryMapFile(PlatformMemoryMappedFileHandle* memoryMappedFileHandle) {
+  munmap(memoryMappedFileHandle->mappedData, memoryMappedFileHandle->mappedSize);
+  delete memoryMappedFileHandle;
+}
+
+bool PlatformFlushMemoryMapFile(PlatformMemoryMappedFileHandle* memoryMappedFileHandle) {
+  return msync(memoryMappedFileHandle->mappedData, memoryMappedFileHandle->mappedSize, MS_SYNC) == 0;
+}
+
+size_t PlatformGetFileSize(PlatformFileHandle* handle) {
+  struct stat info;
+  if (fstat(handle->fileHandle, &info) == 0) {
+    return static_cast<size_t>(info.st_size);
+  }
+  else {
+    PlatformDebugPrintLastError();
+    return 0;
+  }
+}
+
+bool PlatformFileExists(const FileString& filename) {
+  struct stat info;
+  return (stat(filename.GetAbsolutePath().Str(), &info) == 0) && S_ISREG(info.st_mode);
+}
+
+bool PlatformUpdateFileAccessTime(PlatformFileHandle* handle) {
+  timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_NOW;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+
+  if (futimens(handle->fileHandle, times) != 0) {
+    PlatformDebugPrintLastError();
+    return false;
+  }
+
+  return true;
+}
+
+bool PlatformUpdateFileModificationTime(PlatformFileHandle* handle) {
+  timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_OMIT;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_NOW;
+
+  return futimens(handle->fileHandle, times) == 0;
+}
+
+String PlatformGetExecutableName() {
+  char path[PLATFORM_MAX_PATH];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length > 0) {
+    // Executables usually have no extension, FileString would read the name as a directory.
+    path[length] = '\0';
+    const char* name = strrchr(path, '/');
+    name = (name != nullptr) ? (name + 1) : path;
+    String strName(name, 0, strlen(name));
+    return strName;
+  }
+  else {
+    PlatformDebugPrintLastError();
+    return String("");
+  }
+}
+
+FileString PlatformGetUserDesktopPath() {
+  String path(HomeDirectory());
+  path.Append("/Desktop");
+  return FileString(path);
+}
+
+FileString PlatformGetUserDataDirectory() {
+  // XDG base directory spec, the closest match to the roaming AppData folder.
+  const char* dataHome = getenv("XDG_DATA_HOME");
+  if ((dataHome != nullptr) && (dataHome[0] == '/')) {
+    return FileString(String(dataHome));
+  }
+
+  String path(HomeDirectory());
+  path.Append("/.local/share");
+  return FileString(path);
+}
+
+FileString PlatformGetExecutableDirectory() {
+  char path[PLATFORM_MAX_PATH];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length > 0) {
+    // Cut the executable name off here for the same reason as above.
+    path[length] = '\0';
+    const char* name = strrchr(path, '/');
+    const size_t directoryLength = (name != nullptr) ? (name - path) : (size_t)length;
+    FileString receivedPath(FileStringFromPath(path, directoryLength));
+    return receivedPath;
+  }
+  else {
+    PlatformDebugPrintLastError();
+    return FileString("");
+  }
+}
+
+FileString PlatformGetWorkingDirectory() {
+  char path[PLATFORM_MAX_PATH];
+  if (getcwd(path, sizeof(path)) != nullptr) {
+    FileString receivedPath(FileStringFromPath(path, strlen(path)));
+    receivedPath.SetFilename("");
+    return receivedPath;
+  }
+  else {
+    PlatformDebugPrintLastError();
+    return FileString("");
+  }
+}
+
+PlatformFileSearchHandle* PlatformBeginFileSearch(const FileString& filter) {
+  PlatformFileSearchHandle* searchHandle = new PlatformFileSearchHandle;
+
+  if (glob(filter.GetAbsolutePath().Str(), 0, nullptr, &searchHandle->searchResults) != 0) {
+    globfree(&searchHandle->searchResults);
+    delete searchHandle;
+    return nullptr;
+  }
+
+  return searchHandle;
+}
+
+bool PlatformNextFileInSearch(PlatformFileSearchHandle* handle) {
+  if (handle == nullptr) {
+    return false;
+  }
+
+  if ((handle->currentIndex + 1) >= handle->searchResults.gl_pathc) {
+    return false;
+  }
+
+  ++handle->currentIndex;
+  return true;
+}
+
+void PlatformStopFileSearch(PlatformFileSearchHandle* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+
+  globfree(&handle->searchResults);
+  delete handle;
+}
+
+String PlatformGetNameFromSearchHandle(PlatformFileSearchHandle* handle) {
+  String filename;
+
+  if (handle == nullptr || handle->currentIndex >= handle->searchResults.gl_pathc) {
+    return filename;
+  }
+
+  // glob hands back full paths, FindFirstFile only gives the name.
+  const char* path = handle->searchResults.gl_pathv[handle->currentIndex];
+  const char* name = strrchr(path, '/');
+  filename = (name != nullptr) ? (name + 1) : path;
+
+  return filename;
+}
+
+}
+
+#endif
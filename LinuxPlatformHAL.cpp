@@ -0,0 +1,102 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformHAL.h"
+#include "ZAssert.h"
+#include "ZBaseTypes.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+namespace ZSharp {
+
+// Reads a single integer out of a sysfs file, returns false if the file is missing.
+static bool ReadSysfsValue(const char* path, int64& value) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+
+  long long result = 0;
+  bool success = fscanf(file, "%lld", &result) == 1;
+  fclose(file);
+
+  value = (int64)result;
+  return success;
+}
+
+size_t PlatformGetNumPhysicalCores() {
+  static size_t numProcessors = 0;
+
+  // The count of processors will never change during a programs execution.
+  if (numProcessors > 0) {
+    return numProcessors;
+  }
+
+  const size_t numLogical = PlatformGetNumLogicalCores();
+
+  // A physical core is a unique (package, core) pair, SMT siblings report the same pair.
+  static constexpr size_t MaxTrackedCores = 1024;
+  int64 packages[MaxTrackedCores];
+  int64 cores[MaxTrackedCores];
+  size_t totalProcessors = 0;
+
+  for (size_t cpu = 0; (cpu < numLogical) && (totalProcessors < MaxTrackedCores); ++cpu) {
+    char path[128];
+    int64 package = 0;
+    int64 core = 0;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%zu/topology/physical_package_id", cpu);
+    if (!ReadSysfsValue(path, package)) {
+      continue;
+    }
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%zu/topology/core_id", cpu);
+    if (!ReadSysfsValue(path, core)) {
+      continue;
+    }
+
+    bool seen = false;
+    for (size_t i = 0; i < totalProcessors; ++i) {
+      if ((packages[i] == package) && (cores[i] == core)) {
+        seen = true;
+        break;
+      }
+    }
+
+    if (!seen) {
+      packages[totalProcessors] = package;
+      cores[totalProcessors] = core;
+      ++totalProcessors;
+    }
+  }
+
+  // Containers and some VMs hide the topology, assume no SMT in that case.
+  numProcessors = (totalProcessors > 0) ? totalProcessors : numLogical;
+  ZAssert(numProcessors > 0);
+  return numProcessors;
+}
+
+size_t PlatformGetNumLogicalCores() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return (count > 0) ? static_cast<size_t>(count) : 1;
+}
+
+size_t PlatformGetTotalMemory() {
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long pageSize = sysconf(_SC_PAGESIZE);
+
+  if (pages > 0 && pageSize > 0) {
+    return static_cast<size_t>(pages) * static_cast<size_t>(pageSize);
+  }
+  else {
+    return 0;
+  }
+}
+
+size_t PlatformGetPageSize() {
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+}
+
+#endif
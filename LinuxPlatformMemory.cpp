@@ -0,0 +1,121 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformMemory.h"
+
+#include "ZAssert.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+void* operator new(size_t size) noexcept(false) {
+  void* memory = ZSharp::PlatformMalloc(size);
+  ZAssert(memory != nullptr);
+  return memory;
+}
+
+void* operator new[](size_t size) noexcept(false) {
+  void* memory = ZSharp::PlatformMalloc(size);
+  ZAssert(memory != nullptr);
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  ZAssert(memory != nullptr);
+  ZSharp::PlatformFree(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  ZAssert(memory != nullptr);
+  ZSharp::PlatformFree(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept {
+  (void)size;
+  ZAssert(memory != nullptr);
+  ZSharp::PlatformFree(memory);
+}
+
+void operator delete[](void* memory, size_t size) noexcept {
+  (void)size;
+  ZAssert(memory != nullptr);
+  ZSharp::PlatformFree(memory);
+}
+
+namespace ZSharp {
+
+// Frame sized buffers are streamed through every frame, backing them with 2MB pages cuts most of their TLB misses.
+static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+void* PlatformMalloc(size_t length) {
+  return malloc(length);
+}
+
+void* PlatformCalloc(size_t length) {
+  return calloc(1, length);
+}
+
+void* PlatformReAlloc(void* memory, size_t length) {
+  return realloc(memory, length);
+}
+
+void PlatformFree(void* memory) {
+  free(memory);
+}
+
+void* PlatformAlignedMalloc(size_t length, size_t alignment) {
+  const bool useHugePages = length >= HugePageSize;
+  if (useHugePages) {
+    alignment = HugePageSize;
+  }
+
+  if (alignment < sizeof(void*)) {
+    alignment = sizeof(void*);
+  }
+
+  void* memory = nullptr;
+  if (posix_memalign(&memory, alignment, length) != 0) {
+    return nullptr;
+  }
+
+  if (useHugePages) {
+    // Only a hint, transparent huge pages may be disabled and the call fails harmlessly.
+    madvise(memory, length & ~(HugePageSize - 1), MADV_HUGEPAGE);
+  }
+
+  return memory;
+}
+
+void* PlatformAlignedCalloc(size_t length, size_t alignment) {
+  void* memory = PlatformAlignedMalloc(length, alignment);
+  if (memory != nullptr) {
+    memset(memory, 0, length);
+  }
+
+  return memory;
+}
+
+void* PlatformAlignedReAlloc(void* memory, size_t length, size_t alignment) {
+  if (memory == nullptr) {
+    return PlatformAlignedMalloc(length, alignment);
+  }
+
+  // There is no aligned realloc, move the data into a new block instead.
+  void* newMemory = PlatformAlignedMalloc(length, alignment);
+  if (newMemory != nullptr) {
+    const size_t oldLength = malloc_usable_size(memory);
+    memcpy(newMemory, memory, (oldLength < length) ? oldLength : length);
+    free(memory);
+  }
+
+  return newMemory;
+}
+
+void PlatformAlignedFree(void* alignedMemory) {
+  free(alignedMemory);
+}
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformMisc.h"
+
+#include "ZAssert.h"
+
+#include <pwd.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace ZSharp {
+String PlatformGetBuildType() {
+  String buildType(BUILD_TYPE, 0, sizeof(BUILD_TYPE) - 1);
+  return buildType;
+}
+
+String PlatformGetToolchain() {
+#ifdef __INTEL_LLVM_COMPILER
+  String toolchain(__VERSION__);
+#elif __clang__
+  String toolchain("Clang " __clang_version__);
+#elif __GNUC__
+  String toolchain("GCC " __VERSION__);
+#else
+  String toolchain("Unknown");
+#endif
+  return toolchain;
+}
+
+String PlatformGetUsername() {
+  struct passwd entry;
+  struct passwd* result = nullptr;
+  char buffer[1024];
+
+  if ((getpwuid_r(getuid(), &entry, buffer, sizeof(buffer), &result) == 0) && (result != nullptr)) {
+    String username(entry.pw_name);
+    return username;
+  }
+  else {
+    return String("");
+  }
+}
+
+String PlatformGetMachineName() {
+  char buffer[256] = {};
+
+  if (gethostname(buffer, sizeof(buffer) - 1) == 0) {
+    String name(buffer, 0, strlen(buffer));
+    return name;
+  }
+  else {
+    return String("");
+  }
+}
+
+Array<String> PlatformEnumDisplayInfo() {
+  // Linux builds only run headless, there are no displays to report.
+  Array<String> monitors;
+  return monitors;
+}
+
+}
+
+#endif
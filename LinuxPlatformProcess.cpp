@@ -0,0 +1,30 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformProcess.h"
+
+#include <dlfcn.h>
+
+namespace ZSharp {
+
+void* PlatformLoadLibrary(const String& library) {
+  return dlopen(library.Str(), RTLD_NOW | RTLD_LOCAL);
+}
+
+void PlatformUnloadLibrary(void* handle) {
+  if (handle) {
+    dlclose(handle);
+  }
+}
+
+void* PlatformGetLibraryFunc(void* handle, const String& funcName) {
+  if (handle) {
+    return dlsym(handle, funcName.Str());
+  }
+  else {
+    return nullptr;
+  }
+}
+
+}
+
+#endif
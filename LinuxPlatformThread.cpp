@@ -0,0 +1,220 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformThread.h"
+
+#include "Array.h"
+#include "PlatformHAL.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if HW_PLATFORM_X86
+#include <emmintrin.h>
+#endif
+
+namespace ZSharp {
+
+struct PlatformThread {
+  pthread_t threadHandle;
+  PlatformThreadFunction threadFunction;
+  void* threadData;
+};
+
+// Manual reset event on a single futex word, 0 = cleared and 1 = signaled.
+// Signaled monitors never enter the kernel on wait, only sleepers pay for a syscall.
+struct PlatformMonitor {
+  volatile int32 state;
+};
+
+static void* ThreadEntry(void* arg) {
+  PlatformThread* thread = (PlatformThread*)arg;
+  thread->threadFunction(thread->threadData);
+  return nullptr;
+}
+
+static long FutexWait(volatile int32* address, int32 expected) {
+  return syscall(SYS_futex, (int32*)address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static long FutexWakeAll(volatile int32* address) {
+  return syscall(SYS_futex, (int32*)address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Logical processors that are the first SMT sibling of their core, in ascending order.
+static void GetPrimarySiblings(Array<size_t>& processors) {
+  const size_t numLogical = PlatformGetNumLogicalCores();
+
+  for (size_t cpu = 0; cpu < numLogical; ++cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%zu/topology/thread_siblings_list", cpu);
+
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+      continue;
+    }
+
+    unsigned long firstSibling = 0;
+    bool valid = fscanf(file, "%lu", &firstSibling) == 1;
+    fclose(file);
+
+    if (valid && (firstSibling == cpu)) {
+      processors.PushBack(cpu);
+    }
+  }
+}
+
+static void PinThread(PlatformThread* thread, size_t processor) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(processor, &set);
+  pthread_setaffinity_np(thread->threadHandle, sizeof(set), &set);
+}
+
+PlatformThread* PlatformCreateThread(PlatformThreadFunction threadFunction, void* threadData) {
+  PlatformThread* thread = new PlatformThread;
+  thread->threadFunction = threadFunction;
+  thread->threadData = threadData;
+
+  if (pthread_create(&thread->threadHandle, nullptr, &ThreadEntry, thread) != 0) {
+    delete thread;
+    return nullptr;
+  }
+
+  return thread;
+}
+
+void PlatformPinThreadsToProcessors(PlatformThread** threads, size_t numThreads, bool logical) {
+  if (threads == nullptr) {
+    return;
+  }
+
+  if (logical) {
+    if (numThreads > PlatformGetNumLogicalCores()) {
+      return;
+    }
+
+    for (size_t i = 0; i < numThreads; ++i) {
+      PinThread(threads[i], i);
+    }
+  }
+  else {
+    if (numThreads > PlatformGetNumPhysicalCores()) {
+      return;
+    }
+
+    // Sibling numbering is not always interleaved on Linux, ask sysfs instead of assuming every other processor.
+    Array<size_t> processors;
+    GetPrimarySiblings(processors);
+
+    for (size_t i = 0; i < numThreads; ++i) {
+      PinThread(threads[i], (i < processors.Size()) ? processors[i] : (i * 2));
+    }
+  }
+}
+
+bool PlatformSetThreadName(PlatformThread* thread, const String& name) {
+  if (!thread) {
+    return false;
+  }
+
+  // The kernel limit is 16 bytes including the terminator.
+  char shortName[16] = {};
+  const size_t length = (name.Length() < (sizeof(shortName) - 1)) ? name.Length() : (sizeof(shortName) - 1);
+  memcpy(shortName, name.Str(), length);
+
+  return pthread_setname_np(thread->threadHandle, shortName) == 0;
+}
+
+void PlatformJoinThread(PlatformThread* thread) {
+  if (thread == nullptr) {
+    return;
+  }
+
+  pthread_join(thread->threadHandle, nullptr);
+
+  delete thread;
+}
+
+void PlatformJoinThreadPool(PlatformThread** threads, size_t numThreads) {
+  if (threads == nullptr) {
+    return;
+  }
+
+  for (size_t i = 0; i < numThreads; ++i) {
+    pthread_join(threads[i]->threadHandle, nullptr);
+  }
+
+  for (size_t i = 0; i < numThreads; ++i) {
+    delete threads[i];
+  }
+}
+
+PlatformMonitor* PlatformCreateMonitor(bool signaled) {
+  PlatformMonitor* monitor = new PlatformMonitor;
+  monitor->state = signaled ? 1 : 0;
+  return monitor;
+}
+
+void PlatformWaitMonitor(PlatformMonitor* monitor) {
+  if (monitor == nullptr) {
+    return;
+  }
+
+  while (__atomic_load_n(&monitor->state, __ATOMIC_ACQUIRE) == 0) {
+    // Returns straight away if the monitor was signaled after the load above.
+    FutexWait(&monitor->state, 0);
+  }
+}
+
+void PlatformWaitMonitors(PlatformMonitor** monitors, size_t count) {
+  if (monitors == nullptr) {
+    return;
+  }
+
+  // Monitors stay signaled until cleared, waiting on each in turn is the same as waiting for all of them.
+  for (size_t i = 0; i < count; ++i) {
+    PlatformWaitMonitor(monitors[i]);
+  }
+}
+
+void PlatformSignalMonitor(PlatformMonitor* monitor) {
+  if (monitor != nullptr) {
+    if (__atomic_exchange_n(&monitor->state, 1, __ATOMIC_RELEASE) == 0) {
+      FutexWakeAll(&monitor->state);
+    }
+  }
+}
+
+void PlatformClearMonitor(PlatformMonitor* monitor) {
+  if (monitor != nullptr) {
+    __atomic_store_n(&monitor->state, 0, __ATOMIC_RELEASE);
+  }
+}
+
+void PlatformDestroyMonitor(PlatformMonitor* monitor) {
+  if (monitor == nullptr) {
+    return;
+  }
+
+  delete monitor;
+}
+
+void PlatformYieldThread() {
+  sched_yield();
+}
+
+void PlatformBusySpin() {
+#if HW_PLATFORM_X86
+  _mm_pause();
+#endif
+}
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifdef PLATFORM_LINUX
+
+#include "PlatformTime.h"
+
+#include "PlatformDebug.h"
+
+#include <time.h>
+
+namespace ZSharp {
+
+// CLOCK_MONOTONIC goes through the vDSO so it costs about as much as rdtsc without having to know the TSC frequency.
+// Ticks are nanoseconds.
+
+size_t PlatformHighResClock() {
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+    PlatformDebugPrintLastError();
+    return 0;
+  }
+
+  return ((size_t)now.tv_sec * 1000000000ULL) + (size_t)now.tv_nsec;
+}
+
+size_t PlatformHighResClockDeltaS(size_t startingTime) {
+  return (PlatformHighResClock() - startingTime) / 1000000000ULL;
+}
+
+size_t PlatformHighResClockDeltaMs(size_t startingTime) {
+  return (PlatformHighResClock() - startingTime) / 1000000ULL;
+}
+
+size_t PlatformHighResClockDeltaUs(size_t startingTime) {
+  return (PlatformHighResClock() - startingTime) / 1000ULL;
+}
+
+String PlatformSystemTimeFormat() {
+  char timeString[64];
+
+  String result;
+
+  time_t now = time(nullptr);
+  tm localTime;
+  if (localtime_r(&now, &localTime) == nullptr) {
+    return result;
+  }
+
+  // Same layout as Win32, local time followed by the short date.
+  size_t length = strftime(timeString, sizeof(timeString), "%X %x", &localTime);
+  if (length > 0) {
+    result.Append(timeString, 0, length);
+  }
+
+  return result;
+}
+
+}
+
+#endif
@@ -1,29 +1,25 @@
 #include "Logger.h"
 
 #include "ZAssert.h"
+#include "PlatformAtomic.h"
 #include "PlatformDebug.h"
 #include "PlatformFile.h"
 #include "PlatformHAL.h"
 #include "PlatformIntrinsics.h"
+#include "PlatformMemory.h"
 #include "PlatformMisc.h"
+#include "PlatformThread.h"
 #include "PlatformTime.h"
 #include "Span.h"
 
+#include <cstring>
+
 namespace ZSharp {
 
 Logger* GlobalLog = nullptr;
 
-Logger::Logger() : mLog(LogFilePath(), 0) {
-  LogPrologue();
-}
-
-Logger::~Logger() {
-}
-
-void Logger::Log(LogCategory category, const String& message) {
-  String logMessage;
-
-  bool logStdOutput = true;
+static Span<const char> CategoryTag(LogCategory category, bool& logStdOutput) {
+  logStdOutput = true;
   const char* logCategory = "";
   size_t categoryLength = 0;
 
@@ -67,24 +63,81 @@ void Logger::Log(LogCategory category, const String& message) {
       break;
   }
 
-  Span<const char> categoryString(logCategory, categoryLength);
-  logMessage.Appendf("{0} [{1}] {2}", categoryString, PlatformSystemTimeFormat(), message);
+  return Span<const char>(logCategory, categoryLength);
+}
+
+Logger::Logger() : mLog(LogFilePath(), 0) {
+  mRing = (LogRecord*)PlatformAlignedMalloc(RingCapacity * sizeof(LogRecord), 64);
+  for (size_t i = 0; i < RingCapacity; ++i) {
+    mRing[i].sequence = (int64)i;
+  }
+
+  mStartTime = PlatformHighResClock();
+  mWakeMonitor = PlatformCreateMonitor(false);
+  mThread = PlatformCreateThread(&LogThreadMain, this);
+  PlatformSetThreadName(mThread, "Log Thread");
 
-  // Log to 3 locations:
-  //  1) Console (if process contains one)
-  //  2) Debugger window
-  //  3) Log file
+  LogPrologue();
+}
+
+Logger::~Logger() {
+  mRunning = 0;
+  PlatformMemoryFence();
+  PlatformSignalMonitor(mWakeMonitor);
+  PlatformJoinThread(mThread);
+  PlatformDestroyMonitor(mWakeMonitor);
+
+  mLog.Flush();
+
+  PlatformAlignedFree(mRing);
+}
 
-  if (logStdOutput && PlatformHasConsole()) {
-    PlatformWriteConsole(message);
+void Logger::Log(LogCategory category, const String& message) {
+  const size_t timestamp = PlatformHighResClock();
+
+  int64 position = 0;
+  LogRecord& record = AcquireRecord(position);
+  record.timestamp = timestamp;
+  record.category = category;
+
+  const size_t length = message.Length();
+  record.length = length;
+
+  if (length <= InlineTextSize) {
+    record.type = RecordType::Text;
+    memcpy(record.text, message.Str(), length);
+  }
+  else {
+    // The logging thread frees this once it has been written out.
+    record.type = RecordType::HeapText;
+    record.heapText = (char*)PlatformMalloc(length);
+    memcpy(record.heapText, message.Str(), length);
   }
 
-  PlatformDebugPrint(message.Str());
+  PublishRecord(record, position);
+}
+
+void Logger::LogDeferred(LogCategory category, const char* format, const char* name, size_t value) {
+  const size_t timestamp = PlatformHighResClock();
+
+  int64 position = 0;
+  LogRecord& record = AcquireRecord(position);
+  record.timestamp = timestamp;
+  record.category = category;
+  record.type = RecordType::Deferred;
+  record.format = format;
+  record.name = name;
+  record.value = value;
+
+  PublishRecord(record, position);
+}
 
-  const size_t logLength = logMessage.Length();
-  if (!IsExcessiveSize(logLength)) {
-    mLog.Write(logMessage.Str(), logLength);
-    mLogSize += logLength;
+void Logger::Flush() {
+  const int64 target = mEnqueuePosition;
+  WakeLogThread();
+
+  while (mDequeuePosition < target) {
+    PlatformYieldThread();
   }
 }
 
@@ -113,6 +166,7 @@ bool Logger::IsExcessiveSize(const size_t nextMessageLength) const {
 void Logger::LogPrologue() {
   String prologue;
   prologue.Append("\n\n==========Begin Sys Info==========\n");
+  prologue.Appendf("Start: {0}\n", PlatformSystemTimeFormat());
   prologue.Appendf("CPU: ID={0}, Brand={1}\n",
     PlatformCPUVendor(), 
     PlatformCPUBrand());
@@ -141,4 +195,160 @@ void Logger::LogPrologue() {
   Log(LogCategory::System, prologue);
 }
 
+int32 Logger::LogThreadMain(void* data) {
+  Logger* logger = (Logger*)data;
+  logger->RunLogThread();
+  return 0;
+}
+
+/*
+Bounded MPSC ring, each slot carries a sequence number.
+A slot is free for position P when its sequence is P, and holds a record for position P when it is P + 1.
+Producers race on the enqueue position with a compare exchange, the single consumer owns the dequeue position.
+*/
+Logger::LogRecord& Logger::AcquireRecord(int64& position) {
+  int64 current = mEnqueuePosition;
+
+  while (true) {
+    LogRecord& record = mRing[current & (RingCapacity - 1)];
+    const int64 difference = record.sequence - current;
+
+    if (difference == 0) {
+      const int64 previous = PlatformAtomicCompareExchange(&mEnqueuePosition, current + 1, current);
+      if (previous == current) {
+        position = current;
+        return record;
+      }
+
+      current = previous;
+    }
+    else {
+      if (difference < 0) {
+        // The ring is full, let the logging thread catch up.
+        WakeLogThread();
+        PlatformYieldThread();
+      }
+
+      current = mEnqueuePosition;
+    }
+  }
+}
+
+void Logger::PublishRecord(LogRecord& record, int64 position) {
+  PlatformMemoryFence();
+  record.sequence = position + 1;
+  WakeLogThread();
+}
+
+void Logger::WakeLogThread() {
+  // Pairs with the fence in RunLogThread(), either we see it sleeping or it sees our record.
+  PlatformMemoryFence();
+  if ((mSleeping == 1) && (PlatformAtomicCompareExchange(&mSleeping, 0, 1) == 1)) {
+    PlatformSignalMonitor(mWakeMonitor);
+  }
+}
+
+bool Logger::HasPendingRecords() const {
+  return mEnqueuePosition != mDequeuePosition;
+}
+
+size_t Logger::WriteRecords() {
+  String batch;
+  String timeFormat;
+
+  size_t count = 0;
+  for (; count < MaxBatchRecords; ++count) {
+    const int64 position = mDequeuePosition;
+    LogRecord& record = mRing[position & (RingCapacity - 1)];
+
+    if (record.sequence != (position + 1)) {
+      break;
+    }
+
+    PlatformMemoryFence();
+
+    String message;
+    switch (record.type) {
+      case RecordType::Text:
+        message.Append(record.text, 0, record.length);
+        break;
+      case RecordType::HeapText:
+        message.Append(record.heapText, 0, record.length);
+        PlatformFree(record.heapText);
+        break;
+      case RecordType::Deferred:
+        message.Appendf(record.format, record.name, record.value);
+        break;
+    }
+
+    // Read the age first so the time since start is always the larger of the two.
+    const size_t age = PlatformHighResClockDeltaUs(record.timestamp);
+    const size_t elapsed = PlatformHighResClockDeltaUs(mStartTime) - age;
+    const LogCategory category = record.category;
+
+    // Hand the slot back to the producers for the next lap around the ring.
+    PlatformMemoryFence();
+    record.sequence = position + (int64)RingCapacity;
+    mDequeuePosition = position + 1;
+
+    if (timeFormat.IsEmpty()) {
+      timeFormat = PlatformSystemTimeFormat();
+    }
+
+    bool logStdOutput = true;
+    Span<const char> categoryString(CategoryTag(category, logStdOutput));
+    batch.Appendf("{0} [{1}] [{2} us] {3}", categoryString, timeFormat, elapsed, message);
+
+    // Log to 3 locations:
+    //  1) Console (if process contains one)
+    //  2) Debugger window
+    //  3) Log file, batched below
+
+    if (logStdOutput && PlatformHasConsole()) {
+      PlatformWriteConsole(message);
+    }
+
+    PlatformDebugPrint(message.Str());
+  }
+
+  const size_t batchLength = batch.Length();
+  if ((batchLength > 0) && !IsExcessiveSize(batchLength)) {
+    mLog.Write(batch.Str(), batchLength);
+    mLogSize += batchLength;
+  }
+
+  return count;
+}
+
+void Logger::RunLogThread() {
+  while (true) {
+    if (WriteRecords() > 0) {
+      continue;
+    }
+
+    if (mRunning == 0) {
+      if (!HasPendingRecords()) {
+        break;
+      }
+
+      // A producer claimed a slot but has not filled it in yet.
+      PlatformYieldThread();
+      continue;
+    }
+
+    PlatformClearMonitor(mWakeMonitor);
+    mSleeping = 1;
+
+    // Check again after going to sleep, otherwise we could miss a record published right before.
+    PlatformMemoryFence();
+    if (HasPendingRecords() || (mRunning == 0)) {
+      mSleeping = 0;
+      PlatformYieldThread();
+      continue;
+    }
+
+    PlatformWaitMonitor(mWakeMonitor);
+  }
+}
+
 }
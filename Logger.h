@@ -15,25 +15,95 @@ enum class LogCategory {
   System
 };
 
+struct PlatformThread;
+struct PlatformMonitor;
+
+/*
+Callers only copy a fixed size record into a lock-free ring, any thread can log.
+A dedicated logging thread formats the records and writes them out in batches.
+If the ring fills up callers yield until the logging thread frees a slot, nothing is dropped.
+*/
 class Logger final {
   public:
 
-  void Log(LogCategory category, const String& message);
-
   Logger();
 
+  Logger(const Logger&) = delete;
+  void operator=(const Logger&) = delete;
+
+  // Writes out everything still in the ring before returning.
   ~Logger();
 
+  void Log(LogCategory category, const String& message);
+
+  // Formatting is left to the logging thread, the same as String::FromFormat(format, name, value).
+  // format and name are only referenced so they must outlive the logger, typically string literals.
+  void LogDeferred(LogCategory category, const char* format, const char* name, size_t value);
+
+  // Blocks until everything logged before the call has been written out.
+  void Flush();
+
   private:
+  static constexpr size_t RingCapacity = 4096;
+  static constexpr size_t RecordSize = 256;
+  static constexpr size_t InlineTextSize = 192;
+  static constexpr size_t MaxBatchRecords = 256;
+
+  enum class RecordType : int32 {
+    Text,
+    HeapText,
+    Deferred
+  };
+
+  struct LogRecord {
+    volatile int64 sequence;
+    size_t timestamp;
+    LogCategory category;
+    RecordType type;
+    const char* format;
+    const char* name;
+    size_t value;
+    char* heapText;
+    size_t length;
+    char text[InlineTextSize];
+  };
+
+  static_assert(sizeof(LogRecord) == RecordSize, "Log records must fill their slot exactly.");
+
+  LogRecord* mRing = nullptr;
+
+  // Producers and the consumer each get their own cache line.
+  alignas(64) volatile int64 mEnqueuePosition = 0;
+  alignas(64) volatile int64 mDequeuePosition = 0;
+  volatile int64 mSleeping = 0;
+  volatile int32 mRunning = 1;
+
+  PlatformThread* mThread = nullptr;
+  PlatformMonitor* mWakeMonitor = nullptr;
+
+  SystemBufferedFileWriter mLog;
+  size_t mLogSize = 0;
+  size_t mStartTime = 0;
 
   static FileString LogFilePath();
 
+  static int32 LogThreadMain(void* data);
+
   bool IsExcessiveSize(const size_t nextMessageLength) const;
 
   void LogPrologue();
 
-  SystemBufferedFileWriter mLog;
-  size_t mLogSize = 0;
+  LogRecord& AcquireRecord(int64& position);
+
+  void PublishRecord(LogRecord& record, int64 position);
+
+  void WakeLogThread();
+
+  bool HasPendingRecords() const;
+
+  size_t WriteRecords();
+
+  void RunLogThread();
 };
 
 extern Logger* GlobalLog;
@@ -36,6 +36,17 @@ void Model::FillBuffers(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer) co
   vertexBuffer.CopyInputData(mMesh.GetVertTable().GetData(), 0, (int32)(mMesh.GetVertTable().Size()));
 }
 
+void Model::FillBuffers(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const Mat4x4& transform) const {
+  NamedScopedTimer(FillBuffersTransformed);
+
+  if (mMesh.GetTriangleFaceTable().Size() == 0 || mMesh.GetVertTable().Size() == 0) {
+    return;
+  }
+
+  indexBuffer.CopyInputData(reinterpret_cast<const int32*>(mMesh.GetTriangleFaceTable().GetData()), 0, (int32)(mMesh.GetTriangleFaceTable().Size() * TRI_VERTS));
+  vertexBuffer.TransformInputData(mMesh.GetVertTable().GetData(), 0, (int32)(mMesh.GetVertTable().Size()), transform);
+}
+
 void Model::Serialize(ISerializer& serializer) {
   mBoundingBox.Serialize(serializer);
   mMesh.Serialize(serializer);
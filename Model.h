@@ -25,6 +25,9 @@ class Model final : public PhysicsObject, public ISerializable {
 
   void FillBuffers(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer) const;
 
+  // Fills the buffers with the vertices already transformed, saves a separate pass over the copied data.
+  void FillBuffers(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const Mat4x4& transform) const;
+
   virtual void Serialize(ISerializer& serializer) override;
 
   virtual void Deserialize(IDeserializer& deserializer) override;
@@ -2,16 +2,270 @@
 
 #include "ZAssert.h"
 #include "Logger.h"
+#include "PlatformIntrinsics.h"
+#include "ThreadPool.h"
 #include "ZFile.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 namespace ZSharp {
+
+// Files are split into pieces of about this size, small enough that a few land on every worker.
+static constexpr size_t OBJChunkSize = 1024 * 1024;
+
+// Every entry is exact in a float, 5^10 still fits in the 24 bit significand.
+static const float PowersOfTen[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+// Longest token handed to strtof, anything longer than this is a mantissa we already truncated.
+static constexpr size_t MaxFloatToken = 64;
+
+static bool IsDigit(char c) {
+  return (uint8)(c - '0') < 10;
+}
+
+static const char* SkipSpaces(const char* cursor, const char* end) {
+  while ((cursor < end) && ((*cursor == ' ') || (*cursor == '\t'))) {
+    ++cursor;
+  }
+
+  return cursor;
+}
+
+/*
+Reads a decimal float, returns the position after it or cursor if there wasn't one.
+A mantissa up to 2^24 and a power of ten no larger than 1e10 are both exact in floats, so one float multiply or divide rounds correctly.
+Anything outside of that (long mantissas, bigger exponents, inf/nan) goes through strtof.
+*/
+static const char* ParseFloat(const char* cursor, const char* end, float& result) {
+  const char* start = cursor;
+
+  bool negative = false;
+  if ((cursor < end) && ((*cursor == '-') || (*cursor == '+'))) {
+    negative = *cursor == '-';
+    ++cursor;
+  }
+
+  uint64 mantissa = 0;
+  int32 exponent = 0;
+  int32 numDigits = 0;
+  bool truncated = false;
+  bool anyDigits = false;
+
+  for (; (cursor < end) && IsDigit(*cursor); ++cursor) {
+    anyDigits = true;
+    if (numDigits < 19) {
+      mantissa = (mantissa * 10) + (*cursor - '0');
+      numDigits += (mantissa != 0) ? 1 : 0;
+    }
+    else {
+      truncated = true;
+      ++exponent;
+    }
+  }
+
+  if ((cursor < end) && (*cursor == '.')) {
+    ++cursor;
+    for (; (cursor < end) && IsDigit(*cursor); ++cursor) {
+      anyDigits = true;
+      if (numDigits < 19) {
+        mantissa = (mantissa * 10) + (*cursor - '0');
+        numDigits += (mantissa != 0) ? 1 : 0;
+        --exponent;
+      }
+      else {
+        truncated = true;
+      }
+    }
+  }
+
+  if (anyDigits && (cursor < end) && ((*cursor == 'e') || (*cursor == 'E'))) {
+    const char* exponentStart = cursor;
+    ++cursor;
+
+    bool negativeExponent = false;
+    if ((cursor < end) && ((*cursor == '-') || (*cursor == '+'))) {
+      negativeExponent = *cursor == '-';
+      ++cursor;
+    }
+
+    if ((cursor < end) && IsDigit(*cursor)) {
+      int32 explicitExponent = 0;
+      for (; (cursor < end) && IsDigit(*cursor); ++cursor) {
+        if (explicitExponent < 10000) {
+          explicitExponent = (explicitExponent * 10) + (*cursor - '0');
+        }
+      }
+
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    else {
+      // Just an 'e', not part of the number.
+      cursor = exponentStart;
+    }
+  }
+
+  if (!anyDigits || truncated || (mantissa > (1ULL << 24)) || (exponent < -10) || (exponent > 10)) {
+    // The file is mapped without a terminator, strtof only ever sees a copy of the token.
+    char token[MaxFloatToken];
+    size_t length = 0;
+    while (((start + length) < end) && (length < (MaxFloatToken - 1)) && (start[length] > ' ')) {
+      token[length] = start[length];
+      ++length;
+    }
+
+    token[length] = '\0';
+
+    if (anyDigits && ((size_t)(cursor - start) >= MaxFloatToken)) {
+      // Too long to copy, the 19 digits we kept are more than a float can hold anyway.
+      snprintf(token, sizeof(token), "%s%llue%d", negative ? "-" : "", (unsigned long long)mantissa, exponent);
+      result = strtof(token, nullptr);
+      return cursor;
+    }
+
+    char* strtofEnd = nullptr;
+    result = strtof(token, &strtofEnd);
+    return start + (strtofEnd - token);
+  }
+
+  float value = (float)mantissa;
+  if (exponent < 0) {
+    value /= PowersOfTen[-exponent];
+  }
+  else {
+    value *= PowersOfTen[exponent];
+  }
+
+  result = negative ? -value : value;
+  return cursor;
+}
+
+static const char* ParseIndex(const char* cursor, const char* end, uint32& result) {
+  uint32 value = 0;
+  for (; (cursor < end) && IsDigit(*cursor); ++cursor) {
+    value = (value * 10) + (*cursor - '0');
+  }
+
+  // OBJ indices start at one.
+  result = value - 1;
+  return cursor;
+}
+
+static void ParseFloats(float* fillVec, size_t count, const char* cursor, const char* end, float fallback) {
+  for (size_t i = 0; i < count; ++i) {
+    cursor = SkipSpaces(cursor, end);
+
+    const char* next = (cursor < end) ? ParseFloat(cursor, end, fillVec[i]) : cursor;
+    if (next == cursor) {
+      for (; i < count; ++i) {
+        fillVec[i] = fallback;
+      }
+
+      return;
+    }
+
+    cursor = next;
+  }
+}
+
+static void ParseFace(OBJFace& fillFace, const char* cursor, const char* end) {
+  // Faces are expected to be triangulated, anything past the third corner is ignored.
+  for (int32 i = 0; i < 3; ++i) {
+    cursor = SkipSpaces(cursor, end);
+    if ((cursor == end) || !IsDigit(*cursor)) {
+      return;
+    }
+
+    OBJFaceElement& element = fillFace.triangleFace[i];
+    cursor = ParseIndex(cursor, end, element.vertexIndex);
+
+    if ((cursor < end) && (*cursor == '/')) {
+      cursor = ParseIndex(cursor + 1, end, element.uvIndex);
+
+      if ((cursor < end) && (*cursor == '/')) {
+        cursor = ParseIndex(cursor + 1, end, element.normalIndex);
+      }
+    }
+
+    // Skip anything else in this corner, e.g. a relative index we don't understand.
+    while ((cursor < end) && (*cursor != ' ') && (*cursor != '\t')) {
+      ++cursor;
+    }
+  }
+}
+
+static void ParseGeometryLine(OBJChunk& chunk, const char* line, size_t length) {
+  const char* end = line + length;
+
+  if ((length >= 2) && (line[0] == 'v') && ((line[1] == ' ') || (line[1] == '\t'))) {
+    // Vertex Data.
+    float vertex[4];
+    ParseFloats(vertex, 4, line + 2, end, 1.0f);
+    chunk.verts.EmplaceBack(vertex);
+  }
+  else if ((length >= 3) && (line[0] == 'v') && (line[1] == 'n')) {
+    // Vertex Normals.
+    float vertex[3];
+    ParseFloats(vertex, 3, line + 3, end, 0.0f);
+    chunk.normals.EmplaceBack(vertex);
+  }
+  else if ((length >= 3) && (line[0] == 'v') && (line[1] == 't')) {
+    // Vertex Texture Coordinates (U, V, W).
+    float vertex[3];
+    ParseFloats(vertex, 3, line + 3, end, 0.0f);
+    chunk.uvs.EmplaceBack(vertex);
+  }
+  else if ((length >= 2) && (line[0] == 'f')) {
+    // Vertex face.
+    OBJFace face;
+    ParseFace(face, line + 2, end);
+    chunk.faces.PushBack(face);
+  }
+  else if (length > 0) {
+    chunk.otherLines.EmplaceBack(line, length);
+  }
+}
+
+static void ParseChunk(OBJChunk& chunk) {
+  const char* cursor = chunk.text.GetData();
+  size_t remaining = chunk.text.Size();
+
+  while (remaining > 0) {
+    const size_t lineLength = Unaligned_FindNewline(cursor, remaining);
+
+    size_t length = lineLength;
+    if ((length > 0) && (cursor[length - 1] == '\r')) {
+      --length;
+    }
+
+    ParseGeometryLine(chunk, cursor, length);
+
+    const size_t consumed = (lineLength < remaining) ? (lineLength + 1) : lineLength;
+    cursor += consumed;
+    remaining -= consumed;
+  }
+}
+
+template<typename T>
+static void AppendChunk(Array<T>& dest, size_t& offset, const Array<T>& source) {
+  for (const T& item : source) {
+    dest[offset] = item;
+    ++offset;
+  }
+}
+
 OBJFile::OBJFile() {
 }
 
 void OBJFile::LoadFromFile(const FileString& path) {
-  ParseRaw(path);
+  ParseRaw(path, nullptr);
+}
+
+void OBJFile::LoadFromFile(const FileString& path, ThreadPool& threadPool) {
+  ParseRaw(path, &threadPool);
 }
 
 Array<Vec4>& OBJFile::Verts() {
@@ -34,71 +288,112 @@ String& OBJFile::AlbedoTexture() {
   return mAlbedoTexture;
 }
 
-void OBJFile::ParseRaw(const FileString& objFilePath) {
+void OBJFile::ParseRaw(const FileString& objFilePath, ThreadPool* threadPool) {
   MemoryMappedFileReader reader(objFilePath);
   if (!reader.IsOpen()) {
     return;
   }
 
   const char* fileBuffer = reader.GetBuffer();
-  size_t fileSize = reader.GetSize();
-  size_t lastLineIndex = 0;
+  const size_t fileSize = reader.GetSize();
 
-  for (size_t offset = 0; offset < fileSize; ++offset) {
-    if (fileBuffer[offset] == '\n') {
-      size_t lineLength = offset - lastLineIndex;
-      Span<const char> line(fileBuffer + lastLineIndex, lineLength);
+  const size_t numChunks = (threadPool == nullptr) ? 1 : ((fileSize + OBJChunkSize - 1) / OBJChunkSize);
+  if (numChunks == 0) {
+    return;
+  }
+
+  mChunks.Resize(numChunks);
+
+  // Push each split forward to the next newline so no line is cut in half.
+  size_t chunkStart = 0;
+  for (size_t i = 0; i < numChunks; ++i) {
+    size_t chunkEnd = fileSize;
+
+    if ((i + 1) < numChunks) {
+      chunkEnd = (chunkStart + OBJChunkSize < fileSize) ? (chunkStart + OBJChunkSize) : fileSize;
+      chunkEnd += Unaligned_FindNewline(fileBuffer + chunkEnd, fileSize - chunkEnd);
+      chunkEnd = (chunkEnd < fileSize) ? (chunkEnd + 1) : fileSize;
+    }
+
+    mChunks[i].text = Span<const char>(fileBuffer + chunkStart, chunkEnd - chunkStart);
+    chunkStart = chunkEnd;
+  }
+
+  if (numChunks == 1) {
+    ParseChunk(mChunks[0]);
+  }
+  else {
+    ParallelIndexRange parseRange = ParallelIndexRange::FromMember<OBJFile, &OBJFile::ParseChunks>(this);
+    JobHandle parseJob(threadPool->CreateJob(parseRange, 0, numChunks));
+    threadPool->Submit(parseJob);
+    threadPool->Wait(parseJob);
+  }
+
+  MergeChunks(objFilePath);
+}
+
+void OBJFile::ParseChunks(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    ParseChunk(mChunks[i]);
+  }
+}
+
+void OBJFile::MergeChunks(const FileString& objFilePath) {
+  size_t numVerts = 0;
+  size_t numNormals = 0;
+  size_t numUVs = 0;
+  size_t numFaces = 0;
+
+  for (const OBJChunk& chunk : mChunks) {
+    numVerts += chunk.verts.Size();
+    numNormals += chunk.normals.Size();
+    numUVs += chunk.uvs.Size();
+    numFaces += chunk.faces.Size();
+  }
+
+  size_t vertOffset = mVerts.Size();
+  size_t normalOffset = mNormals.Size();
+  size_t uvOffset = mUVCoords.Size();
+  size_t faceOffset = mFaces.Size();
+
+  mVerts.Resize(vertOffset + numVerts);
+  mNormals.Resize(normalOffset + numNormals);
+  mUVCoords.Resize(uvOffset + numUVs);
+  mFaces.Resize(faceOffset + numFaces);
+
+  // Indices in the file are absolute, so appending in file order is all the fixup they need.
+  for (OBJChunk& chunk : mChunks) {
+    AppendChunk(mVerts, vertOffset, chunk.verts);
+    AppendChunk(mNormals, normalOffset, chunk.normals);
+    AppendChunk(mUVCoords, uvOffset, chunk.uvs);
+    AppendChunk(mFaces, faceOffset, chunk.faces);
+
+    for (Span<const char>& line : chunk.otherLines) {
       ParseOBJLine(line, objFilePath);
-      lastLineIndex = offset + 1;
     }
   }
+
+  // The chunks point into the mapped file, they can't outlive it.
+  mChunks.Clear();
 }
 
 void OBJFile::ParseOBJLine(Span<const char>& line, const FileString& objFilePath) {
   const char* rawLine = line.GetData();
   const size_t length = line.Size();
 
-  // All lines in the input file must be terminated with a newline.
-  // The parser will fail to read the last line properly if this is the case.
+  // Geometry has already been picked out by the chunk parser, this only sees the rest.
 
   switch (rawLine[0]) {
     case 'v':
-      if (rawLine[1] == 'n') {
-        // Vertex Normals.
-        float vertex[3];
-        Span<const char> choppedLine(rawLine + 3, length - 3);
-        ParseVec3(vertex, choppedLine, 0.0f);
-        mNormals.EmplaceBack(vertex);
-      }
-      else if (rawLine[1] == 'p') {
+      if ((length > 1) && (rawLine[1] == 'p')) {
         // Vertex Parameters.
         // For curves and surfaces, ignoring for now.
         GlobalLog->Log(LogCategory::Info, String::FromFormat("Vertex Parameters: [{0}]\n", line));
       }
-      else if (rawLine[1] == 't') {
-        // Vertex Texture Coordinates (U, V, W).
-        float vertex[3];
-        Span<const char> choppedLine(rawLine + 3, length - 3);
-        ParseVec3(vertex, choppedLine, 0.0f);
-        mUVCoords.EmplaceBack(vertex);
-      }
       else {
-        // Vertex Data.
-        float vertex[4];
-        Span<const char> choppedLine(rawLine + 2, length - 2);
-        ParseVec4(vertex, choppedLine, 1.0f);
-        mVerts.EmplaceBack(vertex);
+        GlobalLog->Log(LogCategory::Info, String::FromFormat("Unknown Line: [{0}]\n", line));
       }
       break;
-    case 'f':
-      // Vertex face.
-    {
-      OBJFace face;
-      Span<const char> choppedLine(rawLine + 2, length - 2);
-      ParseFace(face, choppedLine);
-      mFaces.PushBack(face);
-    }
-    break;
     case 'l':
     {
       // Line.
@@ -107,8 +402,10 @@ void OBJFile::ParseOBJLine(Span<const char>& line, const FileString& objFilePath
     break;
     case 'm':
     {
-      Span<const char> choppedLine(rawLine + 7, length - 7);
-      ParseMaterial(choppedLine, objFilePath);
+      if (length > 7) {
+        Span<const char> choppedLine(rawLine + 7, length - 7);
+        ParseMaterial(choppedLine, objFilePath);
+      }
     }
       break;
     default:
@@ -220,120 +517,6 @@ void OBJFile::ParseMTLLine(const char* currentLine, size_t length, const FileStr
   }
 }
 
-void OBJFile::ParseVec3(float fillVec[3], Span<const char>& line, float fallback) {
-  const char* endOfLine = strchr(line.GetData(), '\n');
-
-  for (int32 i = 0; i < 3; ++i) {
-    if (line.Size() > 0) {
-      fillVec[i] = strtof(line.GetData(), NULL);
-    }
-    else {
-      fillVec[i] = fallback;
-      return;
-    }
-
-    const char* delimiter = strchr(line.GetData(), ' ');
-    if (endOfLine < delimiter) {
-      line = Span("", 0);
-    }
-    else {
-      size_t length = delimiter - line.GetData();
-      line = Span(delimiter + 1, line.Size() - length - 1);
-    }
-  }
-}
-
-void OBJFile::ParseVec4(float fillVec[4], Span<const char>& line, float fallback) {
-  const char* endOfLine = strchr(line.GetData(), '\n');
-
-  for (int32 i = 0; i < 4; ++i) {
-    if (line.Size() > 0) {
-      fillVec[i] = strtof(line.GetData(), NULL);
-    }
-    else {
-      fillVec[i] = fallback;
-      return;
-    }
-
-    const char* delimiter = strchr(line.GetData(), ' ');
-    if (endOfLine < delimiter) {
-      line = Span("", 0);
-    }
-    else {
-      size_t length = delimiter - line.GetData();
-      line = Span(delimiter + 1, line.Size() - length - 1);
-    }
-  }
-}
-
-void OBJFile::ParseFace(OBJFace& fillFace, Span<const char>& line) {
-  for (int32 i = 0; i < 3; ++i) {
-    if (line.Size() > 0) {
-      uint32 vertexIndex = strtoul(line.GetData(), NULL, 10) - 1;
-      fillFace.triangleFace[i].vertexIndex = vertexIndex;
-    }
-    else {
-      return;
-    }
-
-    const char* indexDelimiter = strchr(line.GetData(), '/');
-
-    if (indexDelimiter == nullptr) {
-      const char* faceDelimiter = strchr(line.GetData(), ' ');
-
-      if (faceDelimiter != nullptr) {
-        size_t length = faceDelimiter - line.GetData();
-        line = Span(faceDelimiter + 1, line.Size() - length - 1);
-      }
-
-      continue;
-    }
-
-    size_t length = indexDelimiter - line.GetData();
-    line = Span(indexDelimiter + 1, line.Size() - length - 1);
-
-    if (line.Size() > 0) {
-      uint32 textureIndex = strtoul(line.GetData(), NULL, 10) - 1;
-      fillFace.triangleFace[i].uvIndex = textureIndex;
-    }
-    else {
-      return;
-    }
-
-    indexDelimiter = strchr(line.GetData(), '/');
-
-    if (indexDelimiter == nullptr) {
-      const char* faceDelimiter = strchr(line.GetData(), ' ');
-      if (faceDelimiter != nullptr) {
-        length = faceDelimiter - line.GetData();
-        line = Span(faceDelimiter + 1, line.Size() - length - 1);
-      }
-
-      continue;
-    }
-
-    length = indexDelimiter - line.GetData();
-    line = Span(indexDelimiter + 1, line.Size() - length - 1);
-
-    if (line.Size() > 0) {
-      uint32 normalIndex = strtoul(line.GetData(), NULL, 10) - 1;
-      fillFace.triangleFace[i].normalIndex = normalIndex;
-    }
-    else {
-      return;
-    }
-
-    const char* faceDelimiter = strchr(line.GetData(), ' ');
-    if (faceDelimiter != nullptr) {
-      length = faceDelimiter - line.GetData();
-      line = Span(faceDelimiter + 1, line.Size() - length - 1);
-    }
-    else {
-      break;
-    }
-  }
-}
-
 void OBJFile::ParseMaterial(Span<const char>& line, const FileString& objFilePath) {
   FileString materialPath(objFilePath);
   materialPath.SetFilename(String(line.GetData(), 0, line.Size()));
@@ -20,12 +20,28 @@ struct OBJFace {
   OBJFaceElement triangleFace[3];
 };
 
+// A line aligned piece of the file, parsed on its own and merged back in file order.
+struct OBJChunk {
+  Span<const char> text;
+  Array<Vec4> verts;
+  Array<Vec3> normals;
+  Array<Vec3> uvs;
+  Array<OBJFace> faces;
+  // Anything that isn't geometry, handled on the calling thread once every chunk is done.
+  Array<Span<const char>> otherLines;
+};
+
+class ThreadPool;
+
 class OBJFile final {
   public:
   OBJFile();
 
   void LoadFromFile(const FileString& path);
 
+  // Large files are split into chunks that are parsed on the pool.
+  void LoadFromFile(const FileString& path, ThreadPool& threadPool);
+
   Array<Vec4>& Verts();
 
   Array<Vec3>& Normals();
@@ -47,17 +63,17 @@ class OBJFile final {
 
   String mAlbedoTexture;
 
-  void ParseRaw(const FileString& objFilePath);
+  Array<OBJChunk> mChunks;
 
-  void ParseOBJLine(Span<const char>& line, const FileString& objFilePath);
+  void ParseRaw(const FileString& objFilePath, ThreadPool* threadPool);
 
-  void ParseMTLLine(const char* currentLine, size_t length, const FileString& objFilePath);
+  void ParseChunks(size_t begin, size_t end);
 
-  void ParseVec3(float fillVec[3], Span<const char>& line, float fallback);
+  void MergeChunks(const FileString& objFilePath);
 
-  void ParseVec4(float fillVec[4], Span<const char>& line, float fallback);
+  void ParseOBJLine(Span<const char>& line, const FileString& objFilePath);
 
-  void ParseFace(OBJFace& fillFace, Span<const char>& line);
+  void ParseMTLLine(const char* currentLine, size_t length, const FileString& objFilePath);
 
   void ParseMaterial(Span<const char>& line, const FileString& objFilePath);
 };
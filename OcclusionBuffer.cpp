@@ -0,0 +1,116 @@
+#include "OcclusionBuffer.h"
+
+#include <cmath>
+
+#include "Constants.h"
+
+namespace ZSharp {
+
+// Covers the error from the reciprocal approximations used when the vertices were transformed.
+static constexpr float OcclusionEpsilon = 1.f / 512.f;
+
+void OcclusionBuffer::Begin(size_t screenWidth, size_t screenHeight) {
+  const int32 width = (int32)((screenWidth + CellSize - 1) / CellSize);
+  const int32 height = (int32)((screenHeight + CellSize - 1) / CellSize);
+
+  if ((width != mWidth) || (height != mHeight)) {
+    mWidth = width;
+    mHeight = height;
+    mDepth.Resize(mWidth * mHeight);
+  }
+
+  for (float& depth : mDepth) {
+    depth = -1.f;
+  }
+}
+
+void OcclusionBuffer::RasterOccluder(const float* vertices, const int32* indices, int32 end) {
+  for (int32 i = 0; i < end; i += TRI_VERTS) {
+    const float* v1 = vertices + indices[i];
+    const float* v2 = vertices + indices[i + 1];
+    const float* v3 = vertices + indices[i + 2];
+
+    const float x0 = v1[0];
+    const float y0 = v1[1];
+    const float x1 = v2[0];
+    const float y1 = v2[1];
+    const float x2 = v3[0];
+    const float y2 = v3[1];
+
+    // The depth written is the reciprocal of the interpolated W, the largest W gives the farthest point on the triangle.
+    float farthestDepth = 1.f / fmaxf(v1[3], fmaxf(v2[3], v3[3]));
+    farthestDepth -= fabsf(farthestDepth) * OcclusionEpsilon;
+
+    // Only cells entirely inside of the bounding box can be fully covered.
+    int32 minX = (int32)ceilf(fminf(x0, fminf(x1, x2)) / CellSize);
+    int32 minY = (int32)ceilf(fminf(y0, fminf(y1, y2)) / CellSize);
+    int32 maxX = (int32)floorf(fmaxf(x0, fmaxf(x1, x2)) / CellSize);
+    int32 maxY = (int32)floorf(fmaxf(y0, fmaxf(y1, y2)) / CellSize);
+
+    minX = (minX < 0) ? 0 : minX;
+    minY = (minY < 0) ? 0 : minY;
+    maxX = (maxX > mWidth) ? mWidth : maxX;
+    maxY = (maxY > mHeight) ? mHeight : maxY;
+
+    for (int32 y = minY; y < maxY; ++y) {
+      float* row = mDepth.GetData() + (y * mWidth);
+
+      for (int32 x = minX; x < maxX; ++x) {
+        if (row[x] >= farthestDepth) {
+          continue;
+        }
+
+        // Test the first and last pixel of the cell on each axis, the triangle is convex so that covers the whole cell.
+        const float left = (float)(x * CellSize);
+        const float top = (float)(y * CellSize);
+        const float right = left + (float)(CellSize - 1);
+        const float bottom = top + (float)(CellSize - 1);
+        const float cornersX[4] = { left, right, left, right };
+        const float cornersY[4] = { top, top, bottom, bottom };
+
+        bool covered = true;
+        for (int32 c = 0; (c < 4) && covered; ++c) {
+          // Same edge functions and winding as the raster kernels.
+          const float w0 = ((cornersX[c] - x1) * (y2 - y1)) - ((cornersY[c] - y1) * (x2 - x1));
+          const float w1 = ((cornersX[c] - x2) * (y0 - y2)) - ((cornersY[c] - y2) * (x0 - x2));
+          const float w2 = ((cornersX[c] - x0) * (y1 - y0)) - ((cornersY[c] - y0) * (x1 - x0));
+          covered = (w0 > 0.f) && (w1 > 0.f) && (w2 > 0.f);
+        }
+
+        if (covered) {
+          row[x] = farthestDepth;
+        }
+      }
+    }
+  }
+}
+
+bool OcclusionBuffer::IsOccluded(const float screenMin[2], const float screenMax[2], float nearestDepth) const {
+  if (mDepth.IsEmpty()) {
+    return false;
+  }
+
+  int32 minX = (int32)floorf(screenMin[0] / CellSize);
+  int32 minY = (int32)floorf(screenMin[1] / CellSize);
+  int32 maxX = (int32)floorf(screenMax[0] / CellSize);
+  int32 maxY = (int32)floorf(screenMax[1] / CellSize);
+
+  minX = (minX < 0) ? 0 : minX;
+  minY = (minY < 0) ? 0 : minY;
+  maxX = (maxX >= mWidth) ? (mWidth - 1) : maxX;
+  maxY = (maxY >= mHeight) ? (mHeight - 1) : maxY;
+
+  for (int32 y = minY; y <= maxY; ++y) {
+    const float* row = mDepth.GetData() + (y * mWidth);
+
+    for (int32 x = minX; x <= maxX; ++x) {
+      if (row[x] <= nearestDepth) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "Array.h"
+
+namespace ZSharp {
+
+/*
+Low resolution depth buffer used to cull models hidden behind large occluders.
+Each cell covers CellSize x CellSize screen pixels and holds a conservative (farthest) depth.
+A cell is only written when an occluder triangle covers it entirely, so the buffer never claims more than is actually hidden.
+Depth uses the same convention as the main depth buffer, larger values are closer and -1 is empty.
+*/
+class OcclusionBuffer final {
+  public:
+
+  static constexpr int32 CellSize = 4;
+
+  OcclusionBuffer() = default;
+
+  OcclusionBuffer(const OcclusionBuffer&) = delete;
+  void operator=(const OcclusionBuffer&) = delete;
+
+  void Begin(size_t screenWidth, size_t screenHeight);
+
+  // Takes screen space vertices laid out the same as the raster kernels.
+  void RasterOccluder(const float* vertices, const int32* indices, int32 end);
+
+  bool IsOccluded(const float screenMin[2], const float screenMax[2], float nearestDepth) const;
+
+  private:
+  Array<float> mDepth;
+  int32 mWidth = 0;
+  int32 mHeight = 0;
+};
+
+}
@@ -1,5 +1,7 @@
 #include "PNG.h"
 
+#include "Framebuffer.h"
+#include "Texture.h"
 #include "ZAssert.h"
 #include "Common.h"
 #include "CommonMath.h"
@@ -7,6 +9,7 @@
 #include "PlatformMemory.h"
 #include "PlatformIntrinsics.h"
 
+#include <cstdlib>
 #include <cstring>
 
 // See: https://en.wikipedia.org/wiki/PNG
@@ -124,72 +127,56 @@ uint8* PNG::Decompress(ChannelOrderPNG order) {
           3) Repeat until end of stream
   */
 
-  mChunkedIDATData = chunkedIDATData;
-  mBitOffset = 0;
-
   // Sanity check for zlib header DEFLATE compression method.
-  if ((mChunkedIDATData[0] & 0x0F) != 8) {
+  if ((chunkedIDATDataLength < 2) || ((chunkedIDATData[0] & 0x0F) != 8)) {
+    PlatformFree(chunkedIDATData);
     ZAssert(false);
     return nullptr;
   }
 
   // Skip over first two zlib header bytes.
   // PNG spec does not allow the optional preset dictionary so we skip directly to the DEFLATE stream.
-  mChunkedIDATData += 2;
+  mBits = {};
+  mBits.data = chunkedIDATData + 2;
+  mBits.length = chunkedIDATDataLength - 2;
+  mOutputIndex = 0;
 
   // PNG spec calls for a filter byte on each scan line before/after compression.
   // This denotes one of 5 filtering methods that help to reduce image size before DEFLATE is applied.
+  // Matches are copied in 16 byte chunks and may run a little past the end of the image.
   const size_t decompressedSize = ((mStride + 1) * mHeight);
-  uint8* buffer = (uint8*)PlatformMalloc(decompressedSize);
+  const size_t CopyPadding = 16;
+  uint8* buffer = (uint8*)PlatformMalloc(decompressedSize + CopyPadding);
 
-  for (bool reading = true; reading;) {
-    uint32 isFinal = ReadBits(1);
+  bool decoded = true;
+  for (bool reading = true; reading && decoded;) {
+    uint32 isFinal = ReadBits(mBits, 1);
     reading = (isFinal == 0);
 
-    uint32 compressedType = ReadBits(2);
+    uint32 compressedType = ReadBits(mBits, 2);
     if (compressedType == 0) {
-      PlatformFree(buffer);
-      ZAssert(false);
-      return nullptr;
-#if 0
-      // TODO: This is a "stored"/uncompressed block.
-      //  2 next bytes are LEN
-      //  2 next bytes are NLEN (ones-complement of previous length)
-      //  Next LEN bytes are uncompressed data that should be copied to the output.
-      mBitOffset = RoundUpNearestMultiple(mBitOffset, 8);
-
-      const uint8* data = DataBitOffset();
-
-      uint16 uncompressedLength = data[0];
-      uncompressedLength |= (((uint16)(data[1])) << 8);
-      uint16 onesCompLength = data[2];
-      onesCompLength |= (((uint16)(data[3])) << 8);
-
-      if ((uncompressedLength) != (~onesCompLength)) {
-        ZAssert(false);
-        return nullptr;
-      }
-
-      mBitOffset += 32;
-      mBitOffset += (uncompressedLength * 8);
-
-      memcpy(buffer, data + 4, uncompressedLength);
-      outputBufferPos += uncompressedLength;
-#endif
+      decoded = CopyStoredBlock(buffer);
+    }
+    else if (compressedType == 1) {
+      decoded = DecodeFixedHuffman(buffer);
     }
     else if (compressedType == 2) {
-      if (!DecodeDynamicHuffman(buffer)) {
-        PlatformFree(buffer);
-        ZAssert(false);
-        return nullptr;
-      }
+      decoded = DecodeDynamicHuffman(buffer);
+    }
+    else {
+      decoded = false;
     }
   }
 
   PlatformFree(chunkedIDATData);
   chunkedIDATData = nullptr;
-  mChunkedIDATData = nullptr;
-  mBitOffset = 0;
+  mBits = {};
+
+  if (!decoded || (mOutputIndex != decompressedSize)) {
+    PlatformFree(buffer);
+    ZAssert(false);
+    return nullptr;
+  }
 
   uint8* outputImage = FilterDeflatedImage(buffer);
 
@@ -332,59 +319,41 @@ bool PNG::ReadHeader() {
   return true;
 }
 
-int64 PNG::PaethPredictor(int64 left, int64 above, int64 aboveLeft) {
-  int64 p = left + above - aboveLeft;
-  int64 pa = llabs(p - left);
-  int64 pb = llabs(p - above);
-  int64 pc = llabs(p - aboveLeft);
-  if ((pa <= pb) && (pa <= pc)) {
-    return left;
-  }
-  else if (pb <= pc) {
-    return above;
-  }
-  else {
-    return aboveLeft;
-  }
-}
-
 const uint8* PNG::DataOffset() {
   return reinterpret_cast<const uint8*>(mDataPtr) + mDataOffset;
 }
 
-const uint8* PNG::DataBitOffset() {
-  return reinterpret_cast<const uint8*>(mDataPtr) + mDataOffset + (mBitOffset >> 3);
+void PNG::RefillBits(PngBitStream& bits) {
+  if ((bits.offset + sizeof(uint64)) <= bits.length) {
+    // Load 8 bytes at once and only step over the ones that fit.
+    // The partial byte on top is loaded again next time so it doesn't matter that it gets OR'd in twice.
+    uint64 next = 0;
+    memcpy(&next, bits.data + bits.offset, sizeof(next));
+    bits.buffer |= next << bits.count;
+    bits.offset += (63 - bits.count) >> 3;
+    bits.count |= 56;
+  }
+  else {
+    for (; bits.count <= 56; bits.count += 8, ++bits.offset) {
+      const uint64 next = (bits.offset < bits.length) ? bits.data[bits.offset] : 0;
+      bits.buffer |= next << bits.count;
+    }
+  }
 }
 
-uint32 PNG::ReadBits(size_t count) {
-  uint32 ret = 0;
-
-  if (count > MaxBits) {
+uint32 PNG::ReadBits(PngBitStream& bits, size_t count) {
+  if (count > 32) {
     ZAssert(false);
     return 0;
   }
-  else if (count == 0) {
-    return 0;
-  }
-
-  const uint8* data = (mChunkedIDATData + (mBitOffset >> 3));
-  const size_t bitsReadInByte = (mBitOffset % 8);
 
-  // Read the first bytes, drop unneeded bits.
-  size_t bytesRead = 0;
-  ret |= data[bytesRead];
-
-  for (size_t i = (8 - bitsReadInByte); i < count; i += 8) {
-    ++bytesRead;
-    const uint32 shiftAmount = ((uint32)bytesRead * 8);
-    ZAssert(shiftAmount < 32);
-    ret |= (((uint32)data[bytesRead]) << shiftAmount);
+  if (bits.count < count) {
+    RefillBits(bits);
   }
 
-  ret >>= bitsReadInByte;
-  ret &= ((1U << count) - 1U);
-
-  mBitOffset += count;
+  const uint32 ret = (uint32)(bits.buffer & ((1ULL << count) - 1ULL));
+  bits.buffer >>= count;
+  bits.count -= count;
   return ret;
 }
 
@@ -397,6 +366,60 @@ void PNG::IdentifyChunk(uint32& length, uint32& type) {
   mDataOffset += 8;
 }
 
+bool PNG::CopyStoredBlock(uint8* output) {
+  // Stored blocks start on a byte boundary, hand the whole bytes left in the bit buffer back to the stream.
+  mBits.offset -= (mBits.count >> 3);
+  mBits.buffer = 0;
+  mBits.count = 0;
+
+  if ((mBits.offset + 4) > mBits.length) {
+    ZAssert(false);
+    return false;
+  }
+
+  //  2 bytes are LEN
+  //  2 bytes are NLEN (ones-complement of previous length)
+  //  Next LEN bytes are uncompressed data that should be copied to the output.
+  const uint8* data = mBits.data + mBits.offset;
+  const size_t uncompressedLength = data[0] | (((size_t)data[1]) << 8);
+  const size_t onesCompLength = data[2] | (((size_t)data[3]) << 8);
+
+  const size_t endOfImage = (mStride + 1) * mHeight;
+
+  if ((uncompressedLength != ((~onesCompLength) & 0xFFFF))
+    || ((mBits.offset + 4 + uncompressedLength) > mBits.length)
+    || (uncompressedLength > (endOfImage - mOutputIndex))) {
+    ZAssert(false);
+    return false;
+  }
+
+  memcpy(output + mOutputIndex, data + 4, uncompressedLength);
+  mOutputIndex += uncompressedLength;
+  mBits.offset += 4 + uncompressedLength;
+  return true;
+}
+
+bool PNG::DecodeFixedHuffman(uint8* output) {
+  // Code lengths are fixed by the spec (RFC1951 3.2.6).
+  uint16 lengths[288 + 30];
+  for (size_t i = 0; i < 288; ++i) {
+    lengths[i] = (i < 144) ? 8 : ((i < 256) ? 9 : ((i < 280) ? 7 : 8));
+  }
+
+  for (size_t i = 288; i < (288 + 30); ++i) {
+    lengths[i] = 5;
+  }
+
+  PngHuffman lengthHuffman;
+  PngHuffman distanceHuffman;
+  if (!BuildHuffman(lengthHuffman, lengths, 288) || !BuildHuffman(distanceHuffman, lengths + 288, 30)) {
+    ZAssert(false);
+    return false;
+  }
+
+  return DeflateStream(output, lengthHuffman, distanceHuffman);
+}
+
 bool PNG::DecodeDynamicHuffman(uint8* output) {
   /*
   Steps:
@@ -405,26 +428,25 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
     3) Walk the stream and decode symbols using the decoded Huffman Trees.
   */
 
-  const uint32 lengthCodes = ReadBits(5) + 257;
-  const uint32 distCodes = ReadBits(5) + 1;
-  const uint32 codeCodes = ReadBits(4) + 4;
+  const uint32 lengthCodes = ReadBits(mBits, 5) + 257;
+  const uint32 distCodes = ReadBits(mBits, 5) + 1;
+  const uint32 codeCodes = ReadBits(mBits, 4) + 4;
 
   if (lengthCodes > 286 || distCodes > 32 || codeCodes > 19) {
     ZAssert(false);
     return false;
   }
 
-  uint16 alphabet[286 + 30];
+  uint16 alphabet[286 + 32];
   memset(alphabet, 0, sizeof(alphabet));
   const uint8 alphabetOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
 
   for (uint32 i = 0; i < codeCodes; ++i) {
-    uint32 symbol = ReadBits(3);
+    uint32 symbol = ReadBits(mBits, 3);
     alphabet[alphabetOrder[i]] = static_cast<uint16>(symbol);
   }
 
   PngHuffman lengthHuffman;
-  memset(&lengthHuffman, 0, sizeof(PngHuffman));
   if (!BuildHuffman(lengthHuffman, alphabet, 19)) {
     return false;
   }
@@ -433,7 +455,7 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
   for (uint32 i = 0; i < lengthCodes + distCodes;) {
     uint32 symbol = 0;
 
-    if (!DecodeSymbol(lengthHuffman, symbol)) {
+    if (!DecodeSymbol(lengthHuffman, mBits, symbol)) {
       ZAssert(false);
       return false;
     }
@@ -451,13 +473,13 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
         }
 
         length = alphabet[i - 1];
-        symbol = 3 + ReadBits(2);
+        symbol = 3 + ReadBits(mBits, 2);
       }
       else if (symbol == 17) {
-        symbol = 3 + ReadBits(3);
+        symbol = 3 + ReadBits(mBits, 3);
       }
       else {
-        symbol = 11 + ReadBits(7);
+        symbol = 11 + ReadBits(mBits, 7);
       }
 
       if (i + symbol > lengthCodes + distCodes) {
@@ -478,8 +500,6 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
 
   // Reused lengthHuffman for decoding the original length/distance pairs.
   // They were encoded themselves with a huffman code which we needed to decode earlier.
-  // Must zero out the codes before we proceed.
-  memset(lengthHuffman.codes, 0, sizeof(lengthHuffman.codes));
   if (!BuildHuffman(lengthHuffman, alphabet, lengthCodes)) {
     ZAssert(false);
     return false;
@@ -488,7 +508,6 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
   // We reused the same data structure for the length codes.
   // Note that we do not need as much storage for the symbols but for simplicity we do it this way.
   PngHuffman distanceHuffman;
-  memset(&distanceHuffman, 0, sizeof(PngHuffman));
   if (!BuildHuffman(distanceHuffman, alphabet + lengthCodes, distCodes)) {
     ZAssert(false);
     return false;
@@ -497,62 +516,104 @@ bool PNG::DecodeDynamicHuffman(uint8* output) {
   return DeflateStream(output, lengthHuffman, distanceHuffman);
 }
 
-bool PNG::BuildHuffman(PngHuffman& huffman, uint16* lengths, int32 count) {
-  uint16 offsets[16];
-  memset(offsets, 0, sizeof(offsets));
+static uint32 ReverseBits16(uint32 value) {
+  value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+  value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+  value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+  value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+  return value;
+}
+
+bool PNG::BuildHuffman(PngHuffman& huffman, const uint16* lengths, int32 count) {
+  uint16 sizes[16];
+  memset(sizes, 0, sizeof(sizes));
+  memset(huffman.fast, 0, sizeof(huffman.fast));
 
   // Read sizes in.
   for (int32 i = 0; i < count; ++i) {
-    (huffman.codes[lengths[i]])++;
+    (sizes[lengths[i]])++;
   }
 
+  sizes[0] = 0;
+
   // Check for valid range.
   int32 left = 1;
   for (int32 i = 1; i <= MaxBits; ++i) {
     left <<= 1;
-    left -= huffman.codes[i];
+    left -= sizes[i];
     if (left < 0) {
       ZAssert(false);
       return false;
     }
   }
 
-  // Get offsets.
-  offsets[1] = 0;
-  for (int32 i = 1; i < MaxBits; ++i) {
-    offsets[i + 1] = offsets[i] + huffman.codes[i];
+  // Canonical codes of each length are consecutive, record where each length starts.
+  uint16 nextCode[16];
+  int32 code = 0;
+  int32 symbolIndex = 0;
+  for (int32 i = 1; i <= MaxBits; ++i) {
+    nextCode[i] = static_cast<uint16>(code);
+    huffman.firstCode[i] = static_cast<uint16>(code);
+    huffman.firstSymbol[i] = static_cast<uint16>(symbolIndex);
+    code += sizes[i];
+    symbolIndex += sizes[i];
+    huffman.maxCode[i] = static_cast<uint32>(code) << (16 - i);
+    code <<= 1;
   }
 
+  // Sentinel, nothing is longer than MaxBits.
+  huffman.maxCode[16] = 0x10000;
+
   // Populate symbols.
+  // DEFLATE packs codes starting from their most significant bit so the fast table is indexed by the reversed code.
+  // Every index that starts with the code gets the same entry.
   for (int32 i = 0; i < count; ++i) {
-    if (lengths[i] > 0) {
-      huffman.symbols[offsets[lengths[i]]++] = static_cast<uint16>(i);
+    const uint32 length = lengths[i];
+    if (length > 0) {
+      const uint32 symbolCode = nextCode[length]++;
+      huffman.symbols[huffman.firstSymbol[length] + (symbolCode - huffman.firstCode[length])] = static_cast<uint16>(i);
+
+      if (length <= HuffmanFastBits) {
+        const uint16 entry = static_cast<uint16>((length << 9) | static_cast<uint32>(i));
+        for (uint32 j = ReverseBits16(symbolCode) >> (16 - length); j < (1U << HuffmanFastBits); j += (1U << length)) {
+          huffman.fast[j] = entry;
+        }
+      }
     }
   }
 
   return true;
 }
 
-bool PNG::DecodeSymbol(const PngHuffman& huffman, uint32& symbol) {
-  int32 code = 0;
-  int32 first = 0;
-  int32 index = 0;
+bool PNG::DecodeSymbol(const PngHuffman& huffman, PngBitStream& bits, uint32& symbol) {
+  if (bits.count < (size_t)MaxBits) {
+    RefillBits(bits);
+  }
 
-  for (uint32 i = 1; i <= MaxBits; ++i) {
-    code |= static_cast<int32>(ReadBits(1));
-    int32 count = huffman.codes[i];
-    if (code - count < first) {
-      symbol = huffman.symbols[index + (code - first)];
-      return true;
-    }
+  const uint32 entry = huffman.fast[bits.buffer & ((1U << HuffmanFastBits) - 1U)];
+  if (entry != 0) {
+    const uint32 length = entry >> 9;
+    bits.buffer >>= length;
+    bits.count -= length;
+    symbol = entry & 0x1FF;
+    return true;
+  }
 
-    index += count;
-    first += count;
-    first <<= 1;
-    code <<= 1;
+  // Longer codes, compare the next 16 bits in code order against the last code of each length.
+  const uint32 code = ReverseBits16((uint32)(bits.buffer & 0xFFFF));
+  uint32 length = HuffmanFastBits + 1;
+  for (; code >= huffman.maxCode[length]; ++length) {
+  }
+
+  if (length > (uint32)MaxBits) {
+    return false;
   }
 
-  return false;
+  const uint32 index = huffman.firstSymbol[length] + ((code >> (16 - length)) - huffman.firstCode[length]);
+  bits.buffer >>= length;
+  bits.count -= length;
+  symbol = huffman.symbols[index];
+  return true;
 }
 
 bool PNG::DeflateStream(uint8* output, const PngHuffman& lengthHuff, const PngHuffman& distHuff) {
@@ -578,9 +639,18 @@ bool PNG::DeflateStream(uint8* output, const PngHuffman& lengthHuff, const PngHu
   // Must account for filter byte on each scan line.
   const size_t endOfImage = (mStride + 1) * mHeight;
 
+  // Work on local copies so writes to output can't force the stream state back out to memory.
+  PngBitStream bits = mBits;
+  size_t outputIndex = mOutputIndex;
+
   for (bool reading = true; reading;) {
+    // A full length/distance pair is at most 48 bits, one refill covers the whole iteration.
+    if (bits.count < 48) {
+      RefillBits(bits);
+    }
+
     uint32 symbol = 0;
-    if (!DecodeSymbol(lengthHuff, symbol)) {
+    if (!DecodeSymbol(lengthHuff, bits, symbol)) {
       ZAssert(false);
       return false;
     }
@@ -588,8 +658,13 @@ bool PNG::DeflateStream(uint8* output, const PngHuffman& lengthHuff, const PngHu
     reading = (symbol != 256);
     if (symbol < 256) {
       // Literal symbol to output.
-      output[mOutputIndex] = (uint8)symbol;
-      mOutputIndex++;
+      if (outputIndex >= endOfImage) {
+        ZAssert(false);
+        return false;
+      }
+
+      output[outputIndex] = (uint8)symbol;
+      outputIndex++;
     }
     else if (symbol > 256) {
       symbol -= 257;
@@ -599,100 +674,477 @@ bool PNG::DeflateStream(uint8* output, const PngHuffman& lengthHuff, const PngHu
       }
 
       uint32 numBitsToRead = extraBits[symbol];
-      uint32 length = baseSizes[symbol] + ReadBits(numBitsToRead);
-      if (!DecodeSymbol(distHuff, symbol)) {
+      uint32 length = baseSizes[symbol] + ReadBits(bits, numBitsToRead);
+      if (!DecodeSymbol(distHuff, bits, symbol) || (symbol >= 30)) {
         ZAssert(false);
         return false;
       }
 
       numBitsToRead = extraDistCodes[symbol];
-      uint32 dist = distCodes[symbol] + ReadBits(numBitsToRead);
+      uint32 dist = distCodes[symbol] + ReadBits(bits, numBitsToRead);
 
-      if (dist > mOutputIndex) {
+      if ((dist > outputIndex) || (length > (endOfImage - outputIndex))) {
         ZAssert(false);
         return false;
       }
 
-      while (length-- && mOutputIndex < endOfImage) {
-        output[mOutputIndex] = output[mOutputIndex - dist];
-        mOutputIndex++;
+      uint8* dest = output + outputIndex;
+      const uint8* source = dest - dist;
+      outputIndex += length;
+
+      // Chunks no wider than the distance never read bytes they write.
+      // The last chunk can spill past the match, the output buffer is padded for that.
+      if (dist >= 16) {
+        for (uint32 i = 0; i < length; i += 16) {
+          memcpy(dest + i, source + i, 16);
+        }
+      }
+      else if (dist >= 8) {
+        for (uint32 i = 0; i < length; i += 8) {
+          memcpy(dest + i, source + i, 8);
+        }
+      }
+      else if (dist == 1) {
+        memset(dest, *source, length);
+      }
+      else {
+        for (uint32 i = 0; i < length; ++i) {
+          dest[i] = source[i];
+        }
       }
     }
   }
 
+  mBits = bits;
+  mOutputIndex = outputIndex;
   return true;
 }
 
-uint8* PNG::FilterDeflatedImage(uint8* image) {
-  const size_t filteredStride = mStride + 1;
+static void WriteBigEndian(uint8* dest, uint32 value) {
+  dest[0] = (uint8)(value >> 24);
+  dest[1] = (uint8)(value >> 16);
+  dest[2] = (uint8)(value >> 8);
+  dest[3] = (uint8)value;
+}
 
-  uint8* outputImage = static_cast<uint8*>(PlatformCalloc(mStride * mHeight));
+static bool WriteChunk(SystemBufferedFileWriter& writer, const char type[4], const uint8* data, size_t length) {
+  uint8 header[8];
+  WriteBigEndian(header, (uint32)length);
+  memcpy(header + 4, type, 4);
 
-  for (size_t i = 0; i < mHeight; ++i) {
-    const size_t rowIndex = filteredStride * i;
-    const size_t rowData = rowIndex + 1;
-    const size_t outputRowIndex = mStride * i;
-    uint8 filterMethod = image[rowIndex];
-
-    switch (filterMethod) {
-      case PngFilter::None:
-        memcpy(outputImage + outputRowIndex, image + rowData, mStride);
-        break;
-      case PngFilter::Sub:
-      {
-        for (size_t x = 0; x < mStride; ++x) {
-          int64 prevIndex = x - mChannels;
-          uint32 prev = (prevIndex < 0) ? 0 : outputImage[outputRowIndex + prevIndex];
-          outputImage[outputRowIndex + x] = (uint8)(((uint32)image[rowData + x] + prev) % 256);
-        }
-      }
-        break;
-      case PngFilter::Up:
-      {
-        for (size_t x = 0; x < mStride; ++x) {
-          int64 aboveIndex = (((int64)outputRowIndex) - ((int64)mStride));
-          uint32 above = (aboveIndex < 0) ? 0 : outputImage[aboveIndex + x];
-          outputImage[outputRowIndex + x] = (uint8)(((uint32)image[rowData + x] + above) % 256);
-        }
-      }
-        break;
-      case PngFilter::Average:
-      {
-        for (size_t x = 0; x < mStride; ++x) {
-          int64 aboveIndex = (((int64)outputRowIndex) - ((int64)mStride));
-          uint32 above = (aboveIndex < 0) ? 0 : outputImage[aboveIndex + x];
+  uint32 crc = Unaligned_CRC32(header + 4, 4, 0xFFFFFFFF);
+  crc = Unaligned_CRC32(data, length, crc) ^ 0xFFFFFFFF;
 
-          int64 prevIndex = x - mChannels;
-          uint32 prev = (prevIndex < 0) ? 0 : outputImage[outputRowIndex + prevIndex];
+  uint8 footer[4];
+  WriteBigEndian(footer, crc);
 
-          outputImage[outputRowIndex + x] = (uint8)(((uint32)image[rowData + x] + ((prev + above) >> 1)) % 256);
-        }
-      }
-        break;
-      case PngFilter::Paeth:
-      {
-        for (size_t x = 0; x < mStride; ++x) {
-          int64 priorAboveIndex = (((int64)outputRowIndex) - ((int64)mStride) + ((int64)x) - ((int64)mChannels));
-          uint32 priorAbove = (priorAboveIndex < 0) ? 0 : outputImage[priorAboveIndex];
+  return writer.Write(header, sizeof(header)) && ((length == 0) || writer.Write(data, length)) && writer.Write(footer, sizeof(footer));
+}
+
+// Packs a row of source pixels down to the output channels in PNG (RGB) order.
+static void PackScanline(const uint8* source, uint8* dest, size_t width, size_t sourceChannels, size_t channels, ChannelOrderPNG order) {
+  const bool swap = (order == ChannelOrderPNG::BGR);
+
+  for (size_t x = 0; x < width; ++x, source += sourceChannels, dest += channels) {
+    dest[0] = swap ? source[2] : source[0];
+    dest[1] = source[1];
+    dest[2] = swap ? source[0] : source[2];
+
+    if (channels == 4) {
+      dest[3] = source[3];
+    }
+  }
+}
+
+/*
+Tries all five filters on a row and keeps the one with the smallest sum of absolute (signed) residuals.
+This is the same heuristic libpng uses, residuals near zero compress best.
+The filters only read unfiltered data so each loop is independent per byte and vectorizes.
+*/
+static void FilterScanline(const uint8* __restrict row, const uint8* __restrict above, size_t length, size_t bpp,
+  uint8* __restrict scratch, uint8* __restrict dest) {
+  uint8* sub = scratch;
+  uint8* up = scratch + length;
+  uint8* average = scratch + (length * 2);
+  uint8* paeth = scratch + (length * 3);
+
+  for (size_t x = 0; x < bpp; ++x) {
+    sub[x] = row[x];
+    up[x] = (uint8)(row[x] - above[x]);
+    average[x] = (uint8)(row[x] - (above[x] >> 1));
+    paeth[x] = (uint8)(row[x] - above[x]);
+  }
+
+  for (size_t x = bpp; x < length; ++x) {
+    const int32 a = row[x - bpp];
+    const int32 b = above[x];
+    const int32 c = above[x - bpp];
+
+    const int32 pa = abs(b - c);
+    const int32 pb = abs(a - c);
+    const int32 pc = abs(a + b - (c * 2));
+    const int32 prediction = ((pa <= pb) && (pa <= pc)) ? a : ((pb <= pc) ? b : c);
+
+    sub[x] = (uint8)(row[x] - a);
+    up[x] = (uint8)(row[x] - b);
+    average[x] = (uint8)(row[x] - ((a + b) >> 1));
+    paeth[x] = (uint8)(row[x] - prediction);
+  }
+
+  const uint8* candidates[5] = { row, sub, up, average, paeth };
+
+  size_t bestFilter = 0;
+  uint32 bestSum = 0xFFFFFFFF;
+  for (size_t filter = 0; filter < 5; ++filter) {
+    const uint8* candidate = candidates[filter];
+
+    uint32 sum = 0;
+    for (size_t x = 0; x < length; ++x) {
+      const int32 residual = (int8)candidate[x];
+      sum += (uint32)abs(residual);
+    }
+
+    if (sum < bestSum) {
+      bestSum = sum;
+      bestFilter = filter;
+    }
+  }
+
+  dest[0] = (uint8)bestFilter;
+  memcpy(dest + 1, candidates[bestFilter], length);
+}
+
+struct PngBitWriter {
+  uint8* out;
+  uint64 buffer;
+  size_t count;
+};
+
+static FORCE_INLINE void PutBits(PngBitWriter& writer, uint32 bits, size_t count) {
+  writer.buffer |= ((uint64)bits) << writer.count;
+  writer.count += count;
+
+  if (writer.count >= 32) {
+    const uint32 word = (uint32)writer.buffer;
+    memcpy(writer.out, &word, sizeof(word));
+    writer.out += sizeof(word);
+    writer.buffer >>= 32;
+    writer.count -= 32;
+  }
+}
 
-          int64 aboveIndex = (((int64)outputRowIndex) - ((int64)mStride));
-          uint32 above = (aboveIndex < 0) ? 0 : outputImage[aboveIndex + x];
+static uint32 ReverseCode(uint32 code, size_t length) {
+  uint32 reversed = 0;
+  for (size_t i = 0; i < length; ++i, code >>= 1) {
+    reversed = (reversed << 1) | (code & 1);
+  }
+
+  return reversed;
+}
+
+static uint32 HighestBit(uint32 value) {
+  uint32 bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+
+  return bit;
+}
 
-          int64 prevIndex = x - mChannels;
-          uint32 prev = (prevIndex < 0) ? 0 : outputImage[outputRowIndex + prevIndex];
+/*
+Single fixed Huffman block, greedy LZ77 with one hash probe per position.
+Most of the win on rendered images is runs and repeated rows, a proper match finder costs far more than it saves here.
+dest must hold at least length + (length / 4) + 16 bytes, returns the number of bytes written.
+*/
+static size_t DeflateFixed(const uint8* data, size_t length, uint8* dest) {
+  const size_t HashBits = 15;
+  const size_t WindowSize = 32768;
+  const size_t MinMatch = 4;
+  const size_t MaxMatch = 258;
+
+  // Fixed literal/length codes (RFC1951 3.2.6), stored bit reversed since DEFLATE writes codes from the top bit.
+  uint16 literalCodes[288];
+  uint8 literalLengths[288];
+  for (uint32 i = 0; i < 288; ++i) {
+    if (i < 144) {
+      literalLengths[i] = 8;
+      literalCodes[i] = (uint16)ReverseCode(0x30 + i, 8);
+    }
+    else if (i < 256) {
+      literalLengths[i] = 9;
+      literalCodes[i] = (uint16)ReverseCode(0x190 + (i - 144), 9);
+    }
+    else if (i < 280) {
+      literalLengths[i] = 7;
+      literalCodes[i] = (uint16)ReverseCode(i - 256, 7);
+    }
+    else {
+      literalLengths[i] = 8;
+      literalCodes[i] = (uint16)ReverseCode(0xC0 + (i - 280), 8);
+    }
+  }
 
-          outputImage[outputRowIndex + x] = (uint8)(((int64)image[rowData + x] + PaethPredictor((int64)prev, (int64)above, (int64)priorAbove)) % 256);
+  uint8 distanceCodes[30];
+  for (uint32 i = 0; i < 30; ++i) {
+    distanceCodes[i] = (uint8)ReverseCode(i, 5);
+  }
+
+  uint32* hashTable = static_cast<uint32*>(PlatformCalloc(sizeof(uint32) * (1 << HashBits)));
+
+  PngBitWriter writer = { dest, 0, 0 };
+
+  // Final block, fixed codes.
+  PutBits(writer, 1, 1);
+  PutBits(writer, 1, 2);
+
+  size_t i = 0;
+  while (i < length) {
+    size_t matchLength = 0;
+    size_t matchDistance = 0;
+
+    if ((i + MinMatch) <= length) {
+      uint32 sequence = 0;
+      memcpy(&sequence, data + i, sizeof(sequence));
+      const uint32 hash = (sequence * 2654435761U) >> (32 - HashBits);
+
+      // Positions are stored off by one so zero means empty.
+      const size_t candidate = hashTable[hash];
+      hashTable[hash] = (uint32)(i + 1);
+
+      if ((candidate != 0) && ((i - (candidate - 1)) <= WindowSize)) {
+        const uint8* match = data + candidate - 1;
+        uint32 matchSequence = 0;
+        memcpy(&matchSequence, match, sizeof(matchSequence));
+
+        if (matchSequence == sequence) {
+          const size_t maxLength = ((length - i) < MaxMatch) ? (length - i) : MaxMatch;
+          size_t extent = MinMatch;
+
+          for (; (extent + 8) <= maxLength; extent += 8) {
+            uint64 x = 0;
+            uint64 y = 0;
+            memcpy(&x, data + i + extent, sizeof(x));
+            memcpy(&y, match + extent, sizeof(y));
+            if (x != y) {
+              break;
+            }
+          }
+
+          while ((extent < maxLength) && (data[i + extent] == match[extent])) {
+            ++extent;
+          }
+
+          matchLength = extent;
+          matchDistance = i - (candidate - 1);
         }
       }
-        break;
-      default:
-        PlatformFree(outputImage);
-        PlatformFree(image);
-        ZAssert(false);
-        return nullptr;
     }
+
+    if (matchLength == 0) {
+      const uint8 literal = data[i];
+      PutBits(writer, literalCodes[literal], literalLengths[literal]);
+      ++i;
+      continue;
+    }
+
+    // Length codes 257..284 cover four lengths per extra bit size, 258 gets its own code.
+    const uint32 lengthValue = (uint32)(matchLength - 3);
+    uint32 lengthSymbol = 0;
+    uint32 lengthExtraBits = 0;
+    if (matchLength == MaxMatch) {
+      lengthSymbol = 285;
+    }
+    else if (lengthValue < 8) {
+      lengthSymbol = 257 + lengthValue;
+    }
+    else {
+      const uint32 top = HighestBit(lengthValue);
+      lengthExtraBits = top - 2;
+      lengthSymbol = 257 + (4 * (top - 1)) + ((lengthValue >> lengthExtraBits) & 3);
+    }
+
+    PutBits(writer, literalCodes[lengthSymbol] | ((lengthValue & ((1U << lengthExtraBits) - 1)) << literalLengths[lengthSymbol]),
+      literalLengths[lengthSymbol] + lengthExtraBits);
+
+    // Distance codes work the same way with two codes per extra bit size.
+    const uint32 distanceValue = (uint32)(matchDistance - 1);
+    uint32 distanceSymbol = distanceValue;
+    uint32 distanceExtraBits = 0;
+    if (distanceValue >= 4) {
+      const uint32 top = HighestBit(distanceValue);
+      distanceExtraBits = top - 1;
+      distanceSymbol = (2 * top) + ((distanceValue >> distanceExtraBits) & 1);
+    }
+
+    PutBits(writer, distanceCodes[distanceSymbol] | ((distanceValue & ((1U << distanceExtraBits) - 1)) << 5), 5 + distanceExtraBits);
+
+    i += matchLength;
   }
-  
+
+  // End of block.
+  PutBits(writer, literalCodes[256], literalLengths[256]);
+
+  for (; writer.count > 0; writer.count = (writer.count > 8) ? (writer.count - 8) : 0) {
+    *writer.out++ = (uint8)writer.buffer;
+    writer.buffer >>= 8;
+  }
+
+  PlatformFree(hashTable);
+  return (size_t)(writer.out - dest);
+}
+
+// Splits data up into as many stored blocks as needed, returns the number of bytes written.
+static size_t DeflateStored(const uint8* data, size_t length, uint8* dest) {
+  const size_t MaxStoredBlock = 65535;
+
+  uint8* out = dest;
+  size_t offset = 0;
+  do {
+    const size_t blockLength = ((length - offset) < MaxStoredBlock) ? (length - offset) : MaxStoredBlock;
+    const bool finalBlock = (offset + blockLength) == length;
+
+    *out++ = finalBlock ? 1 : 0;
+    *out++ = (uint8)blockLength;
+    *out++ = (uint8)(blockLength >> 8);
+    *out++ = (uint8)~blockLength;
+    *out++ = (uint8)(~blockLength >> 8);
+    memcpy(out, data + offset, blockLength);
+    out += blockLength;
+    offset += blockLength;
+  } while (offset < length);
+
+  return (size_t)(out - dest);
+}
+
+bool PNG::Save(const FileString& filename, const uint8* pixels, size_t width, size_t height, ChannelOrderPNG order, CompressionPNG compression) {
+  return Encode(filename, pixels, width, height, 4, 3, order, compression);
+}
+
+bool PNG::Save(const FileString& filename, Framebuffer& framebuffer, CompressionPNG compression) {
+  // Alpha isn't meaningful in the framebuffer, leave it out.
+  return Encode(filename, framebuffer.GetBuffer(), framebuffer.GetWidth(), framebuffer.GetHeight(), 4, 3, ChannelOrderPNG::BGR, compression);
+}
+
+bool PNG::Save(const FileString& filename, const Texture& texture, size_t mipLevel, CompressionPNG compression) {
+  // Tiled levels would need untiling first, only linear textures can be written out.
+  if ((mipLevel >= texture.NumMips()) || (texture.Layout() != TextureLayout::Linear)) {
+    return false;
+  }
+
+  // Textures are loaded in display (BGR) order.
+  const size_t channels = texture.Channels();
+  return Encode(filename, texture.Data(mipLevel), texture.Width(mipLevel), texture.Height(mipLevel), channels, channels, ChannelOrderPNG::BGR, compression);
+}
+
+bool PNG::Encode(const FileString& filename, const uint8* pixels, size_t width, size_t height,
+  size_t sourceChannels, size_t channels, ChannelOrderPNG order, CompressionPNG compression) {
+  if ((pixels == nullptr) || (width == 0) || (height == 0) || (sourceChannels < channels) || ((channels != 3) && (channels != 4))) {
+    return false;
+  }
+
+  const size_t stride = width * channels;
+  const size_t filteredStride = stride + 1;
+  const size_t rawLength = filteredStride * height;
+
+  uint8* raw = static_cast<uint8*>(PlatformMalloc(rawLength));
+
+  if (compression == CompressionPNG::Stored) {
+    // Filters only help the compressor, stored rows go out as they are.
+    for (size_t y = 0; y < height; ++y) {
+      uint8* row = raw + (y * filteredStride);
+      row[0] = PngFilter::None;
+      PackScanline(pixels + (y * width * sourceChannels), row + 1, width, sourceChannels, channels, order);
+    }
+  }
+  else {
+    // Two packed rows (current and above) followed by scratch space for four filtered candidates.
+    uint8* rows = static_cast<uint8*>(PlatformCalloc(stride * 6));
+    uint8* current = rows;
+    uint8* above = rows + stride;
+    uint8* scratch = rows + (stride * 2);
+
+    for (size_t y = 0; y < height; ++y) {
+      PackScanline(pixels + (y * width * sourceChannels), current, width, sourceChannels, channels, order);
+      FilterScanline(current, above, stride, channels, scratch, raw + (y * filteredStride));
+      Swap(current, above);
+    }
+
+    PlatformFree(rows);
+  }
+
+  // zlib header, the DEFLATE stream and the Adler32 of the filtered image.
+  const size_t MaxStoredBlock = 65535;
+  const size_t numBlocks = (rawLength + MaxStoredBlock - 1) / MaxStoredBlock;
+  const size_t storedLength = (numBlocks * 5) + rawLength;
+  const size_t maxLength = 2 + rawLength + (rawLength / 4) + 16 + 4;
+  uint8* zlib = static_cast<uint8*>(PlatformMalloc((maxLength > (storedLength + 6)) ? maxLength : (storedLength + 6)));
+
+  zlib[0] = 0x78;
+  zlib[1] = 0x01;
+
+  size_t deflateLength = 0;
+  if (compression == CompressionPNG::Fast) {
+    deflateLength = DeflateFixed(raw, rawLength, zlib + 2);
+  }
+
+  // Noise can come out larger than it went in, fall back to stored blocks when it does.
+  if ((compression == CompressionPNG::Stored) || (deflateLength > storedLength)) {
+    deflateLength = DeflateStored(raw, rawLength, zlib + 2);
+  }
+
+  const size_t zlibLength = 2 + deflateLength + 4;
+  WriteBigEndian(zlib + 2 + deflateLength, Unaligned_Adler32(raw, rawLength, 1));
+  PlatformFree(raw);
+
+  uint8 header[13];
+  WriteBigEndian(header, (uint32)width);
+  WriteBigEndian(header + 4, (uint32)height);
+  header[8] = 8; // Bit depth
+  header[9] = (channels == 4) ? 6 : 2; // Truecolor, with or without alpha
+  header[10] = 0; // Compression
+  header[11] = 0; // Filter
+  header[12] = 0; // Interlace
+
+  const uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+  SystemBufferedFileWriter writer(filename, 0);
+  const bool written = writer.IsOpen()
+    && writer.Write(signature, sizeof(signature))
+    && WriteChunk(writer, "IHDR", header, sizeof(header))
+    && WriteChunk(writer, "IDAT", zlib, zlibLength)
+    && WriteChunk(writer, "IEND", nullptr, 0);
+
+  PlatformFree(zlib);
+  return written;
+}
+
+uint8* PNG::FilterDeflatedImage(uint8* image) {
+  const size_t filteredStride = mStride + 1;
+  const size_t bytesPerPixel = (mBitsPerPixel + 7) / 8;
+
+  uint8* outputImage = static_cast<uint8*>(PlatformMalloc(mStride * mHeight));
+
+  // The scan line above the first one is treated as all zeros.
+  uint8* zeroRow = static_cast<uint8*>(PlatformCalloc(mStride));
+
+  for (size_t i = 0; i < mHeight; ++i) {
+    const size_t rowIndex = filteredStride * i;
+    const size_t outputRowIndex = mStride * i;
+    const uint8 filterMethod = image[rowIndex];
+
+    if (filterMethod > PngFilter::Paeth) {
+      PlatformFree(zeroRow);
+      PlatformFree(outputImage);
+      PlatformFree(image);
+      ZAssert(false);
+      return nullptr;
+    }
+
+    const uint8* above = (i == 0) ? zeroRow : (outputImage + outputRowIndex - mStride);
+    PNGUnfilterRowImpl(filterMethod, image + rowIndex + 1, above, outputImage + outputRowIndex, mStride, bytesPerPixel);
+  }
+
+  PlatformFree(zeroRow);
   PlatformFree(image);
   return outputImage;
 }
@@ -12,6 +12,14 @@ enum class ChannelOrderPNG : size_t {
   BGR
 };
 
+enum class CompressionPNG : size_t {
+  Stored, // No compression, fastest to write.
+  Fast // Filtered rows with a single pass of LZ77 and the fixed DEFLATE codes.
+};
+
+class Framebuffer;
+class Texture;
+
 class PNG final {
   public:
 
@@ -40,6 +48,16 @@ class PNG final {
 
   size_t GetBitsPerPixel() const;
 
+  // Writes 4 byte pixels out as an 8 bit RGB image, order is the channel order of the source pixels.
+  static bool Save(const FileString& filename, const uint8* pixels, size_t width, size_t height, ChannelOrderPNG order,
+    CompressionPNG compression = CompressionPNG::Fast);
+
+  // Writes the framebuffer out as an 8 bit RGB image.
+  static bool Save(const FileString& filename, Framebuffer& framebuffer, CompressionPNG compression = CompressionPNG::Fast);
+
+  // Writes one mip level out, 4 channel textures keep their alpha.
+  static bool Save(const FileString& filename, const Texture& texture, size_t mipLevel, CompressionPNG compression = CompressionPNG::Fast);
+
   private:
   MemoryMappedFileReader mReader;
   uint8* mDataPtr = nullptr;
@@ -51,16 +69,31 @@ class PNG final {
   size_t mBitsPerPixel = 0;
   size_t mChannels = 0;
   size_t mDataOffset = 0; // Used to index into the file data.
-  size_t mBitOffset = 0; // Used to index into the Deflate stream.
 
-  uint8* mChunkedIDATData = nullptr;
-  size_t mOutputIndex = 0;
+  // Codes up to this many bits are resolved with a single table lookup.
+  static constexpr size_t HuffmanFastBits = 10;
 
   struct PngHuffman {
-    uint16 codes[16];
-    uint16 symbols[286];
+    uint16 fast[1 << HuffmanFastBits]; // (length << 9) | symbol, indexed by the next bits of the stream. Zero for longer codes.
+    uint32 maxCode[17]; // One past the last code of each length, left aligned to 16 bits.
+    uint16 firstCode[16];
+    uint16 firstSymbol[16];
+    uint16 symbols[288];
+  };
+
+  // Bits are consumed from the bottom of buffer, offset counts the bytes that have been shifted into it.
+  // Reading past length shifts in zeros so a truncated stream fails to decode instead of reading out of bounds.
+  struct PngBitStream {
+    const uint8* data;
+    size_t length;
+    size_t offset;
+    uint64 buffer;
+    size_t count;
   };
 
+  PngBitStream mBits = {};
+  size_t mOutputIndex = 0;
+
   enum PngFilter {
     None = 0,
     Sub = 1,
@@ -69,27 +102,32 @@ class PNG final {
     Paeth = 4
   };
 
-  int64 PaethPredictor(int64 left, int64 above, int64 aboveLeft);
-
   const uint8* DataOffset();
 
-  const uint8* DataBitOffset();
-
   bool ReadHeader();
 
   void IdentifyChunk(uint32& length, uint32& type);
 
-  uint32 ReadBits(size_t count);
+  static void RefillBits(PngBitStream& bits);
+
+  static uint32 ReadBits(PngBitStream& bits, size_t count);
+
+  bool CopyStoredBlock(uint8* output);
+
+  bool DecodeFixedHuffman(uint8* output);
 
   bool DecodeDynamicHuffman(uint8* output);
 
-  bool BuildHuffman(PngHuffman& huffman, uint16* lengths, int32 count);
+  bool BuildHuffman(PngHuffman& huffman, const uint16* lengths, int32 count);
 
-  bool DecodeSymbol(const PngHuffman& huffman, uint32& symbol);
+  static bool DecodeSymbol(const PngHuffman& huffman, PngBitStream& bits, uint32& symbol);
 
   bool DeflateStream(uint8* output, const PngHuffman& lengthHuff, const PngHuffman& distHuff);
 
   uint8* FilterDeflatedImage(uint8* image);
+
+  static bool Encode(const FileString& filename, const uint8* pixels, size_t width, size_t height,
+    size_t sourceChannels, size_t channels, ChannelOrderPNG order, CompressionPNG compression);
 };
 
 }
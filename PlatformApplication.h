@@ -5,7 +5,7 @@
 
 namespace ZSharp {
 
-enum class AppCursor : uint8_t {
+enum class AppCursor : uint8 {
   Arrow,
   Hand
 };
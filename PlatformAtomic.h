@@ -4,6 +4,21 @@
 
 namespace ZSharp {
 
+// Returns the resulting value.
+int32 PlatformAtomicIncrement(volatile int32* value);
+
+// Returns the resulting value.
+int32 PlatformAtomicDecrement(volatile int32* value);
+
+// Returns the resulting value.
+int32 PlatformAtomicAdd(volatile int32* value, int32 amount);
+
+// Returns the initial value, the exchange only happens if it was equal to comparand.
+int64 PlatformAtomicCompareExchange(volatile int64* value, int64 exchange, int64 comparand);
+
+// Full fence, no loads or stores can be reordered across it.
+void PlatformMemoryFence();
+
 class PlatformSemaphore final {
   public:
 
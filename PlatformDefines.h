@@ -4,6 +4,10 @@
 
 #define FORCE_INLINE __forceinline
 
+#elif defined(__GNUC__)
+
+#define FORCE_INLINE inline __attribute__((always_inline))
+
 #else
 
 #define FORCE_INLINE
@@ -118,6 +118,28 @@ void Unaligned_GenerateMipLevel_SSE(uint8* __restrict nextMip, size_t nextWidth,
 
 void Unaligned_GenerateMipLevel_AVX(uint8* __restrict nextMip, size_t nextWidth, size_t nextHeight, uint8* __restrict lastMip, size_t lastWidth, size_t lastHeight);
 
+/*
+Reverses the filter on one PNG scanline.
+filter is the type byte at the start of the scanline, above is the previous unfiltered scanline or zeros for the first one.
+bpp is the size of a pixel in bytes, length is the size of the scanline in bytes without the type byte.
+*/
+typedef void (*PNGUnfilterRowFunc)(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp);
+
+extern PNGUnfilterRowFunc PNGUnfilterRowImpl;
+
+void Unaligned_PNGUnfilterRow_SSE(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp);
+
+void Unaligned_PNGUnfilterRow_AVX(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp);
+
+// Continues a CRC-32 (zlib/PNG polynomial), crc is the running value before the final inversion.
+uint32 Unaligned_CRC32(const uint8* data, size_t length, uint32 crc);
+
+// Continues an Adler-32 checksum, start from 1.
+uint32 Unaligned_Adler32(const uint8* data, size_t length, uint32 adler);
+
+// Offset of the first newline in data, length if there isn't one.
+size_t Unaligned_FindNewline(const char* data, size_t length);
+
 typedef void (*DrawDebugTextFunc)(const uint8 lut[128][8], const String& message, size_t x, size_t y, uint8* buffer, size_t width, const ZColor& color);
 
 extern DrawDebugTextFunc DrawDebugTextImpl;
@@ -128,6 +150,9 @@ void Unaligned_DrawDebugText_AVX(const uint8 lut[128][8], const String& message,
 
 void Aligned_Mat4x4Transform(const float matrix[4][4], float* __restrict data, int32 stride, int32 length);
 
+// Transforms the position of each vertex in source while copying the remaining attributes to dest.
+void Aligned_Mat4x4TransformCopy(const float matrix[4][4], const float* __restrict source, float* __restrict dest, int32 stride, int32 length);
+
 typedef void (*DepthBufferVisualizeFunc)(float* buffer, size_t width, size_t height);
 
 extern DepthBufferVisualizeFunc DepthBufferVisualizeImpl;
@@ -170,26 +195,74 @@ bool Unaligned_AABB_Intersects(const float* aMin, const float* aMax, const float
 
 void Unaligned_AABB_TransformAndRealign(const float* inMin, const float* inMax, float* outMin, float* outMax, const float* matrix);
 
+/*
+Classifies world space boxes against six frustum planes, 4 (SSE) or 8 (AVX) boxes at a time.
+Boxes are passed as one array per component of their min/max corners, any count is allowed.
+A point is inside of a plane when dot(plane.xyz, point) + plane.w > 0, planes[0] must be the near plane.
+outClip receives one of the Frustum* values per box.
+*/
+static constexpr int32 FrustumInside = 0;
+static constexpr int32 FrustumOutside = 1;
+static constexpr int32 FrustumClippedNear = 2;
+static constexpr int32 FrustumClippedNDC = 3;
+
+typedef void (*FrustumCullAABBFunc)(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t count, int32* __restrict outClip);
+
+extern FrustumCullAABBFunc FrustumCullAABBImpl;
+
+void Unaligned_FrustumCullAABB_SSE(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t count, int32* __restrict outClip);
+
+void Unaligned_FrustumCullAABB_AVX(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t count, int32* __restrict outClip);
+
+// The coarse depth buffer keeps the farthest depth of each HiZBlockSize x HiZBlockSize block of pixels.
+static constexpr int32 HiZBlockShift = 3;
+static constexpr int32 HiZBlockSize = 1 << HiZBlockShift;
+
+/*
+Triangle raster kernels.
+tileBounds is the scissor rectangle [minX, minY, maxX, maxY) in pixels, only pixels inside of it are touched.
+minX must be a multiple of 8 and maxX must either be a multiple of 8 or the width of the framebuffer.
+hiZ is the coarse depth buffer, whole triangles and blocks behind it are skipped and fully covered blocks are pushed forward.
+*/
 typedef void (*RGBShaderFunc)(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const int32 tileBounds[4]);
 
 extern RGBShaderFunc RGBShaderImpl;
 
 void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const int32 tileBounds[4]);
 
 void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const int32 tileBounds[4]);
 
 typedef void (*UVShaderFunc)(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, const Texture* __restrict texture, size_t mipLevel);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
 
 extern UVShaderFunc UVShaderImpl;
 
+extern UVShaderFunc UVBilinearShaderImpl;
+
+extern UVShaderFunc UVTrilinearShaderImpl;
+
 void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, const Texture* __restrict texture, size_t mipLevel);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
 
 void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
-  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, const Texture* __restrict texture, size_t mipLevel);
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
+
+void Unaligned_Shader_UV_Bilinear_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
+
+void Unaligned_Shader_UV_Bilinear_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
+
+void Unaligned_Shader_UV_Trilinear_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
+
+void Unaligned_Shader_UV_Trilinear_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end,
+  const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]);
 
 }
@@ -0,0 +1,44 @@
+#include "ProfilerThreads.h"
+
+#include "Logger.h"
+#include "PlatformAtomic.h"
+#include "PlatformHAL.h"
+
+namespace ZSharp {
+
+// Threads outside of the pool, e.g. audio and the logger.
+static constexpr size_t ExtraProfilerThreads = 8;
+
+static constexpr int32 UnclaimedSlot = -2;
+
+static volatile int32 NextThreadSlot = 1;
+static thread_local int32 CurrentThreadSlot = UnclaimedSlot;
+
+size_t ProfilerMaxThreads() {
+  static const size_t maxThreads = 1 + PlatformGetNumLogicalCores() + ExtraProfilerThreads;
+  return maxThreads;
+}
+
+void ProfilerRegisterMainThread() {
+  CurrentThreadSlot = 0;
+}
+
+int32 ProfilerThreadSlot() {
+  if (CurrentThreadSlot == UnclaimedSlot) {
+    const int32 slot = PlatformAtomicIncrement(&NextThreadSlot) - 1;
+    if (slot < (int32)ProfilerMaxThreads()) {
+      CurrentThreadSlot = slot;
+    }
+    else {
+      // Set before logging, the logger may record timers of its own.
+      CurrentThreadSlot = -1;
+      if (GlobalLog != nullptr) {
+        GlobalLog->Log(LogCategory::Warning, String::FromFormat("Profiler has no slot left for this thread, its samples are dropped. {0} slots in use.\n", ProfilerMaxThreads()));
+      }
+    }
+  }
+
+  return CurrentThreadSlot;
+}
+
+}
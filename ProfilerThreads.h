@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+namespace ZSharp {
+
+/*
+Slots for the per thread tables in ScopedTimer and TraceEvents.
+There is room for every logical core plus a few threads outside of the pool.
+Slot 0 is held for the main thread, so workers that record first can't push it out.
+*/
+size_t ProfilerMaxThreads();
+
+// Call from the main thread, it gets slot 0 from here on.
+void ProfilerRegisterMainThread();
+
+// Slot of the calling thread, claimed on first use. Returns -1 once the slots run out, which is logged for each thread turned away.
+int32 ProfilerThreadSlot();
+
+}
@@ -19,20 +19,36 @@
 #include <cstring>
 
 namespace ZSharp {
+template<typename T>
+static void GrowToFit(Array<T>& arr, size_t count) {
+  if (arr.Size() < count) {
+    arr.Resize(count * 2);
+  }
+}
+
 ConsoleVariable<int32> DevRenderMode("RenderMode", 1);
 
 ConsoleVariable<bool> VisualizeAABB("VizAABB", false);
 
-ConsoleVariable<int32> MipOverride("MipOverride", 4);
+// Negative lets the shader pick a level for each triangle, anything else forces that level.
+ConsoleVariable<int32> MipOverride("MipOverride", -1);
 
 ConsoleVariable<ZColor> WireframeColor("WireframeColor", ZColor(ZColors::GREEN));
 
+ConsoleVariable<bool> TiledRaster("TiledRaster", true);
+
+ConsoleVariable<bool> OcclusionCulling("OcclusionCulling", true);
+
+ConsoleVariable<int32> OcclusionOccluders("OcclusionOccluders", 4);
+
+ConsoleVariable<bool> ProjectionCache("ProjectionCache", true);
+
 Renderer::Renderer() {
   mAABBVertexBuffer.Resize(8 * 4, 4);
   mAABBIndexBuffer.Resize(12 * 3);
 }
 
-void Renderer::RenderNextFrame(World& world, Camera& camera) {
+void Renderer::RenderNextFrame(World& world, Camera& camera, ThreadPool& threadPool) {
   NamedScopedTimer(RenderFrame);
 
   if (*DevRenderMode) {
@@ -43,47 +59,183 @@ void Renderer::RenderNextFrame(World& world, Camera& camera) {
   }
 
   mDepthBufferDirty = false;
+  mRenderedTriangles = 0;
 
-  for (size_t i = 0; i < world.GetTotalModels(); ++i) {
-    Model& model = world.GetModels()[i];
+  const bool tiled = (mRenderMode == RenderMode::FILL) && *TiledRaster;
+  if (tiled) {
+    mTiledRasterizer.Begin(mFramebuffer.GetWidth(), mFramebuffer.GetHeight());
+  }
+
+  const size_t numModels = world.GetTotalModels();
+  if (mVisibility.Size() != numModels) {
+    mVisibility.Resize(numModels);
+  }
+
+  if (mProjectionCache.Size() != numModels) {
+    mProjectionCache.Resize(numModels);
+  }
+
+  const bool occlusion = (mRenderMode == RenderMode::FILL) && *OcclusionCulling;
+
+  size_t numVisible = 0;
+  size_t numPartial = 0;
+  {
+    NamedScopedTimer(FrustumCull);
+
+    // Whole subtrees inside of the frustum are accepted as is, only the leaves crossing a plane need testing.
+    float planes[6][4];
+    camera.GetFrustumPlanes(planes);
+    world.GetModelHierarchy().CullFrustum(planes, mVisibleModels, numVisible, mPartialModels, numPartial);
+
+    for (size_t i = 0; i < numVisible; ++i) {
+      mVisibility[mVisibleModels[i]].clipBounds = ClipBounds::Inside;
+    }
+
+    if (mBoxBounds.Size() < (numPartial * 6)) {
+      mBoxBounds.Resize(numPartial * 6);
+    }
+
+    if (mClipBounds.Size() < numPartial) {
+      mClipBounds.Resize(numPartial);
+    }
+
+    if (numPartial > 0) {
+      // Laid out as separate min/max arrays per axis so the partial models can be classified in one batch.
+      float* boxBounds = mBoxBounds.GetData();
+      const float* boxMin[3] = { boxBounds, boxBounds + numPartial, boxBounds + (numPartial * 2) };
+      const float* boxMax[3] = { boxBounds + (numPartial * 3), boxBounds + (numPartial * 4), boxBounds + (numPartial * 5) };
+
+      const Array<AABB>& modelBounds = world.GetModelBounds();
+      for (size_t i = 0; i < numPartial; ++i) {
+        const AABB& aabb = modelBounds[mPartialModels[i]];
+
+        for (size_t axis = 0; axis < 3; ++axis) {
+          boxBounds[(axis * numPartial) + i] = aabb.MinBounds()[axis];
+          boxBounds[((axis + 3) * numPartial) + i] = aabb.MaxBounds()[axis];
+        }
+      }
+
+      camera.ClipBoundsCheck(boxMin, boxMax, numPartial, mClipBounds.GetData());
+    }
+
+    for (size_t i = 0; i < numPartial; ++i) {
+      if (mClipBounds[i] != ClipBounds::Outside) {
+        mVisibility[mPartialModels[i]].clipBounds = mClipBounds[i];
+        GrowToFit(mVisibleModels, numVisible + 1);
+        mVisibleModels[numVisible] = mPartialModels[i];
+        ++numVisible;
+      }
+    }
+  }
+
+  for (size_t v = 0; v < numVisible; ++v) {
+    const int32 i = mVisibleModels[v];
+    ModelVisibility& visibility = mVisibility[i];
+    const AABB& aabb = world.GetModelBounds()[i];
+    const ClipBounds clipBounds = visibility.clipBounds;
+
+    if (*VisualizeAABB) {
+      Mat4x4 identity;
+      identity.Identity();
 
-    const AABB aabb(AABB::TransformAndRealign(model.BoundingBox(), model.ObjectTransform()));
-    ClipBounds clipBounds;
-    {
       mAABBVertexBuffer.Reset();
       mAABBIndexBuffer.Reset();
       TriangulateAABB(aabb, mAABBVertexBuffer, mAABBIndexBuffer, false);
+      camera.PerspectiveProjection(mAABBVertexBuffer, mAABBIndexBuffer, clipBounds, identity);
+      WireframeShader(mFramebuffer, mAABBVertexBuffer, mAABBIndexBuffer, mAABBVertexBuffer.WasClipped(), *WireframeColor);
+    }
 
-      Mat4x4 identity;
-      identity.Identity();
+    visibility.prepared = false;
+    visibility.occluder = false;
+    visibility.screenValid = false;
+    visibility.screenArea = 0.f;
 
-      clipBounds = camera.ClipBoundsCheck(mAABBVertexBuffer, mAABBIndexBuffer, identity);
+    if (occlusion && (clipBounds != ClipBounds::Outside)) {
+      visibility.screenValid = camera.ProjectAABB(aabb, visibility.screenMin, visibility.screenMax, visibility.nearestDepth);
 
-      if (*VisualizeAABB) {
-        mAABBVertexBuffer.Reset();
-        mAABBIndexBuffer.Reset();
-        TriangulateAABB(aabb, mAABBVertexBuffer, mAABBIndexBuffer, false);
-        camera.PerspectiveProjection(mAABBVertexBuffer, mAABBIndexBuffer, clipBounds, identity);
-        WireframeShader(mFramebuffer, mAABBVertexBuffer, mAABBIndexBuffer, mAABBVertexBuffer.WasClipped(), *WireframeColor);
+      if (visibility.screenValid) {
+        visibility.screenArea = (visibility.screenMax[0] - visibility.screenMin[0]) * (visibility.screenMax[1] - visibility.screenMin[1]);
       }
     }
+  }
 
-    if (clipBounds == ClipBounds::Outside) {
-      continue;
+  if (occlusion) {
+    NamedScopedTimer(OcclusionOccluders);
+
+    mOcclusionBuffer.Begin(mFramebuffer.GetWidth(), mFramebuffer.GetHeight());
+
+    // The models covering the most screen space make the best occluders.
+    for (int32 occluder = 0; occluder < *OcclusionOccluders; ++occluder) {
+      size_t largest = numModels;
+      for (size_t v = 0; v < numVisible; ++v) {
+        const size_t i = mVisibleModels[v];
+        const ModelVisibility& visibility = mVisibility[i];
+        if (visibility.screenValid && !visibility.occluder
+          && ((largest == numModels) || (visibility.screenArea > mVisibility[largest].screenArea))) {
+          largest = i;
+        }
+      }
+
+      if (largest == numModels) {
+        break;
+      }
+
+      ModelVisibility& visibility = mVisibility[largest];
+      visibility.occluder = true;
+
+      VertexBuffer& vertexBuffer = world.GetVertexBuffers()[largest];
+      IndexBuffer& indexBuffer = world.GetIndexBuffers()[largest];
+      PrepareModel(world.GetModels()[largest], vertexBuffer, indexBuffer, camera, visibility.clipBounds, mProjectionCache[largest]);
+      visibility.prepared = true;
+
+      const float* vertexData;
+      const int32* indexData;
+      int32 end;
+      GetScreenData(vertexBuffer, indexBuffer, vertexData, indexData, end);
+      mOcclusionBuffer.RasterOccluder(vertexData, indexData, end);
     }
+  }
+
+  const size_t mipLevel = (*MipOverride < 0) ? AutoMipLevel : (size_t)*MipOverride;
+
+  for (size_t v = 0; v < numVisible; ++v) {
+    const int32 i = mVisibleModels[v];
+    Model& model = world.GetModels()[i];
+    const ModelVisibility& visibility = mVisibility[i];
 
     VertexBuffer& vertexBuffer = world.GetVertexBuffers()[i];
     IndexBuffer& indexBuffer = world.GetIndexBuffers()[i];
 
-    vertexBuffer.Reset();
-    indexBuffer.Reset();
+    if (occlusion && visibility.screenValid && !visibility.occluder
+      && mOcclusionBuffer.IsOccluded(visibility.screenMin, visibility.screenMax, visibility.nearestDepth)) {
+      // The buffers are left alone so a cached projection can still be used once the model shows up again.
+      continue;
+    }
 
-    model.FillBuffers(vertexBuffer, indexBuffer);
+    if (!visibility.prepared) {
+      PrepareModel(model, vertexBuffer, indexBuffer, camera, visibility.clipBounds, mProjectionCache[i]);
+    }
 
-    camera.PerspectiveProjection(vertexBuffer, indexBuffer, clipBounds, model.ObjectTransform());
+    // Culled and occluded models keep their cached buffers, so only what gets this far is counted.
+    mRenderedTriangles += (vertexBuffer.WasClipped() ? indexBuffer.GetClipLength() : indexBuffer.GetIndexSize()) / 3;
 
     const ShaderDefinition& shader = model.GetMesh().GetShader();
 
+    if (tiled) {
+      const float* vertexData;
+      const int32* indexData;
+      int32 end;
+      GetScreenData(vertexBuffer, indexBuffer, vertexData, indexData, end);
+
+      const Texture* texture = nullptr;
+      if (shader.GetShadingMethod() == ShadingMethod::UV) {
+        texture = GlobalTexturePool->GetTexture(model.GetMesh().TextureId());
+      }
+
+      mTiledRasterizer.BinTriangles(vertexData, indexData, end, shader.GetShadingMethod(), texture, shader.GetTextureFilter(), mipLevel);
+      continue;
+    }
+
     switch (mRenderMode) {
       case RenderMode::FILL:
       {
@@ -96,7 +248,7 @@ void Renderer::RenderNextFrame(World& world, Camera& camera) {
           case ShadingMethod::UV:
           {
             Texture* texture = GlobalTexturePool->GetTexture(model.GetMesh().TextureId());
-            TextureMappedShader(mFramebuffer, mDepthBuffer, vertexBuffer, indexBuffer, vertexBuffer.WasClipped(), texture, *MipOverride);
+            TextureMappedShader(mFramebuffer, mDepthBuffer, vertexBuffer, indexBuffer, vertexBuffer.WasClipped(), texture, shader.GetTextureFilter(), mipLevel);
           }
           break;
           default:
@@ -111,6 +263,49 @@ void Renderer::RenderNextFrame(World& world, Camera& camera) {
         break;
     }
   }
+
+  if (tiled) {
+    NamedScopedTimer(TiledRaster);
+    mTiledRasterizer.Raster(threadPool, mFramebuffer, mDepthBuffer);
+  }
+}
+
+void Renderer::PrepareModel(Model& model, VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, Camera& camera, ClipBounds clipBounds, CachedProjection& cache) {
+  const Mat4x4 objectTransform(model.ObjectTransform());
+
+  // An empty buffer means it was reset or reallocated since the projection was cached.
+  if (*ProjectionCache
+    && (cache.projectionVersion == camera.GetProjectionVersion())
+    && (cache.clipBounds == clipBounds)
+    && (vertexBuffer.GetVertSize() > 0)
+    && (memcmp(*cache.objectTransform, *objectTransform, sizeof(float) * 16) == 0)) {
+    return;
+  }
+
+  vertexBuffer.Reset();
+  indexBuffer.Reset();
+
+  // Vertices are transformed on their way out of the mesh instead of being copied and then transformed in place.
+  model.FillBuffers(vertexBuffer, indexBuffer, camera.GetPerspectiveTransform() * objectTransform);
+
+  camera.ProjectClipSpace(vertexBuffer, indexBuffer, clipBounds);
+
+  cache.objectTransform = objectTransform;
+  cache.projectionVersion = camera.GetProjectionVersion();
+  cache.clipBounds = clipBounds;
+}
+
+void Renderer::GetScreenData(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const float*& vertexData, const int32*& indexData, int32& end) {
+  if (vertexBuffer.WasClipped()) {
+    vertexData = vertexBuffer.GetClipData(0);
+    indexData = indexBuffer.GetClipData(0);
+    end = indexBuffer.GetClipLength();
+  }
+  else {
+    vertexData = vertexBuffer[0];
+    indexData = indexBuffer.GetInputData();
+    end = indexBuffer.GetIndexSize();
+  }
 }
 
 uint8* Renderer::GetFrame() {
@@ -157,4 +352,8 @@ DepthBuffer& Renderer::GetDepthBuffer() {
   return mDepthBuffer;
 }
 
+size_t Renderer::GetRenderedTriangles() const {
+  return mRenderedTriangles;
+}
+
 }
@@ -3,6 +3,10 @@
 #include "Camera.h"
 #include "Framebuffer.h"
 #include "DepthBuffer.h"
+#include "Model.h"
+#include "OcclusionBuffer.h"
+#include "ThreadPool.h"
+#include "TiledRasterizer.h"
 #include "World.h"
 #include "ZColor.h"
 
@@ -21,7 +25,7 @@ class Renderer final {
   Renderer(const Renderer&) = delete;
   void operator=(const Renderer&) = delete;
 
-  void RenderNextFrame(World& world, Camera& camera);
+  void RenderNextFrame(World& world, Camera& camera, ThreadPool& threadPool);
 
   uint8* GetFrame();
 
@@ -35,6 +39,9 @@ class Renderer final {
 
   DepthBuffer& GetDepthBuffer();
 
+  // Triangles handed to the rasterizer last frame, after culling, occlusion and clipping.
+  size_t GetRenderedTriangles() const;
+
   private:
   Framebuffer mFramebuffer;
   DepthBuffer mDepthBuffer;
@@ -43,6 +50,41 @@ class Renderer final {
   VertexBuffer mAABBVertexBuffer;
   IndexBuffer mAABBIndexBuffer;
 
+  TiledRasterizer mTiledRasterizer;
+
+  struct ModelVisibility {
+    ClipBounds clipBounds;
+    bool prepared;
+    bool occluder;
+    bool screenValid;
+    float screenMin[2];
+    float screenMax[2];
+    float nearestDepth;
+    float screenArea;
+  };
+
+  Array<ModelVisibility> mVisibility;
+
+  // Screen space vertices stay in the per model buffers between frames.
+  // They're reused as long as the object transform and the camera projection haven't changed.
+  struct CachedProjection {
+    Mat4x4 objectTransform;
+    uint32 projectionVersion = 0;
+    ClipBounds clipBounds = ClipBounds::Outside;
+  };
+
+  Array<CachedProjection> mProjectionCache;
+  Array<int32> mVisibleModels;
+  Array<int32> mPartialModels;
+  Array<float> mBoxBounds;
+  Array<ClipBounds> mClipBounds;
+  OcclusionBuffer mOcclusionBuffer;
+
   bool mDepthBufferDirty = false;
+  size_t mRenderedTriangles = 0;
+
+  void PrepareModel(Model& model, VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, Camera& camera, ClipBounds clipBounds, CachedProjection& cache);
+
+  void GetScreenData(VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, const float*& vertexData, const int32*& indexData, int32& end);
 };
 }
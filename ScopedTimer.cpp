@@ -1,14 +1,190 @@
 #include "ScopedTimer.h"
 
+#include "ConsoleVariable.h"
 #include "Logger.h"
+#include "PlatformAtomic.h"
 #include "PlatformDebug.h"
 #include "PlatformTime.h"
+#include "ProfilerThreads.h"
+#include "TraceEvents.h"
 #include "ZString.h"
 
-#define LOG_SCOPED_TIMERS 1
+#include <cstring>
+
+#define LOG_SCOPED_TIMERS 0
 
 namespace ZSharp {
 
+ConsoleVariable<int32> ProfilerDumpFrames("ProfilerDumpFrames", 120);
+
+// Four buckets per power of two, anything past ~16s lands in the last one.
+static constexpr size_t SubBucketBits = 2;
+static constexpr size_t SubBuckets = 1 << SubBucketBits;
+static constexpr size_t NumBuckets = 96;
+
+static constexpr size_t MaxScopes = 64;
+
+struct ScopeSamples {
+  const char* name;
+  size_t count;
+  size_t totalUs;
+  size_t minUs;
+  size_t maxUs;
+  uint32 histogram[NumBuckets];
+};
+
+// Owned by a single thread, the lock is only ever contended while the main thread merges it.
+struct ScopedTimerTable {
+  PlatformMutex lock;
+  size_t numScopes;
+  ScopeSamples scopes[MaxScopes];
+};
+
+// Only touched by the main thread.
+static ScopedTimerTable FrameTotals;
+static size_t FramesSinceDump = 0;
+
+static size_t BucketIndex(size_t us) {
+  if (us < SubBuckets) {
+    return us;
+  }
+
+  size_t highBit = 0;
+  for (size_t value = us; value > 1; value >>= 1) {
+    ++highBit;
+  }
+
+  const size_t shift = highBit - SubBucketBits;
+  const size_t index = SubBuckets + (shift * SubBuckets) + ((us >> shift) & (SubBuckets - 1));
+  return (index < NumBuckets) ? index : (NumBuckets - 1);
+}
+
+static size_t BucketUpperBound(size_t index) {
+  if (index < SubBuckets) {
+    return index;
+  }
+
+  const size_t shift = (index - SubBuckets) / SubBuckets;
+  const size_t subBucket = (index - SubBuckets) % SubBuckets;
+  const size_t lower = (SubBuckets | subBucket) << shift;
+  return lower + (((size_t)1) << shift) - 1;
+}
+
+static ScopeSamples* FindScope(ScopedTimerTable& table, const char* name) {
+  // Open addressing on the static name pointer, no string compares on the hot path.
+  const size_t start = (((size_t)name) >> 3) % MaxScopes;
+
+  for (size_t i = 0; i < MaxScopes; ++i) {
+    ScopeSamples& scope = table.scopes[(start + i) % MaxScopes];
+
+    if (scope.name == name) {
+      return &scope;
+    }
+    else if (scope.name == nullptr) {
+      memset(&scope, 0, sizeof(ScopeSamples));
+      scope.name = name;
+      scope.minUs = (size_t)-1;
+      ++table.numScopes;
+      return &scope;
+    }
+  }
+
+  return nullptr;
+}
+
+// One per profiler slot, allocated on first use.
+static ScopedTimerTable* ThreadTables() {
+  static ScopedTimerTable* tables = new ScopedTimerTable[ProfilerMaxThreads()]();
+  return tables;
+}
+
+static ScopedTimerTable* GetThreadTable() {
+  const int32 slot = ProfilerThreadSlot();
+  return (slot < 0) ? nullptr : &ThreadTables()[slot];
+}
+
+static void RecordSample(const char* name, size_t us) {
+  ScopedTimerTable* table = GetThreadTable();
+  if (table == nullptr) {
+    return;
+  }
+
+  table->lock.Aquire();
+
+  ScopeSamples* scope = FindScope(*table, name);
+  if (scope != nullptr) {
+    ++scope->count;
+    scope->totalUs += us;
+    scope->minUs = (us < scope->minUs) ? us : scope->minUs;
+    scope->maxUs = (us > scope->maxUs) ? us : scope->maxUs;
+    ++scope->histogram[BucketIndex(us)];
+  }
+
+  table->lock.Release();
+}
+
+static void MergeScope(ScopeSamples& dest, const ScopeSamples& source) {
+  dest.count += source.count;
+  dest.totalUs += source.totalUs;
+  dest.minUs = (source.minUs < dest.minUs) ? source.minUs : dest.minUs;
+  dest.maxUs = (source.maxUs > dest.maxUs) ? source.maxUs : dest.maxUs;
+
+  for (size_t i = 0; i < NumBuckets; ++i) {
+    dest.histogram[i] += source.histogram[i];
+  }
+}
+
+static size_t Percentile(const ScopeSamples& scope, size_t percent) {
+  const size_t rank = ((scope.count * percent) + 99) / 100;
+
+  size_t seen = 0;
+  for (size_t i = 0; i < NumBuckets; ++i) {
+    seen += scope.histogram[i];
+    if ((seen >= rank) && (seen > 0)) {
+      const size_t bound = BucketUpperBound(i);
+      return (bound < scope.minUs) ? scope.minUs : ((bound > scope.maxUs) ? scope.maxUs : bound);
+    }
+  }
+
+  return scope.maxUs;
+}
+
+static void FillStats(const ScopeSamples& scope, ScopedTimerStats& stats) {
+  stats.frames = FramesSinceDump;
+  stats.count = scope.count;
+  stats.totalUs = scope.totalUs;
+  stats.minUs = scope.minUs;
+  stats.maxUs = scope.maxUs;
+  stats.p50Us = Percentile(scope, 50);
+  stats.p95Us = Percentile(scope, 95);
+  stats.p99Us = Percentile(scope, 99);
+}
+
+static void DumpFrameTotals() {
+  String summary(String::FromFormat("Scoped timers over {0} frames:\n", FramesSinceDump));
+
+  for (const ScopeSamples& scope : FrameTotals.scopes) {
+    if ((scope.name == nullptr) || (scope.count == 0)) {
+      continue;
+    }
+
+    ScopedTimerStats stats;
+    FillStats(scope, stats);
+
+    summary.Appendf("  {0}: count={1}, avg={2} us, min={3} us, max={4} us, p50={5} us, p95={6} us, p99={7} us\n",
+      scope.name,
+      stats.count,
+      stats.totalUs / stats.count,
+      stats.minUs,
+      stats.maxUs,
+      stats.p50Us,
+      stats.p95Us,
+      stats.p99Us);
+  }
+
+  GlobalLog->Log(LogCategory::Perf, summary);
+}
+
 ScopedTimer::ScopedTimer(const char* name)
   : mTime(PlatformHighResClock()), mName(name) {
 
@@ -17,11 +193,65 @@ ScopedTimer::ScopedTimer(const char* name)
 ScopedTimer::~ScopedTimer() {
   size_t deltaMicroseconds = PlatformHighResClockDeltaUs(mTime);
 
+  RecordSample(mName, deltaMicroseconds);
+
+  if (TraceIsCapturing()) {
+    TraceRecordEvent(mName, mTime, PlatformHighResClock());
+  }
+
 #if LOG_SCOPED_TIMERS
-  GlobalLog->Log(LogCategory::Perf, String::FromFormat("{0} took {1} us.\n", mName, deltaMicroseconds));
-#else
-  PlatformDebugPrint(String::FromFormat("{0} took {1} us.\n", mName, deltaMicroseconds).Str());
+  GlobalLog->LogDeferred(LogCategory::Perf, "{0} took {1} us.\n", mName, deltaMicroseconds);
 #endif
 }
 
+void ScopedTimerEndFrame() {
+  ScopedTimerTable* tables = ThreadTables();
+  for (size_t i = 0; i < ProfilerMaxThreads(); ++i) {
+    ScopedTimerTable& table = tables[i];
+
+    table.lock.Aquire();
+
+    for (ScopeSamples& scope : table.scopes) {
+      if ((scope.name == nullptr) || (scope.count == 0)) {
+        continue;
+      }
+
+      ScopeSamples* total = FindScope(FrameTotals, scope.name);
+      if (total != nullptr) {
+        MergeScope(*total, scope);
+      }
+
+      // Keep the slot claimed so the owning thread does not have to probe for it again next frame.
+      const char* name = scope.name;
+      memset(&scope, 0, sizeof(ScopeSamples));
+      scope.name = name;
+      scope.minUs = (size_t)-1;
+    }
+
+    table.lock.Release();
+  }
+
+  ++FramesSinceDump;
+
+  const int32 dumpFrames = *ProfilerDumpFrames;
+  if ((dumpFrames > 0) && (FramesSinceDump >= (size_t)dumpFrames)) {
+    DumpFrameTotals();
+    memset(FrameTotals.scopes, 0, sizeof(FrameTotals.scopes));
+    FrameTotals.numScopes = 0;
+    FramesSinceDump = 0;
+  }
+}
+
+bool ScopedTimerQuery(const char* name, ScopedTimerStats& stats) {
+  for (const ScopeSamples& scope : FrameTotals.scopes) {
+    // Identical literals are not guaranteed to share an address across translation units.
+    if ((scope.name != nullptr) && (scope.count > 0) && ((scope.name == name) || (strcmp(scope.name, name) == 0))) {
+      FillStats(scope, stats);
+      return true;
+    }
+  }
+
+  return false;
+}
+
 }
@@ -18,4 +18,23 @@ class ScopedTimer {
   const char* mName;
 };
 
+struct ScopedTimerStats {
+  size_t frames;
+  size_t count;
+  size_t totalUs;
+  size_t minUs;
+  size_t maxUs;
+  size_t p50Us;
+  size_t p95Us;
+  size_t p99Us;
+};
+
+// Merges what every thread has recorded since the last call, a summary is logged every ProfilerDumpFrames frames.
+// Call once per frame from the main thread.
+void ScopedTimerEndFrame();
+
+// Covers the frames since the last summary was logged, percentiles are accurate to the histogram bucket.
+// Main thread only, returns false if the scope has not been recorded in that window.
+bool ScopedTimerQuery(const char* name, ScopedTimerStats& stats);
+
 }
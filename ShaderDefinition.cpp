@@ -2,11 +2,11 @@
 
 namespace ZSharp {
 
-ShaderDefinition::ShaderDefinition() : mAttributeStride(0), mAttributeLength(0), mShadingMethod(ShadingMethod::None) {}
+ShaderDefinition::ShaderDefinition() : mAttributeStride(0), mAttributeLength(0), mShadingMethod(ShadingMethod::None), mTextureFilter(TextureFilter::Bilinear) {}
 
-ShaderDefinition::ShaderDefinition(size_t stride, size_t length, ShadingMethod method) : mAttributeStride(stride), mAttributeLength(length), mShadingMethod(method) {}
+ShaderDefinition::ShaderDefinition(size_t stride, size_t length, ShadingMethod method, TextureFilter filter) : mAttributeStride(stride), mAttributeLength(length), mShadingMethod(method), mTextureFilter(filter) {}
 
-ShaderDefinition::ShaderDefinition(const ShaderDefinition& rhs) : mAttributeStride(rhs.mAttributeStride), mAttributeLength(rhs.mAttributeLength), mShadingMethod(rhs.mShadingMethod) {}
+ShaderDefinition::ShaderDefinition(const ShaderDefinition& rhs) : mAttributeStride(rhs.mAttributeStride), mAttributeLength(rhs.mAttributeLength), mShadingMethod(rhs.mShadingMethod), mTextureFilter(rhs.mTextureFilter) {}
 
 ShadingMethod ShaderDefinition::GetShadingMethod() const {
   return mShadingMethod;
@@ -16,6 +16,14 @@ void ShaderDefinition::SetShadingMethod(ShadingMethod method) {
   mShadingMethod = method;
 }
 
+TextureFilter ShaderDefinition::GetTextureFilter() const {
+  return mTextureFilter;
+}
+
+void ShaderDefinition::SetTextureFilter(TextureFilter filter) {
+  mTextureFilter = filter;
+}
+
 size_t ShaderDefinition::GetAttributeStride() const {
   return mAttributeStride;
 }
@@ -36,12 +44,14 @@ void ShaderDefinition::Serialize(ISerializer& serializer) {
   serializer.Serialize(&mAttributeStride, sizeof(mAttributeStride));
   serializer.Serialize(&mAttributeLength, sizeof(mAttributeLength));
   serializer.Serialize(&mShadingMethod, sizeof(mShadingMethod));
+  serializer.Serialize(&mTextureFilter, sizeof(mTextureFilter));
 }
 
 void ShaderDefinition::Deserialize(IDeserializer& deserializer) {
   deserializer.Deserialize(&mAttributeStride, sizeof(mAttributeStride));
   deserializer.Deserialize(&mAttributeLength, sizeof(mAttributeLength));
   deserializer.Deserialize(&mShadingMethod, sizeof(mShadingMethod));
+  deserializer.Deserialize(&mTextureFilter, sizeof(mTextureFilter));
 }
 
 }
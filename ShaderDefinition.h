@@ -17,17 +17,31 @@ enum class ShadingMethod {
   Normals
 };
 
+/*
+  How UV shaded materials read their texture.
+  Point is nearest texel from the nearest mip, Bilinear blends the 2x2 texels around the sample, Trilinear also blends between two mips.
+*/
+enum class TextureFilter {
+  Point,
+  Bilinear,
+  Trilinear
+};
+
 class ShaderDefinition final : public ISerializable {
   public:
 
   ShaderDefinition();
-  ShaderDefinition(size_t stride, size_t length, ShadingMethod method);
+  ShaderDefinition(size_t stride, size_t length, ShadingMethod method, TextureFilter filter = TextureFilter::Bilinear);
   ShaderDefinition(const ShaderDefinition& rhs);
 
   ShadingMethod GetShadingMethod() const;
 
   void SetShadingMethod(ShadingMethod method);
 
+  TextureFilter GetTextureFilter() const;
+
+  void SetTextureFilter(TextureFilter filter);
+
   size_t GetAttributeStride() const;
 
   size_t GetAttributeLength() const;
@@ -44,6 +58,7 @@ class ShaderDefinition final : public ISerializable {
   size_t mAttributeStride;
   size_t mAttributeLength;
   ShadingMethod mShadingMethod;
+  TextureFilter mTextureFilter;
 };
 
 }
@@ -0,0 +1,188 @@
+#include "SweepAndPrune.h"
+
+#include "AABB.h"
+#include "ScopedTimer.h"
+
+namespace ZSharp {
+
+// Min endpoints sort before max endpoints with the same value so touching boxes still count as overlapping.
+static bool EndpointGreater(float lhsValue, uint32 lhsData, float rhsValue, uint32 rhsData) {
+  return (lhsValue > rhsValue) || ((lhsValue == rhsValue) && ((lhsData & 1) > (rhsData & 1)));
+}
+
+template<typename T>
+static void GrowToFit(Array<T>& arr, size_t count) {
+  if (arr.Size() < count) {
+    arr.Resize(count * 2);
+  }
+}
+
+void SweepAndPrune::Clear() {
+  mProxies.Clear();
+
+  for (size_t axis = 0; axis < 3; ++axis) {
+    mEndpoints[axis].Clear();
+  }
+
+  mNumActive = 0;
+  mNumPairs = 0;
+}
+
+void SweepAndPrune::Add(PhysicsObject* object, bool isStatic) {
+  const uint32 index = (uint32)mProxies.Size();
+
+  Proxy proxy;
+  proxy.object = object;
+  proxy.activeIndex = -1;
+  proxy.isStatic = isStatic;
+  UpdateBounds(proxy);
+  mProxies.PushBack(proxy);
+
+  // New endpoints go on the end, the next sort moves them into place.
+  for (size_t axis = 0; axis < 3; ++axis) {
+    mEndpoints[axis].PushBack({ proxy.min[axis], index << 1 });
+    mEndpoints[axis].PushBack({ proxy.max[axis], (index << 1) | 1 });
+  }
+}
+
+void SweepAndPrune::Update() {
+  NamedScopedTimer(SweepAndPrune);
+
+  for (Proxy& proxy : mProxies) {
+    if (!proxy.isStatic) {
+      UpdateBounds(proxy);
+    }
+  }
+
+  // Only the swept axis has to be in order. The others catch up from wherever they were left when they get picked.
+  const size_t axis = SelectSweepAxis();
+  SortAxis(axis);
+  SweepAxis(axis);
+}
+
+const CollisionPair* SweepAndPrune::GetPairs() const {
+  // Nothing is allocated until the first pair is found.
+  return (mPairs.Size() > 0) ? mPairs.GetData() : nullptr;
+}
+
+size_t SweepAndPrune::GetNumPairs() const {
+  return mNumPairs;
+}
+
+void SweepAndPrune::UpdateBounds(Proxy& proxy) {
+  const AABB aabb(proxy.object->TransformedAABB());
+  const Vec3& velocity = proxy.object->Velocity();
+
+  // Cover everywhere the box can be during the tick.
+  for (size_t axis = 0; axis < 3; ++axis) {
+    proxy.min[axis] = aabb.MinBounds()[axis] + ((velocity[axis] < 0.f) ? velocity[axis] : 0.f);
+    proxy.max[axis] = aabb.MaxBounds()[axis] + ((velocity[axis] > 0.f) ? velocity[axis] : 0.f);
+  }
+}
+
+void SweepAndPrune::SortAxis(size_t axis) {
+  Array<Endpoint>& endpoints = mEndpoints[axis];
+  const size_t numEndpoints = endpoints.Size();
+
+  for (Endpoint& endpoint : endpoints) {
+    const Proxy& proxy = mProxies[endpoint.data >> 1];
+    endpoint.value = (endpoint.data & 1) ? proxy.max[axis] : proxy.min[axis];
+  }
+
+  // Insertion sort, the order from the last tick is almost always close to correct.
+  for (size_t i = 1; i < numEndpoints; ++i) {
+    const Endpoint endpoint = endpoints[i];
+
+    size_t j = i;
+    for (; (j > 0) && EndpointGreater(endpoints[j - 1].value, endpoints[j - 1].data, endpoint.value, endpoint.data); --j) {
+      endpoints[j] = endpoints[j - 1];
+    }
+
+    endpoints[j] = endpoint;
+  }
+}
+
+size_t SweepAndPrune::SelectSweepAxis() const {
+  // The axis the box centers are spread out the most along gives the fewest boxes overlapping at once.
+  float sum[3] = {};
+  float sumSquared[3] = {};
+
+  for (const Proxy& proxy : mProxies) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      const float center = (proxy.min[axis] + proxy.max[axis]) * 0.5f;
+      sum[axis] += center;
+      sumSquared[axis] += center * center;
+    }
+  }
+
+  const float count = (float)mProxies.Size();
+
+  size_t bestAxis = 0;
+  float bestVariance = -1.f;
+  for (size_t axis = 0; axis < 3; ++axis) {
+    const float variance = (count > 0.f) ? ((sumSquared[axis] / count) - ((sum[axis] / count) * (sum[axis] / count))) : 0.f;
+    if (variance > bestVariance) {
+      bestVariance = variance;
+      bestAxis = axis;
+    }
+  }
+
+  return bestAxis;
+}
+
+void SweepAndPrune::SweepAxis(size_t axis) {
+  const size_t otherAxis0 = (axis + 1) % 3;
+  const size_t otherAxis1 = (axis + 2) % 3;
+
+  GrowToFit(mActive, mProxies.Size());
+  mNumActive = 0;
+  mNumPairs = 0;
+
+  for (const Endpoint& endpoint : mEndpoints[axis]) {
+    const int32 index = (int32)(endpoint.data >> 1);
+    Proxy& proxy = mProxies[index];
+
+    if (endpoint.data & 1) {
+      // Swap the last active proxy into the slot being removed.
+      const int32 last = mActive[mNumActive - 1];
+      mActive[proxy.activeIndex] = last;
+      mProxies[last].activeIndex = proxy.activeIndex;
+      proxy.activeIndex = -1;
+      --mNumActive;
+      continue;
+    }
+
+    // Everything still active overlaps on the sweep axis, only the other two need checking.
+    for (size_t i = 0; i < mNumActive; ++i) {
+      const Proxy& other = mProxies[mActive[i]];
+
+      if (proxy.isStatic && other.isStatic) {
+        continue;
+      }
+
+      if ((proxy.min[otherAxis0] > other.max[otherAxis0]) || (proxy.max[otherAxis0] < other.min[otherAxis0])
+        || (proxy.min[otherAxis1] > other.max[otherAxis1]) || (proxy.max[otherAxis1] < other.min[otherAxis1])) {
+        continue;
+      }
+
+      GrowToFit(mPairs, mNumPairs + 1);
+      CollisionPair& pair = mPairs[mNumPairs];
+      ++mNumPairs;
+
+      if (proxy.isStatic) {
+        pair.a = other.object;
+        pair.b = proxy.object;
+      }
+      else {
+        pair.a = proxy.object;
+        pair.b = other.object;
+      }
+    }
+
+    proxy.activeIndex = (int32)mNumActive;
+    mActive[mNumActive] = index;
+    ++mNumActive;
+  }
+}
+
+}
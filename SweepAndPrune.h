@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "Array.h"
+#include "PhysicsObject.h"
+
+namespace ZSharp {
+
+struct CollisionPair {
+  PhysicsObject* a; // Always a moving object.
+  PhysicsObject* b;
+};
+
+/*
+Sweep and prune broadphase.
+Each object is bounded by its box swept over the velocity for the current tick.
+The min/max endpoints of every box are kept sorted on all three axes between ticks.
+Objects only move a little each tick so an insertion sort brings the lists back in order in close to linear time.
+Pairs are found by sweeping whichever axis currently has the most spread, each overlapping pair is reported once.
+Pairs where both objects are static are never reported.
+*/
+class SweepAndPrune final {
+  public:
+
+  SweepAndPrune() = default;
+
+  SweepAndPrune(const SweepAndPrune&) = delete;
+  void operator=(const SweepAndPrune&) = delete;
+
+  void Clear();
+
+  // The object must stay alive until Clear() is called.
+  void Add(PhysicsObject* object, bool isStatic);
+
+  // Refreshes the bounds of every moving object, re-sorts the endpoints and finds the overlapping pairs.
+  void Update();
+
+  // Pairs come out in a deterministic order that only depends on the object bounds and the order objects were added.
+  const CollisionPair* GetPairs() const;
+
+  size_t GetNumPairs() const;
+
+  private:
+  struct Proxy {
+    PhysicsObject* object;
+    float min[3];
+    float max[3];
+    int32 activeIndex;
+    bool isStatic;
+  };
+
+  // Low bit of data is set for max endpoints, the rest is the proxy index.
+  struct Endpoint {
+    float value;
+    uint32 data;
+  };
+
+  Array<Proxy> mProxies;
+  Array<Endpoint> mEndpoints[3];
+
+  Array<int32> mActive;
+  size_t mNumActive = 0;
+
+  Array<CollisionPair> mPairs;
+  size_t mNumPairs = 0;
+
+  void UpdateBounds(Proxy& proxy);
+
+  void SortAxis(size_t axis);
+
+  size_t SelectSweepAxis() const;
+
+  void SweepAxis(size_t axis);
+};
+
+}
@@ -7,6 +7,33 @@
 #include "ScopedTimer.h"
 
 namespace ZSharp {
+
+// Each axis halves on its own and stops at 1, so rectangular and odd sized textures still reach 1x1.
+// Odd sizes round down and drop their last row or column from the next level.
+static size_t NextMipDimension(size_t dimension) {
+  return (dimension > 1) ? (dimension >> 1) : 1;
+}
+
+// Copies a linear level into 4 row strips, the last strip repeats the bottom row if the height isn't a multiple of 4.
+static void TileLevel(uint32* __restrict dest, const uint32* __restrict src, size_t width, size_t height) {
+  const size_t paddedHeight = RoundUpNearestMultiple(height, 4);
+
+  for (size_t y = 0; y < paddedHeight; y += 4) {
+    const uint32* __restrict rows[4];
+    for (size_t r = 0; r < 4; ++r) {
+      const size_t row = ((y + r) < height) ? (y + r) : (height - 1);
+      rows[r] = src + (row * width);
+    }
+
+    for (size_t x = 0; x < width; ++x, dest += 4) {
+      dest[0] = rows[0][x];
+      dest[1] = rows[1][x];
+      dest[2] = rows[2][x];
+      dest[3] = rows[3][x];
+    }
+  }
+}
+
 Texture::Texture() : mMipChain(1) {
 }
 
@@ -63,26 +90,116 @@ uint8* Texture::Data(size_t mipLevel) const {
   return mMipChain[mipLevel].data;
 }
 
-void Texture::GenerateMips() {
+void Texture::GenerateMips(TextureLayout layout, size_t maxMips) {
   if (!IsAssigned()) {
     return;
   }
 
+  if (mMipChain.Size() == 1) {
+    BuildMipChain(maxMips);
+  }
+
+  if ((layout == TextureLayout::Tiled) && (mNumChannels == 4)) {
+    TileMipChain();
+  }
+}
+
+size_t Texture::NumMips() const {
+  return mMipChain.Size();
+}
+
+TextureLayout Texture::Layout() const {
+  return mLayout;
+}
+
+void Texture::Serialize(ISerializer& serializer) {
+  ZAssert(mLayout == TextureLayout::Linear);
+
+  // Every level's size comes first so the reader can allocate the chain before copying any texels.
+  const size_t numMips = mMipChain.Size();
+  serializer.Serialize(&mNumChannels, sizeof(mNumChannels));
+  serializer.Serialize(&numMips, sizeof(numMips));
+
+  for (size_t i = 0; i < numMips; ++i) {
+    const MipMap& map = mMipChain[i];
+    serializer.Serialize(&map.width, sizeof(map.width));
+    serializer.Serialize(&map.height, sizeof(map.height));
+    serializer.Serialize(&map.stride, sizeof(map.stride));
+  }
+
+  for (size_t i = 0; i < numMips; ++i) {
+    const MipMap& map = mMipChain[i];
+    serializer.Serialize(map.data, map.stride * map.height);
+  }
+}
+
+void Texture::Deserialize(IDeserializer& deserializer) {
+  if (IsAssigned()) {
+    ZAssert(false);
+    return;
+  }
+
+  size_t numMips = 0;
+  deserializer.Deserialize(&mNumChannels, sizeof(mNumChannels));
+  deserializer.Deserialize(&numMips, sizeof(numMips));
+
+  if (numMips == 0) {
+    return;
+  }
+
+  mMipChain.Resize(numMips);
+
+  size_t allocationSize = 0;
+  for (size_t i = 0; i < numMips; ++i) {
+    MipMap& map = mMipChain[i];
+    deserializer.Deserialize(&map.width, sizeof(map.width));
+    deserializer.Deserialize(&map.height, sizeof(map.height));
+    deserializer.Deserialize(&map.stride, sizeof(map.stride));
+
+    if (i > 0) {
+      allocationSize += map.stride * map.height;
+    }
+  }
+
+  // Same ownership as a loaded texture, the base level on its own and the rest of the chain in one aligned block.
+  MipMap& base = mMipChain[0];
+  base.data = (uint8*)PlatformMalloc(base.stride * base.height);
+  deserializer.Deserialize(base.data, base.stride * base.height);
+
+  if (allocationSize == 0) {
+    return;
+  }
+
+  mMipData = (uint8*)PlatformAlignedMalloc(RoundUpNearestMultiple(allocationSize, PlatformAlignmentGranularity()), PlatformAlignmentGranularity());
+  uint8* allocationOffset = mMipData;
+  for (size_t i = 1; i < numMips; ++i) {
+    MipMap& map = mMipChain[i];
+    map.data = allocationOffset;
+    deserializer.Deserialize(map.data, map.stride * map.height);
+    allocationOffset += map.stride * map.height;
+  }
+}
+
+void Texture::BuildMipChain(size_t maxMips) {
   NamedScopedTimer(GenerateMips);
 
   size_t lastMip = 0;
   size_t allocationSize = 0;
-  for (size_t width = mMipChain[0].width, height = mMipChain[0].height; width != 1 && height != 1; width >>= 1, height >>= 1, ++lastMip) {
-    allocationSize += (width >> 1) * (height >> 1) * 4;
+  for (size_t width = mMipChain[0].width, height = mMipChain[0].height; ((width > 1) || (height > 1)) && ((lastMip + 1) < maxMips); width = NextMipDimension(width), height = NextMipDimension(height), ++lastMip) {
+    allocationSize += NextMipDimension(width) * NextMipDimension(height) * 4;
+  }
+
+  if (allocationSize == 0) {
+    return;
   }
 
   allocationSize = RoundUpNearestMultiple(allocationSize, PlatformAlignmentGranularity());
   lastMip = 0;
   mMipData = (uint8*)PlatformAlignedMalloc(allocationSize, PlatformAlignmentGranularity());
   uint8* allocationOffset = mMipData;
-  for (size_t width = mMipChain[0].width, height = mMipChain[0].height; width != 1 && height != 1; width >>= 1, height >>= 1, ++lastMip) {
-    size_t mipWidth = width >> 1;
-    size_t mipHeight = height >> 1;
+  for (size_t width = mMipChain[0].width, height = mMipChain[0].height; ((width > 1) || (height > 1)) && ((lastMip + 1) < maxMips); width = NextMipDimension(width), height = NextMipDimension(height), ++lastMip) {
+    size_t mipWidth = NextMipDimension(width);
+    size_t mipHeight = NextMipDimension(height);
     
     uint8* nextMipData = allocationOffset;
     uint8* lastMipData = mMipChain[lastMip].data;
@@ -101,8 +218,33 @@ void Texture::GenerateMips() {
   }
 }
 
-size_t Texture::NumMips() const {
-  return mMipChain.Size();
+void Texture::TileMipChain() {
+  NamedScopedTimer(TileMipChain);
+
+  size_t allocationSize = 0;
+  for (size_t i = 0; i < mMipChain.Size(); ++i) {
+    allocationSize += mMipChain[i].width * RoundUpNearestMultiple(mMipChain[i].height, 4) * 4;
+  }
+
+  allocationSize = RoundUpNearestMultiple(allocationSize, PlatformAlignmentGranularity());
+  uint8* tiledData = (uint8*)PlatformAlignedMalloc(allocationSize, PlatformAlignmentGranularity());
+  uint8* linearBase = mMipChain[0].data;
+  uint8* allocationOffset = tiledData;
+  for (size_t i = 0; i < mMipChain.Size(); ++i) {
+    MipMap& map = mMipChain[i];
+    TileLevel((uint32*)allocationOffset, (const uint32*)map.data, map.width, map.height);
+    map.data = allocationOffset;
+    allocationOffset += map.width * RoundUpNearestMultiple(map.height, 4) * 4;
+  }
+
+  // The base level came from the loader and the rest from GenerateMips, only the tiled copies are used from here on.
+  PlatformFree(linearBase);
+  if (mMipData != nullptr) {
+    PlatformAlignedFree(mMipData);
+  }
+
+  mMipData = tiledData;
+  mLayout = TextureLayout::Tiled;
 }
 
 uint8* InsertAlphaChannel(uint8* data, size_t width, size_t height) {
@@ -5,11 +5,34 @@
 #include "CommonMath.h"
 #include "PlatformDefines.h"
 #include "Array.h"
+#include "ISerializable.h"
 
 namespace ZSharp {
 
 uint8* InsertAlphaChannel(uint8* data, size_t width, size_t height);
 
+// Passed in place of a mip level to have the rasterizer pick one per triangle from its screen footprint.
+constexpr size_t AutoMipLevel = (size_t)-1;
+
+// Passed to GenerateMips to build every level down to 1x1.
+constexpr size_t FullMipChain = (size_t)-1;
+
+/*
+  How the texels of each mip are laid out in memory.
+  Linear is plain rows.
+  Tiled packs every 4x4 block into one 64 byte cache line so samples that walk down the texture stay in cache.
+  Blocks run left to right in strips of 4 rows and are column major inside, see TiledTexelOffset.
+*/
+enum class TextureLayout {
+  Linear,
+  Tiled
+};
+
+// Offset in texels of (x, y) in a tiled level that is width texels wide.
+FORCE_INLINE size_t TiledTexelOffset(size_t x, size_t y, size_t width) {
+  return ((y & ~(size_t)3) * width) + (x << 2) + (y & 3);
+}
+
 /*
 A 2D texture that owns its memory. The idea is to load some kind of standardized image/material format into an agnostic class.
 The renderer can then sample from this texture using U,V's.
@@ -18,9 +41,9 @@ V = Vertical [0..1]
 Origin is top left of the texture at [0,0]
 We don't handle any fancy channels right now, assuming native RGB display layout.
 Clamping is enforced and not configurable. This is set to [0..1].
-We do not do any filtering at the moment.
+Sample() is a nearest texel lookup, the UV raster kernels do their own filtering based on the material TextureFilter.
 */
-class Texture final {
+class Texture final : public ISerializable {
   public:
 
   Texture();
@@ -50,7 +73,7 @@ class Texture final {
 
     const size_t x = static_cast<size_t>(u * (map.width - 1));
     const size_t y = static_cast<size_t>(v * (map.height - 1));
-    const size_t pixel = (y * map.stride) + (x * mNumChannels);
+    const size_t pixel = (mLayout == TextureLayout::Tiled) ? (TiledTexelOffset(x, y, map.width) * 4) : ((y * map.stride) + (x * mNumChannels));
 
     // We're assuming the texture channel layout matches the display here.
     // This doesn't make a lot of sense for non-albedo textures but we can take care of that later.
@@ -65,12 +88,22 @@ class Texture final {
 
   uint8* Data(size_t mipLevel) const;
 
-  void GenerateMips();
+  // Tiled layouts are only built for 4 channel textures, check Layout() for what was actually used.
+  // A chain that was already deserialized is kept as is, only the layout is applied to it.
+  void GenerateMips(TextureLayout layout = TextureLayout::Linear, size_t maxMips = FullMipChain);
 
   size_t NumMips() const;
 
+  TextureLayout Layout() const;
+
+  // Writes the whole mip chain, only linear textures can be serialized.
+  virtual void Serialize(ISerializer& serializer) override;
+
+  virtual void Deserialize(IDeserializer& deserializer) override;
+
   private:
   size_t mNumChannels = 0;
+  TextureLayout mLayout = TextureLayout::Linear;
   uint8* mMipData = nullptr;
   struct MipMap {
     size_t width = 0;
@@ -79,6 +112,10 @@ class Texture final {
     uint8* data = nullptr;
   };
   Array<MipMap> mMipChain;
+
+  void BuildMipChain(size_t maxMips);
+
+  void TileMipChain();
 };
 
 }
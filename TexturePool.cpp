@@ -15,7 +15,7 @@ TexturePool::TexturePool() {
 TexturePool::~TexturePool() {
 }
 
-int32 TexturePool::LoadTexture(Asset& asset) {
+int32 TexturePool::LoadTexture(Asset& asset, TextureLayout layout) {
   if (asset.Type() != AssetType::Texture) {
     return -1;
   }
@@ -40,7 +40,7 @@ int32 TexturePool::LoadTexture(Asset& asset) {
 
     Texture& texture = mTextures.EmplaceBack();
     texture.Assign(pngData, channels, width, height);
-    texture.GenerateMips();
+    texture.GenerateMips(layout);
 
     int32 index = ((int32)mTextures.Size()) - 1;
     mLoadedTextures.Add(assetName, index);
@@ -65,7 +65,21 @@ int32 TexturePool::LoadTexture(Asset& asset) {
 
     Texture& texture = mTextures.EmplaceBack();
     texture.Assign(jpgData, channels, width, height);
-    texture.GenerateMips();
+    texture.GenerateMips(layout);
+
+    int32 index = ((int32)mTextures.Size()) - 1;
+    mLoadedTextures.Add(assetName, index);
+    return index;
+  }
+  else if (asset.Extension() == "ztex") {
+    NamedScopedTimer(ZTEXDeserialize);
+
+    // Baked at bundle time with the mip chain already built, atlases depend on that to keep their gutters.
+    MemoryDeserializer texDeserializer(asset.Loader());
+
+    Texture& texture = mTextures.EmplaceBack();
+    texture.Deserialize(texDeserializer);
+    texture.GenerateMips(layout);
 
     int32 index = ((int32)mTextures.Size()) - 1;
     mLoadedTextures.Add(assetName, index);
@@ -16,7 +16,8 @@ class TexturePool final {
 
   ~TexturePool();
 
-  int32 LoadTexture(Asset& asset);
+  // Layout only applies the first time an asset is loaded, later calls return the cached texture.
+  int32 LoadTexture(Asset& asset, TextureLayout layout = TextureLayout::Linear);
 
   Texture* GetTexture(int32 id);
 
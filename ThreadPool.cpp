@@ -3,33 +3,181 @@
 #include "CommonMath.h"
 #include "PlatformHAL.h"
 #include "PlatformMemory.h"
+#include "PlatformTime.h"
+#include "TraceEvents.h"
 
 namespace ZSharp {
 
+// Set for the lifetime of each worker thread, nullptr on every other thread.
+static thread_local WorkerThreadControl* CurrentWorker = nullptr;
+
+// Jobs the calling thread is in the middle of running, the owning thread also runs them while it waits.
+static thread_local size_t JobDepth = 0;
+
+static bool StealJob(ThreadControl& control, uint32& seed, ThreadJob& job) {
+  const size_t numWorkers = control.workers.Size();
+
+  // Xorshift, we only need the victims to be spread out.
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+
+  // The extra slot is the queue of jobs submitted from outside of the pool.
+  const size_t numQueues = numWorkers + 1;
+  const size_t first = seed % numQueues;
+
+  for (size_t i = 0; i < numQueues; ++i) {
+    const size_t victim = (first + i) % numQueues;
+    JobQueue& queue = (victim == numWorkers) ? control.submittedJobs : control.workers[victim].jobs;
+
+    if (queue.Steal(job)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static size_t GetGrainSize(size_t length, size_t numWorkers) {
+  // Aim for a few pieces per worker so that uneven pieces can be balanced by stealing.
+  const size_t grainSize = length / (numWorkers * 4);
+  return (grainSize == 0) ? 1 : grainSize;
+}
+
+static void WakeWorkers(ThreadControl& control) {
+  for (WorkerThreadControl& worker : control.workers) {
+    worker.status = WorkerThreadControl::RunStatus::RUNNING;
+    PlatformSignalMonitor(worker.runningMonitor);
+  }
+}
+
+static void RunJob(ThreadControl& control, JobQueue& localQueue, ThreadJob& job);
+
+static void RunGraphTask(Span<uint8> data) {
+  GraphJob& graphJob = *((GraphJob*)data.GetData());
+  graphJob.task();
+}
+
+static void ScheduleGraphJob(ThreadControl& control, GraphJob& graphJob);
+
+static void FinishGraphJob(ThreadControl& control, GraphJob& graphJob) {
+  GraphJob* continuations[MaxJobContinuations];
+
+  graphJob.continuationLock.Aquire();
+  graphJob.finished = 1;
+  const size_t numContinuations = graphJob.numContinuations;
+  for (size_t i = 0; i < numContinuations; ++i) {
+    continuations[i] = graphJob.continuations[i];
+  }
+  graphJob.numContinuations = 0;
+  graphJob.continuationLock.Release();
+
+  for (size_t i = 0; i < numContinuations; ++i) {
+    if (PlatformAtomicDecrement(&continuations[i]->dependencies) == 0) {
+      ScheduleGraphJob(control, *continuations[i]);
+    }
+  }
+
+  // Continuations have already been counted, so WaitForJobs() can't see zero in between.
+  PlatformAtomicDecrement(&control.pendingJobs);
+}
+
+static void ScheduleGraphJob(ThreadControl& control, GraphJob& graphJob) {
+  PlatformAtomicIncrement(&control.pendingJobs);
+
+  if (graphJob.end == graphJob.begin) {
+    FinishGraphJob(control, graphJob);
+    return;
+  }
+
+  graphJob.pieces = 1;
+
+  ThreadJob job{ graphJob.range, graphJob.indexRange, graphJob.data, graphJob.begin, graphJob.end,
+    GetGrainSize(graphJob.end - graphJob.begin, control.workers.Size()), &graphJob.pieces, &graphJob };
+
+  JobQueue& queue = (CurrentWorker != nullptr) ? CurrentWorker->jobs : control.submittedJobs;
+  if (queue.Push(job)) {
+    WakeWorkers(control);
+  }
+  else {
+    // Too many jobs in flight, just run it here.
+    WakeWorkers(control);
+    RunJob(control, queue, job);
+  }
+}
+
+static void InvokeJob(const ThreadJob& job) {
+  if (job.data != nullptr) {
+    job.func(Span<uint8>(job.data + job.begin, job.end - job.begin));
+  }
+  else {
+    job.indexFunc(job.begin, job.end);
+  }
+}
+
+static void RunJob(ThreadControl& control, JobQueue& localQueue, ThreadJob& job) {
+  // Split large ranges in half until we reach the grain size.
+  // Thieves take from the top of the queue so they always get the largest pieces that are left.
+  while ((job.end - job.begin) > job.grainSize) {
+    const size_t middle = job.begin + ((job.end - job.begin) / 2);
+    ThreadJob upper(job);
+    upper.begin = middle;
+
+    PlatformAtomicIncrement(job.counter);
+
+    if (!localQueue.Push(upper)) {
+      PlatformAtomicDecrement(job.counter);
+      break;
+    }
+
+    job.end = middle;
+  }
+
+  ++JobDepth;
+
+  if (TraceIsCapturing()) {
+    const size_t beginTime = PlatformHighResClock();
+    InvokeJob(job);
+    TraceRecordEvent((job.graphJob != nullptr) ? "GraphJob" : "ThreadJob", beginTime, PlatformHighResClock());
+  }
+  else {
+    InvokeJob(job);
+  }
+
+  --JobDepth;
+
+  if ((PlatformAtomicDecrement(job.counter) == 0) && (job.graphJob != nullptr)) {
+    FinishGraphJob(control, *job.graphJob);
+  }
+}
+
 int32 BackgroundWorker(void* data) {
   WorkerThreadControl& workerControl = *((WorkerThreadControl*)data);
-  // TODO: We expose the other worker queue's here so that in the future we can steal work if some threads finish before others.
-  //ThreadControl& control = *(workerControl.masterControl);
+  ThreadControl& control = *(workerControl.masterControl);
+
+  CurrentWorker = &workerControl;
+  TraceSetThreadName(String::FromFormat("Worker Thread {0}", workerControl.id));
 
   while (true) {
     if (workerControl.status == WorkerThreadControl::RunStatus::RUNNING) {
-      // Don't let anyone modify the job queue while we're inspecting it
-      workerControl.jobLock.Aquire();
+      ThreadJob job;
 
-      if (!workerControl.jobs.IsEmpty()) {
-        ThreadJob job(*(workerControl.jobs.begin()));
-        workerControl.jobs.RemoveFront();
-        workerControl.jobLock.Release();
-
-        job.func(job.data);
-      }
-      else {
-        workerControl.jobLock.Release();
+      if (workerControl.jobs.Pop(job) || StealJob(control, workerControl.stealSeed, job)) {
+        RunJob(control, workerControl.jobs, job);
       }
-
-      if (workerControl.jobs.IsEmpty()) {
+      else if (control.pendingJobs == 0) {
         workerControl.status = WorkerThreadControl::RunStatus::SLEEP;
         PlatformClearMonitor(workerControl.runningMonitor);
+
+        // Check again after going to sleep, otherwise we could miss a job that was queued right before.
+        PlatformMemoryFence();
+        if (control.pendingJobs > 0) {
+          workerControl.status = WorkerThreadControl::RunStatus::RUNNING;
+        }
+      }
+      else {
+        // Other workers are still busy, keep trying to steal from them.
+        PlatformBusySpin();
       }
     }
     else if (workerControl.status == WorkerThreadControl::RunStatus::SLEEP) {
@@ -52,11 +200,13 @@ ThreadPool::ThreadPool() {
   mPool.Resize(numCores);
 
   mControl.workers.Resize(numCores);
+  mControl.graphJobs.Resize(MaxGraphJobs);
 
   for (size_t i = 0; i < numCores; ++i) {
     WorkerThreadControl& control = mControl.workers[i];
     control.masterControl = &mControl;
     control.id = i;
+    control.stealSeed = (uint32)(i * 0x9E3779B9) | 1;
     control.runningMonitor = PlatformCreateMonitor(false);
     control.waitingMonitor = PlatformCreateMonitor(true);
   }
@@ -85,10 +235,7 @@ ThreadPool::~ThreadPool() {
 }
 
 void ThreadPool::Wake() {
-  for (WorkerThreadControl& worker : mControl.workers) {
-    worker.status = WorkerThreadControl::RunStatus::RUNNING;
-    PlatformSignalMonitor(worker.runningMonitor);
-  }
+  WakeWorkers(mControl);
 }
 
 void ThreadPool::Sleep() {
@@ -99,68 +246,219 @@ void ThreadPool::Sleep() {
 }
 
 void ThreadPool::WaitForJobs() {
+  // Help out with any jobs that haven't been picked up yet before blocking.
+  uint32 seed = 0x2545F491;
+  ThreadJob job;
+  while ((mControl.pendingJobs > 0) && (mControl.submittedJobs.Pop(job) || StealJob(mControl, seed, job))) {
+    RunJob(mControl, mControl.submittedJobs, job);
+  }
+
   Array<PlatformMonitor*> monitors(mControl.workers.Size());
 
-  size_t numWaiting = 0;
-  for (size_t i = 0; i < monitors.Size(); ++i) {
-    WorkerThreadControl& worker = mControl.workers[i];
-    if (worker.status == WorkerThreadControl::RunStatus::RUNNING) {
-      monitors[numWaiting] = worker.waitingMonitor;
-      ++numWaiting;
+  // A worker may still be reporting itself as idle right after being woken up.
+  // Keep waiting until every queued job has actually finished.
+  while (mControl.pendingJobs > 0) {
+    size_t numWaiting = 0;
+    for (size_t i = 0; i < monitors.Size(); ++i) {
+      WorkerThreadControl& worker = mControl.workers[i];
+      if (worker.status == WorkerThreadControl::RunStatus::RUNNING) {
+        monitors[numWaiting] = worker.waitingMonitor;
+        ++numWaiting;
+      }
     }
-  }
 
-  // Only issue a true wait if we know there are still some threads running.
-  // Most of the time the worker threads should be idle unless we're backed up.
-  // Waiting for all the handles can be expensive, up to around 500us, so avoid it if we can.
-  if (numWaiting > 0) {
-    if (numWaiting == 1) {
-      PlatformWaitMonitor(monitors[0]);
+    // Only issue a true wait if we know there are still some threads running.
+    // Most of the time the worker threads should be idle unless we're backed up.
+    // Waiting for all the handles can be expensive, up to around 500us, so avoid it if we can.
+    if (numWaiting > 0) {
+      if (numWaiting == 1) {
+        PlatformWaitMonitor(monitors[0]);
+      }
+      else {
+        PlatformWaitMonitors(monitors.GetData(), numWaiting);
+      }
     }
     else {
-      PlatformWaitMonitors(monitors.GetData(), numWaiting);
+      PlatformYieldThread();
     }
   }
 }
 
 void ThreadPool::Execute(ParallelRange& range, void* data, size_t length) {
-  size_t numThreads = mPool.Size();
-  
   if (length == 0) {
     return;
   }
 
-  // If we can't evenly distribute the work among threads, throw everything on one worker thread.
-  if (length < numThreads) {
-    Span<uint8> threadData((uint8*)data, length);
+  ThreadJob job{ range, ParallelIndexRange(), (uint8*)data, 0, length, GetGrainSize(length, mPool.Size()), nullptr, nullptr };
+  ExecuteJob(job);
+}
 
-    WorkerThreadControl& worker = mControl.workers[0];
-    worker.jobLock.Aquire();
-    worker.jobs.Emplace(range, threadData);
-    worker.jobLock.Release();
+void ThreadPool::Execute(ParallelIndexRange& range, size_t begin, size_t end) {
+  if (end <= begin) {
+    return;
   }
-  else {
-    size_t remainder = length % numThreads;
-    size_t chunkSize = (size_t)floorf((float)length / (float)numThreads);
 
-    for (size_t i = 0, j = 0; j < numThreads; ++j) {
-      size_t nextChunk = chunkSize;
+  ThreadJob job{ ParallelRange(), range, nullptr, begin, end, GetGrainSize(end - begin, mPool.Size()), nullptr, nullptr };
+  ExecuteJob(job);
+}
+
+void ThreadPool::ExecuteJob(ThreadJob& job) {
+  if ((CurrentWorker != nullptr) || (JobDepth > 0)) {
+    // Nested parallel-for, keep working until all of our own pieces are done.
+    // The owning thread gets here from jobs it picked up in Wait(), its own queue is the submitted one.
+    JobQueue& localQueue = (CurrentWorker != nullptr) ? CurrentWorker->jobs : mControl.submittedJobs;
+    uint32 seed = (CurrentWorker != nullptr) ? CurrentWorker->stealSeed : 0x2545F491;
+
+    volatile int32 counter = 1;
+    job.counter = &counter;
+    RunJob(mControl, localQueue, job);
 
-      if (j < remainder) {
-        ++nextChunk;
+    while (counter > 0) {
+      if (localQueue.Pop(job) || StealJob(mControl, seed, job)) {
+        RunJob(mControl, localQueue, job);
+      }
+      else {
+        PlatformBusySpin();
       }
+    }
+
+    return;
+  }
 
-      Span<uint8> threadData(((uint8*)data) + i, nextChunk);
-      WorkerThreadControl& worker = mControl.workers[j];
-      worker.jobLock.Aquire();
-      worker.jobs.Emplace(range, threadData);
-      worker.jobLock.Release();
+  job.counter = &mControl.pendingJobs;
+  PlatformAtomicIncrement(&mControl.pendingJobs);
+
+  if (mControl.submittedJobs.Push(job)) {
+    Wake();
+  }
+  else {
+    // Too many jobs in flight, just run it here.
+    Wake();
+    RunJob(mControl, mControl.submittedJobs, job);
+  }
+}
+
+JobHandle ThreadPool::CreateJob(const JobTask& task) {
+  GraphJob& graphJob = AllocateGraphJob();
+  graphJob.task = task;
+  graphJob.range = ParallelRange::FromFreeFunction(&RunGraphTask);
+  graphJob.indexRange.Unbind();
+  graphJob.data = (uint8*)&graphJob;
+  graphJob.begin = 0;
+  graphJob.end = 1;
+
+  JobHandle handle;
+  handle.job = &graphJob;
+  handle.generation = graphJob.generation;
+  return handle;
+}
 
-      i += nextChunk;
+JobHandle ThreadPool::CreateJob(ParallelRange& range, void* data, size_t length) {
+  GraphJob& graphJob = AllocateGraphJob();
+  graphJob.task.Unbind();
+  graphJob.range = range;
+  graphJob.indexRange.Unbind();
+  graphJob.data = (uint8*)data;
+  graphJob.begin = 0;
+  graphJob.end = length;
+
+  JobHandle handle;
+  handle.job = &graphJob;
+  handle.generation = graphJob.generation;
+  return handle;
+}
+
+JobHandle ThreadPool::CreateJob(ParallelIndexRange& range, size_t begin, size_t end) {
+  GraphJob& graphJob = AllocateGraphJob();
+  graphJob.task.Unbind();
+  graphJob.range.Unbind();
+  graphJob.indexRange = range;
+  graphJob.data = nullptr;
+  graphJob.begin = begin;
+  graphJob.end = (end > begin) ? end : begin;
+
+  JobHandle handle;
+  handle.job = &graphJob;
+  handle.generation = graphJob.generation;
+  return handle;
+}
+
+void ThreadPool::AddDependency(JobHandle job, JobHandle dependsOn) {
+  if (dependsOn.job == nullptr) {
+    return;
+  }
+
+  GraphJob& parent = *dependsOn.job;
+  parent.continuationLock.Aquire();
+
+  if (!IsFinished(dependsOn)) {
+    // Bump this if it ever gets hit, continuations are stored inline.
+    ZAssert(parent.numContinuations < MaxJobContinuations);
+
+    PlatformAtomicIncrement(&job.job->dependencies);
+    parent.continuations[parent.numContinuations] = job.job;
+    ++parent.numContinuations;
+  }
+
+  parent.continuationLock.Release();
+}
+
+void ThreadPool::Submit(JobHandle job) {
+  // Release the hold that was taken when the job was created.
+  if (PlatformAtomicDecrement(&job.job->dependencies) == 0) {
+    ScheduleGraphJob(mControl, *job.job);
+  }
+}
+
+JobHandle ThreadPool::Continue(JobHandle parent, const JobTask& task) {
+  JobHandle job(CreateJob(task));
+  AddDependency(job, parent);
+  Submit(job);
+  return job;
+}
+
+bool ThreadPool::IsFinished(JobHandle job) const {
+  if (job.job == nullptr) {
+    return true;
+  }
+
+  // The slot bumps its generation before it clears finished, so check them in the opposite order.
+  if (job.job->finished) {
+    return true;
+  }
+
+  return job.job->generation != job.generation;
+}
+
+void ThreadPool::Wait(JobHandle job) {
+  JobQueue& localQueue = (CurrentWorker != nullptr) ? CurrentWorker->jobs : mControl.submittedJobs;
+  uint32 seed = (CurrentWorker != nullptr) ? CurrentWorker->stealSeed : 0x2545F491;
+
+  while (!IsFinished(job)) {
+    ThreadJob threadJob;
+
+    if (localQueue.Pop(threadJob) || StealJob(mControl, seed, threadJob)) {
+      RunJob(mControl, localQueue, threadJob);
+    }
+    else {
+      PlatformBusySpin();
     }
   }
+}
+
+GraphJob& ThreadPool::AllocateGraphJob() {
+  const uint32 index = (uint32)(PlatformAtomicIncrement(&mControl.nextGraphJob) - 1);
+  GraphJob& graphJob = mControl.graphJobs[index % MaxGraphJobs];
+
+  // The ring is large enough that a slot should have finished long before we come back around to it.
+  ZAssert(graphJob.finished);
 
-  Wake();
+  graphJob.generation = graphJob.generation + 1;
+  graphJob.finished = 0;
+  graphJob.dependencies = 1;
+  graphJob.pieces = 0;
+  graphJob.numContinuations = 0;
+  return graphJob;
 }
 
 }
@@ -4,24 +4,75 @@
 
 #include "Array.h"
 #include "Delegate.h"
-#include "List.h"
 #include "PlatformThread.h"
 #include "PlatformAtomic.h"
 #include "Span.h"
+#include "WorkStealingQueue.h"
 
 namespace ZSharp {
 
 typedef Delegate<Span<uint8>> ParallelRange;
 
+// Gets [begin, end) of an index range, for work split by count instead of over a block of memory.
+typedef Delegate<size_t, size_t> ParallelIndexRange;
+
+typedef Delegate<void> JobTask;
+
+static constexpr size_t MaxQueuedJobs = 256;
+static constexpr size_t MaxGraphJobs = 1024;
+static constexpr size_t MaxJobContinuations = 16;
+
+struct GraphJob {
+  JobTask task;
+  ParallelRange range;
+  ParallelIndexRange indexRange;
+  // Only set for memory ranges, begin and end are then byte offsets from it.
+  uint8* data = nullptr;
+  size_t begin = 0;
+  size_t end = 0;
+  // Held at one until the job is submitted, the job is scheduled when this reaches zero.
+  volatile int32 dependencies = 0;
+  // Outstanding pieces of the range, the job is finished when this reaches zero.
+  volatile int32 pieces = 0;
+  volatile int32 finished = 1;
+  volatile uint32 generation = 0;
+  PlatformMutex continuationLock;
+  size_t numContinuations = 0;
+  GraphJob* continuations[MaxJobContinuations];
+};
+
+// Stays valid after the job finishes, the generation tells us if the slot has been reused since.
+struct JobHandle {
+  GraphJob* job = nullptr;
+  uint32 generation = 0;
+};
+
 struct ThreadJob {
   ParallelRange func;
-  Span<uint8> data;
+  ParallelIndexRange indexFunc;
+  // Only set for memory ranges, begin and end are then byte offsets from it.
+  uint8* data;
+  size_t begin;
+  size_t end;
+  // Jobs larger than this get split in half, the upper half is left for other workers to steal.
+  size_t grainSize;
+  // Decremented once the job has run, splitting a job adds to it first.
+  volatile int32* counter;
+  // Set if this is a piece of a graph job.
+  GraphJob* graphJob;
 };
 
+typedef WorkStealingQueue<ThreadJob, MaxQueuedJobs> JobQueue;
+
 struct WorkerThreadControl;
 
 struct ThreadControl {
   Array<WorkerThreadControl> workers;
+  // Jobs submitted from outside of the pool, only the thread that owns the pool pushes to it.
+  JobQueue submittedJobs;
+  volatile int32 pendingJobs = 0;
+  Array<GraphJob> graphJobs;
+  volatile int32 nextGraphJob = 0;
 };
 
 struct WorkerThreadControl {
@@ -35,10 +86,10 @@ struct WorkerThreadControl {
 
   ThreadControl* masterControl = nullptr;
   size_t id = 0;
-  PlatformMutex jobLock;
+  uint32 stealSeed = 0;
   PlatformMonitor* runningMonitor;
   PlatformMonitor* waitingMonitor;
-  List<ThreadJob> jobs;
+  JobQueue jobs;
 };
 
 class ThreadPool final {
@@ -54,13 +105,41 @@ class ThreadPool final {
 
   void Sleep();
 
+  // Can be called from the owning thread or from inside of a running job.
+  // Calls from inside of a job are a nested parallel-for, they return once the whole range has finished.
   void Execute(ParallelRange& range, void* data, size_t length);
 
+  void Execute(ParallelIndexRange& range, size_t begin, size_t end);
+
   void WaitForJobs();
 
+  // Graph jobs don't run until they are submitted, any dependencies must be added before then.
+  JobHandle CreateJob(const JobTask& task);
+
+  JobHandle CreateJob(ParallelRange& range, void* data, size_t length);
+
+  JobHandle CreateJob(ParallelIndexRange& range, size_t begin, size_t end);
+
+  // job will not start until dependsOn has finished.
+  void AddDependency(JobHandle job, JobHandle dependsOn);
+
+  void Submit(JobHandle job);
+
+  // Creates and submits a job that runs once parent has finished.
+  JobHandle Continue(JobHandle parent, const JobTask& task);
+
+  bool IsFinished(JobHandle job) const;
+
+  // Only waits on the given job, the calling thread runs other jobs in the meantime.
+  void Wait(JobHandle job);
+
   private:
   Array<PlatformThread*> mPool;
   ThreadControl mControl;
+
+  GraphJob& AllocateGraphJob();
+
+  void ExecuteJob(ThreadJob& job);
 };
 
 }
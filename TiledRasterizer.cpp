@@ -0,0 +1,180 @@
+#include "TiledRasterizer.h"
+
+#include <cmath>
+
+#include "Constants.h"
+#include "PlatformIntrinsics.h"
+
+namespace ZSharp {
+
+template<typename T>
+static void GrowToFit(Array<T>& arr, size_t count) {
+  if (arr.Size() < count) {
+    arr.Resize(count * 2);
+  }
+}
+
+TiledRasterizer::TiledRasterizer() {
+}
+
+void TiledRasterizer::Begin(size_t width, size_t height) {
+  if (width != mWidth || height != mHeight) {
+    mWidth = width;
+    mHeight = height;
+    mTilesX = (int32)((width + TileSize - 1) / TileSize);
+    mTilesY = (int32)((height + TileSize - 1) / TileSize);
+
+    mTiles.Clear();
+    mTiles.Resize(mTilesX * mTilesY);
+
+    for (int32 y = 0; y < mTilesY; ++y) {
+      for (int32 x = 0; x < mTilesX; ++x) {
+        Tile& tile = mTiles[(y * mTilesX) + x];
+        tile.bounds[0] = x * TileSize;
+        tile.bounds[1] = y * TileSize;
+
+        // The right and bottom edge tiles may be partially covered.
+        tile.bounds[2] = (x == (mTilesX - 1)) ? (int32)width : (x + 1) * TileSize;
+        tile.bounds[3] = (y == (mTilesY - 1)) ? (int32)height : (y + 1) * TileSize;
+      }
+    }
+  }
+
+  // Keep the allocations around between frames, only the counts are reset.
+  for (Tile& tile : mTiles) {
+    tile.numIndices = 0;
+    tile.numBatches = 0;
+  }
+
+  mNumDraws = 0;
+}
+
+void TiledRasterizer::BinTriangles(const float* vertices,
+  const int32* indices,
+  int32 end,
+  ShadingMethod shadingMethod,
+  const Texture* texture,
+  TextureFilter textureFilter,
+  size_t mipLevel) {
+  if ((end <= 0) || mTiles.IsEmpty()) {
+    return;
+  }
+
+  GrowToFit(mDraws, mNumDraws + 1);
+
+  const int32 drawIndex = mNumDraws;
+  ++mNumDraws;
+
+  Draw& draw = mDraws[drawIndex];
+  draw.vertices = vertices;
+  draw.shadingMethod = shadingMethod;
+  draw.texture = texture;
+  draw.textureFilter = textureFilter;
+  draw.mipLevel = mipLevel;
+
+  for (int32 i = 0; i < end; i += TRI_VERTS) {
+    const float* v1 = vertices + indices[i];
+    const float* v2 = vertices + indices[i + 1];
+    const float* v3 = vertices + indices[i + 2];
+
+    // Covered pixels are [floor(min), ceil(max)), same as the raster kernels.
+    const int32 minX = (int32)floorf(fminf(v1[0], fminf(v2[0], v3[0])));
+    const int32 minY = (int32)floorf(fminf(v1[1], fminf(v2[1], v3[1])));
+    const int32 maxX = (int32)ceilf(fmaxf(v1[0], fmaxf(v2[0], v3[0])));
+    const int32 maxY = (int32)ceilf(fmaxf(v1[1], fmaxf(v2[1], v3[1])));
+
+    if ((minX >= maxX) || (minY >= maxY)) {
+      continue;
+    }
+
+    int32 tileMinX = minX / TileSize;
+    int32 tileMinY = minY / TileSize;
+    int32 tileMaxX = (maxX - 1) / TileSize;
+    int32 tileMaxY = (maxY - 1) / TileSize;
+
+    tileMinX = (tileMinX < 0) ? 0 : tileMinX;
+    tileMinY = (tileMinY < 0) ? 0 : tileMinY;
+    tileMaxX = (tileMaxX >= mTilesX) ? (mTilesX - 1) : tileMaxX;
+    tileMaxY = (tileMaxY >= mTilesY) ? (mTilesY - 1) : tileMaxY;
+
+    for (int32 y = tileMinY; y <= tileMaxY; ++y) {
+      for (int32 x = tileMinX; x <= tileMaxX; ++x) {
+        Tile& tile = mTiles[(y * mTilesX) + x];
+
+        // Consecutive triangles from the same draw share a batch.
+        if ((tile.numBatches == 0) || (tile.batches[tile.numBatches - 1].draw != drawIndex)) {
+          GrowToFit(tile.batches, tile.numBatches + 1);
+          Batch& batch = tile.batches[tile.numBatches];
+          batch.draw = drawIndex;
+          batch.begin = tile.numIndices;
+          batch.end = tile.numIndices;
+          ++tile.numBatches;
+        }
+
+        GrowToFit(tile.indices, tile.numIndices + TRI_VERTS);
+        int32* tileIndices = tile.indices.GetData() + tile.numIndices;
+        tileIndices[0] = indices[i];
+        tileIndices[1] = indices[i + 1];
+        tileIndices[2] = indices[i + 2];
+        tile.numIndices += TRI_VERTS;
+
+        tile.batches[tile.numBatches - 1].end = tile.numIndices;
+      }
+    }
+  }
+}
+
+void TiledRasterizer::Raster(ThreadPool& threadPool, Framebuffer& framebuffer, DepthBuffer& depthBuffer) {
+  if ((mNumDraws == 0) || mTiles.IsEmpty()) {
+    return;
+  }
+
+  mFramebuffer = &framebuffer;
+  mDepthBuffer = &depthBuffer;
+
+  ParallelIndexRange rasterRange = ParallelIndexRange::FromMember<TiledRasterizer, &TiledRasterizer::RasterTiles>(this);
+  JobHandle rasterJob(threadPool.CreateJob(rasterRange, 0, mTiles.Size()));
+  threadPool.Submit(rasterJob);
+  threadPool.Wait(rasterJob);
+}
+
+void TiledRasterizer::RasterTiles(size_t begin, size_t end) {
+  const float maxWidth = (float)mWidth;
+  uint8* framebuffer = mFramebuffer->GetBuffer();
+  float* depthBuffer = mDepthBuffer->GetBuffer();
+  float* hiZ = mDepthBuffer->GetHiZ();
+
+  for (size_t i = begin; i < end; ++i) {
+    const Tile& tile = mTiles[i];
+
+    for (int32 j = 0; j < tile.numBatches; ++j) {
+      const Batch& batch = tile.batches[j];
+      const Draw& draw = mDraws[batch.draw];
+      const int32* indices = tile.indices.GetData() + batch.begin;
+      const int32 numIndices = batch.end - batch.begin;
+
+      switch (draw.shadingMethod) {
+        case ShadingMethod::RGB:
+          RGBShaderImpl(draw.vertices, indices, numIndices, maxWidth, framebuffer, depthBuffer, hiZ, tile.bounds);
+          break;
+        case ShadingMethod::UV:
+          switch (draw.textureFilter) {
+            case TextureFilter::Bilinear:
+              UVBilinearShaderImpl(draw.vertices, indices, numIndices, maxWidth, framebuffer, depthBuffer, hiZ, draw.texture, draw.mipLevel, tile.bounds);
+              break;
+            case TextureFilter::Trilinear:
+              UVTrilinearShaderImpl(draw.vertices, indices, numIndices, maxWidth, framebuffer, depthBuffer, hiZ, draw.texture, draw.mipLevel, tile.bounds);
+              break;
+            default:
+              UVShaderImpl(draw.vertices, indices, numIndices, maxWidth, framebuffer, depthBuffer, hiZ, draw.texture, draw.mipLevel, tile.bounds);
+              break;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "Array.h"
+#include "DepthBuffer.h"
+#include "Framebuffer.h"
+#include "ShaderDefinition.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+namespace ZSharp {
+
+/*
+Splits the screen into fixed size tiles and bins every triangle into the tiles its bounding box overlaps.
+Binning happens on the calling thread, rasterization is then spread over the thread pool where each job owns a disjoint set of tiles.
+No two workers ever touch the same pixel so the color and depth buffers don't need any synchronization.
+
+All of the vertex/index data handed to BinTriangles() must stay alive until Raster() returns.
+*/
+class TiledRasterizer final {
+  public:
+
+  static constexpr int32 TileSize = 64;
+
+  TiledRasterizer();
+
+  TiledRasterizer(const TiledRasterizer&) = delete;
+  void operator=(const TiledRasterizer&) = delete;
+
+  // Resets all of the bins, the tile grid is only rebuilt if the dimensions changed.
+  void Begin(size_t width, size_t height);
+
+  void BinTriangles(const float* vertices,
+    const int32* indices,
+    int32 end,
+    ShadingMethod shadingMethod,
+    const Texture* texture,
+    TextureFilter textureFilter,
+    size_t mipLevel);
+
+  // Blocks until every tile has been drawn.
+  void Raster(ThreadPool& threadPool, Framebuffer& framebuffer, DepthBuffer& depthBuffer);
+
+  private:
+  struct Draw {
+    const float* vertices;
+    ShadingMethod shadingMethod;
+    const Texture* texture;
+    TextureFilter textureFilter;
+    size_t mipLevel;
+  };
+
+  // A contiguous run of indices inside of a tile that all belong to the same draw.
+  struct Batch {
+    int32 draw;
+    int32 begin;
+    int32 end;
+  };
+
+  struct Tile {
+    int32 bounds[4];
+    Array<int32> indices;
+    Array<Batch> batches;
+    int32 numIndices;
+    int32 numBatches;
+  };
+
+  Array<Tile> mTiles;
+  Array<Draw> mDraws;
+  int32 mNumDraws = 0;
+  int32 mTilesX = 0;
+  int32 mTilesY = 0;
+  size_t mWidth = 0;
+  size_t mHeight = 0;
+
+  Framebuffer* mFramebuffer = nullptr;
+  DepthBuffer* mDepthBuffer = nullptr;
+
+  void RasterTiles(size_t begin, size_t end);
+};
+
+}
@@ -0,0 +1,195 @@
+#include "TraceEvents.h"
+
+#include "ConsoleVariable.h"
+#include "Logger.h"
+#include "PlatformAtomic.h"
+#include "PlatformFile.h"
+#include "PlatformMemory.h"
+#include "PlatformMisc.h"
+#include "PlatformTime.h"
+#include "ProfilerThreads.h"
+#include "ZFile.h"
+
+#include <cstring>
+
+namespace ZSharp {
+
+ConsoleVariable<bool> TraceCapture("TraceCapture", false);
+
+static constexpr size_t MaxThreadEvents = 1 << 16;
+static constexpr size_t MaxThreadNameLength = 32;
+
+struct TraceEvent {
+  const char* name;
+  size_t beginTime;
+  size_t endTime;
+};
+
+// Only the owning thread writes events, numEvents is bumped after the event is filled in.
+// numDropped is only read once the capture has stopped.
+struct TraceBuffer {
+  TraceEvent* events;
+  volatile int32 numEvents;
+  int32 numDropped;
+  char name[MaxThreadNameLength];
+};
+
+static volatile int32 Capturing = 0;
+static size_t CaptureStartTime = 0;
+
+// One per profiler slot, allocated on first use.
+static TraceBuffer* ThreadBuffers() {
+  static TraceBuffer* buffers = (TraceBuffer*)PlatformCalloc(ProfilerMaxThreads() * sizeof(TraceBuffer));
+  return buffers;
+}
+
+static TraceBuffer* GetThreadBuffer() {
+  const int32 slot = ProfilerThreadSlot();
+  return (slot < 0) ? nullptr : &ThreadBuffers()[slot];
+}
+
+static FileString TraceFilePath() {
+  FileString tracePath(PlatformGetWorkingDirectory());
+
+  String traceFilename(PlatformGetExecutableName());
+  traceFilename.Append("_trace.json");
+
+  tracePath.SetFilename(traceFilename);
+  return tracePath;
+}
+
+static void StartCapture() {
+  TraceBuffer* buffers = ThreadBuffers();
+  for (size_t i = 0; i < ProfilerMaxThreads(); ++i) {
+    buffers[i].numEvents = 0;
+    buffers[i].numDropped = 0;
+  }
+
+  CaptureStartTime = PlatformHighResClock();
+  PlatformMemoryFence();
+  Capturing = 1;
+}
+
+static void WriteCapture() {
+  Capturing = 0;
+  PlatformMemoryFence();
+
+  SystemBufferedFileWriter writer(TraceFilePath(), 0);
+  if (!writer.IsOpen()) {
+    GlobalLog->Log(LogCategory::Warning, "Could not open the trace file.\n");
+    return;
+  }
+
+  const char* header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  writer.Write(header, strlen(header));
+
+  size_t numEvents = 0;
+  size_t numDropped = 0;
+  bool first = true;
+
+  const TraceBuffer* buffers = ThreadBuffers();
+  for (size_t i = 0; i < ProfilerMaxThreads(); ++i) {
+    const TraceBuffer& buffer = buffers[i];
+    const size_t threadEvents = (size_t)buffer.numEvents;
+
+    // Slots no thread has claimed.
+    if ((buffer.events == nullptr) && (buffer.name[0] == '\0')) {
+      continue;
+    }
+
+    String json;
+    if (!first) {
+      json.Append(",\n");
+    }
+    first = false;
+
+    // Braces can't go through Appendf, they would be read as argument specifiers.
+    json.Append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,");
+    json.Appendf("\"tid\":{0},\"args\":", i);
+    json.Append("{\"name\":\"");
+    json.Append((buffer.name[0] != '\0') ? buffer.name : "Thread");
+    json.Append("\"}}");
+
+    for (size_t j = 0; j < threadEvents; ++j) {
+      const TraceEvent& event = buffer.events[j];
+
+      // Only deltas from now are available, read the later time first so the differences can't go negative.
+      const size_t endAge = PlatformHighResClockDeltaUs(event.endTime);
+      const size_t beginAge = PlatformHighResClockDeltaUs(event.beginTime);
+      const size_t startAge = PlatformHighResClockDeltaUs(CaptureStartTime);
+
+      json.Append(",\n{\"name\":\"");
+      json.Append(event.name);
+      json.Appendf("\",\"ph\":\"X\",\"pid\":1,\"tid\":{0},\"ts\":{1},\"dur\":{2}", i, startAge - beginAge, beginAge - endAge);
+      json.Append("}");
+    }
+
+    writer.Write(json.Str(), json.Length());
+
+    numEvents += threadEvents;
+    numDropped += (size_t)buffer.numDropped;
+  }
+
+  const char* footer = "\n]}\n";
+  writer.Write(footer, strlen(footer));
+
+  GlobalLog->Log(LogCategory::Info, String::FromFormat("Wrote trace with {0} events, {1} dropped.\n", numEvents, numDropped));
+}
+
+void TraceEndFrame() {
+  const bool capture = *TraceCapture;
+
+  if (capture && (Capturing == 0)) {
+    StartCapture();
+  }
+  else if (!capture && (Capturing != 0)) {
+    WriteCapture();
+  }
+}
+
+bool TraceIsCapturing() {
+  return Capturing != 0;
+}
+
+void TraceRecordEvent(const char* name, size_t beginTime, size_t endTime) {
+  TraceBuffer* buffer = GetThreadBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+
+  if (buffer->events == nullptr) {
+    buffer->events = (TraceEvent*)PlatformMalloc(MaxThreadEvents * sizeof(TraceEvent));
+  }
+
+  // Anything recorded before the capture started belongs to the previous one.
+  if (beginTime < CaptureStartTime) {
+    return;
+  }
+
+  const int32 index = buffer->numEvents;
+  if (index >= (int32)MaxThreadEvents) {
+    ++buffer->numDropped;
+    return;
+  }
+
+  TraceEvent& event = buffer->events[index];
+  event.name = name;
+  event.beginTime = beginTime;
+  event.endTime = endTime;
+
+  PlatformMemoryFence();
+  buffer->numEvents = index + 1;
+}
+
+void TraceSetThreadName(const String& name) {
+  TraceBuffer* buffer = GetThreadBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+
+  const size_t length = (name.Length() < (MaxThreadNameLength - 1)) ? name.Length() : (MaxThreadNameLength - 1);
+  memcpy(buffer->name, name.Str(), length);
+  buffer->name[length] = '\0';
+}
+
+}
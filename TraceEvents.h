@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+#include "ZString.h"
+
+namespace ZSharp {
+
+/*
+Timeline capture in the Chrome trace event format, load the file in chrome://tracing or Perfetto.
+Setting the TraceCapture console variable starts a capture, clearing it writes <executable>_trace.json next to the log.
+Every thread records into its own buffer so capturing never takes a lock.
+*/
+
+// Call once per frame from the main thread, starts or finishes the capture when TraceCapture changes.
+void TraceEndFrame();
+
+bool TraceIsCapturing();
+
+// name must outlive the capture, times come from PlatformHighResClock().
+void TraceRecordEvent(const char* name, size_t beginTime, size_t endTime);
+
+// Shows up as the track name for the calling thread.
+void TraceSetThreadName(const String& name);
+
+}
@@ -66,6 +66,11 @@ void VertexBuffer::CopyInputData(const float* data, int32 index, int32 length) {
   mWorkingSize += length;
 }
 
+void VertexBuffer::TransformInputData(const float* data, int32 index, int32 length, const Mat4x4& transform) {
+  Aligned_Mat4x4TransformCopy((const float(*)[4])*transform, data, mData + index, mStride, length);
+  mWorkingSize += length;
+}
+
 float* VertexBuffer::GetClipData(int32 index) {
   return mClipData + (index * mStride);
 }
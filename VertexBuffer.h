@@ -33,6 +33,9 @@ class VertexBuffer final {
 
   void CopyInputData(const float* data, int32 index, int32 length);
 
+  // Same as CopyInputData() but the position of each vertex is transformed on the way in.
+  void TransformInputData(const float* data, int32 index, int32 length, const Mat4x4& transform);
+
   void Resize(int32 vertexSize, int32 stride);
 
   void Clear();
@@ -17,6 +17,8 @@
 #include <processenv.h>
 #include <shellapi.h>
 
+#include <cstdlib>
+
 #define DEBUG_TEXTURE_PNG 0
 #define DEBUG_TEXTURE_JPG 0
 
@@ -118,6 +120,11 @@ LRESULT Win32PlatformApplication::MessageLoop(HWND hwnd, UINT uMsg, WPARAM wPara
 int Win32PlatformApplication::Run(HINSTANCE instance) {
   ReadCommandLine();
 
+  if (mFlags.mHeadless) {
+    ZSharp::HeadlessRunner runner(*mGameInstance);
+    return runner.Run(mHeadlessOptions);
+  }
+
   mWindowHandle = SetupWindow(instance);
   if (mWindowHandle == nullptr) {
     DWORD error = GetLastError();
@@ -231,6 +238,12 @@ void Win32PlatformApplication::ReadCommandLine() {
 
     ZSharp::Array<ZSharp::String> globalOptions;
     globalOptions.EmplaceBack("fullscreen");
+    globalOptions.EmplaceBack("headless");
+    globalOptions.EmplaceBack("frames");
+    globalOptions.EmplaceBack("width");
+    globalOptions.EmplaceBack("height");
+    globalOptions.EmplaceBack("capture");
+    globalOptions.EmplaceBack("camerapath");
 
     ZSharp::CLIParser cliParser(commands, globalOptions);
     cliParser.Evaluate(argC, (const wchar_t**)argV, true);
@@ -239,6 +252,40 @@ void Win32PlatformApplication::ReadCommandLine() {
     if (cliParser.WasPassed("fullscreen")) {
       WindowStyle |= WS_MAXIMIZE;
     }
+
+    // e.g. -headless -frames=600 -capture=0,300 -camerapath=flythrough.txt
+    if (cliParser.WasPassed("headless")) {
+      mFlags.mHeadless = true;
+
+      if (cliParser.WasPassed("frames")) {
+        mHeadlessOptions.frames = (size_t)atoi(cliParser.GetValue("frames").Str());
+      }
+
+      if (cliParser.WasPassed("width") && cliParser.WasPassed("height")) {
+        mHeadlessOptions.width = (size_t)atoi(cliParser.GetValue("width").Str());
+        mHeadlessOptions.height = (size_t)atoi(cliParser.GetValue("height").Str());
+      }
+
+      if (cliParser.WasPassed("capture")) {
+        const ZSharp::String captureList(cliParser.GetValue("capture"));
+        const char* next = captureList.Str();
+
+        while (*next != '\0') {
+          char* end = nullptr;
+          const long frame = strtol(next, &end, 10);
+          if (end == next) {
+            break;
+          }
+
+          mHeadlessOptions.captureFrames.PushBack((size_t)frame);
+          next = (*end == ',') ? (end + 1) : end;
+        }
+      }
+
+      if (cliParser.WasPassed("camerapath")) {
+        mHeadlessOptions.cameraPath = cliParser.GetValue("camerapath");
+      }
+    }
   }
   
   LocalFree(argV);
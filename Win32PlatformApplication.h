@@ -6,6 +6,7 @@
 
 #include "Delegate.h"
 #include "GameInstance.h"
+#include "HeadlessRunner.h"
 #include "ZBaseTypes.h"
 #include "PlatformApplication.h"
 
@@ -28,6 +29,7 @@ class Win32PlatformApplication : public ZSharp::PlatformApplication {
   struct {
     bool mPaused : 1;
     bool mWaitingForPaint : 1;
+    bool mHeadless : 1;
   } mFlags;
   HWND mWindowHandle;
   HDC mWindowContext = nullptr;
@@ -35,6 +37,7 @@ class Win32PlatformApplication : public ZSharp::PlatformApplication {
   BYTE* mKeyboard = nullptr;
 
   ZSharp::GameInstance* mGameInstance = nullptr;
+  ZSharp::HeadlessOptions mHeadlessOptions;
 
   void ReadCommandLine();
 
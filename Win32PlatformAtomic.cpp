@@ -2,12 +2,34 @@
 
 #include "PlatformAtomic.h"
 
+#include "Win32PlatformHeaders.h"
+
 #if HW_PLATFORM_X86
 #include <intrin.h>
 #endif
 
 namespace ZSharp {
 
+int32 PlatformAtomicIncrement(volatile int32* value) {
+  return (int32)_InterlockedIncrement((volatile long*)value);
+}
+
+int32 PlatformAtomicDecrement(volatile int32* value) {
+  return (int32)_InterlockedDecrement((volatile long*)value);
+}
+
+int32 PlatformAtomicAdd(volatile int32* value, int32 amount) {
+  return (int32)_InterlockedExchangeAdd((volatile long*)value, (long)amount) + amount;
+}
+
+int64 PlatformAtomicCompareExchange(volatile int64* value, int64 exchange, int64 comparand) {
+  return (int64)_InterlockedCompareExchange64((volatile long long*)value, (long long)exchange, (long long)comparand);
+}
+
+void PlatformMemoryFence() {
+  MemoryBarrier();
+}
+
 PlatformSemaphore::PlatformSemaphore(uint32 maxCount) 
   : mMaxCount(maxCount) {
 
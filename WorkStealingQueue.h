@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ZBaseTypes.h"
+
+#include "PlatformAtomic.h"
+
+namespace ZSharp {
+
+/*
+Fixed capacity Chase-Lev deque.
+The owning thread pushes and pops from the bottom, any other thread can steal from the top.
+Push() fails instead of growing when the queue is full, callers are expected to run the item inline in that case.
+T must be safe to copy with a plain memcpy since a thief may read a slot that is being raced for.
+*/
+template<typename T, size_t Capacity>
+class WorkStealingQueue final {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+  public:
+
+  WorkStealingQueue() = default;
+
+  WorkStealingQueue(const WorkStealingQueue&) = delete;
+  void operator=(const WorkStealingQueue&) = delete;
+
+  // Owner only.
+  bool Push(const T& item) {
+    const int64 bottom = mBottom;
+    const int64 top = mTop;
+
+    if ((bottom - top) >= (int64)Capacity) {
+      return false;
+    }
+
+    mItems[bottom & Mask] = item;
+    // The item must be visible before a thief can see the new bottom.
+    PlatformMemoryFence();
+    mBottom = bottom + 1;
+    return true;
+  }
+
+  // Owner only.
+  bool Pop(T& item) {
+    const int64 bottom = mBottom - 1;
+    mBottom = bottom;
+    PlatformMemoryFence();
+    const int64 top = mTop;
+
+    if (top > bottom) {
+      mBottom = top;
+      return false;
+    }
+
+    item = mItems[bottom & Mask];
+
+    if (top != bottom) {
+      return true;
+    }
+
+    // Last item in the queue, race any thieves for it.
+    const bool won = PlatformAtomicCompareExchange(&mTop, top + 1, top) == top;
+    mBottom = top + 1;
+    return won;
+  }
+
+  // Safe to call from any thread.
+  bool Steal(T& item) {
+    const int64 top = mTop;
+    PlatformMemoryFence();
+    const int64 bottom = mBottom;
+
+    if (top >= bottom) {
+      return false;
+    }
+
+    item = mItems[top & Mask];
+    return PlatformAtomicCompareExchange(&mTop, top + 1, top) == top;
+  }
+
+  bool IsEmpty() const {
+    return mBottom <= mTop;
+  }
+
+  private:
+  static constexpr int64 Mask = (int64)Capacity - 1;
+
+  volatile int64 mTop = 0;
+  volatile int64 mBottom = 0;
+  T mItems[Capacity];
+};
+
+}
@@ -8,6 +8,7 @@
 #include "PhysicsAlgorithms.h"
 #include "PlatformMemory.h"
 #include "ScopedTimer.h"
+#include "SweepAndPrune.h"
 #include "TexturePool.h"
 #include "ZConfig.h"
 
@@ -23,6 +24,9 @@ ConsoleVariable<bool> DebugAudio("DebugAudio", false);
 ConsoleVariable<bool> DebugTriangle("DebugTriangle", false);
 ConsoleVariable<bool> DebugTriangleTex("DebugTriangleTex", false);
 
+// Mesh textures in 4x4 tiles, helps surfaces viewed at steep rotations but costs a bit on upright ones.
+ConsoleVariable<bool> TiledTextures("TiledTextures", false);
+
 World::World() 
   : mWorldReloadVar("WorldReload", Delegate<void>::FromMember<World, &World::Reload>(this)) {
 }
@@ -123,6 +127,16 @@ void World::Load() {
       }
     }
   }
+
+  BuildModelHierarchy();
+
+  for (PhysicsObject* object : mDynamicObjects) {
+    mBroadphase.Add(object, false);
+  }
+
+  for (PhysicsObject* object : mStaticObjects) {
+    mBroadphase.Add(object, true);
+  }
 }
 
 void World::Reload() {
@@ -133,6 +147,12 @@ void World::Reload() {
   mDynamicObjects.Clear();
   mStaticObjects.Clear();
 
+  mModelBounds.Clear();
+  mModelProxies.Clear();
+  mDynamicModels.Clear();
+  mModelHierarchy.Clear();
+  mBroadphase.Clear();
+
   mAudioPosition = 0;
 
   if (mAmbientTrack.data != nullptr) {
@@ -146,7 +166,7 @@ void World::Reload() {
   Load();
 }
 
-void World::TickPhysics(size_t deltaMs) {
+void World::TickPhysics(size_t deltaMs, ThreadPool& threadPool) {
   if (!(*PhysicsEnabled)) {
     return;
   }
@@ -163,42 +183,31 @@ void World::TickPhysics(size_t deltaMs) {
     }
   }
 
-  for (PhysicsObject*& currentObject : mDynamicObjects) {
-    // Check for collision against static objects.
-    for (PhysicsObject*& staticObject : mStaticObjects) {
-      float t0 = 0.f;
-      float t1 = 1.f;
-      float timeOfImpact = 0.f;
-
-      if (StaticContinuousTest(*currentObject, *staticObject, t0, t1, timeOfImpact)) {
-        //currentObject->OnCollisionStartDelegate(staticObject);
-        CorrectOverlappingObjects(*currentObject, *staticObject);
-        //currentObject->OnCollisionEndDelegate(staticObject);
-      }
-      else if (currentObject->TransformedAABB().Intersects(staticObject->TransformedAABB())) {
-        CorrectOverlappingObjects(*currentObject, *staticObject);
-      }
-    }
+  mBroadphase.Update();
 
-    // Check for collision against dynamic objects.
-    for (PhysicsObject*& dynamicObject : mDynamicObjects) {
-      if (currentObject == dynamicObject) {
-        continue;
-      }
+  const CollisionPair* pairs = mBroadphase.GetPairs();
+  const size_t numPairs = mBroadphase.GetNumPairs();
 
-      // Check for collision against dynamic objects.
-      float t0 = 0.f;
-      float t1 = 1.f;
-      float timeOfImpact = 0.f;
+  if (numPairs > 0) {
+    NamedScopedTimer(PhysicsNarrowphase);
 
-      if (DynamicContinuousTest(*currentObject, *dynamicObject, t0, t1, timeOfImpact)) {
-        //currentObject->OnCollisionStartDelegate(staticObject);
-        CorrectOverlappingObjects(*currentObject, *dynamicObject);
-        //currentObject->OnCollisionEndDelegate(staticObject);
-      }
-      else if (currentObject->TransformedAABB().Intersects(dynamicObject->TransformedAABB())) {
-        CorrectOverlappingObjects(*currentObject, *dynamicObject);
-      }
+    // Each pair only writes its own flag and nothing moves until every pair has been tested, so the pairs can run in any order.
+    if (mContactFlags.Size() < numPairs) {
+      mContactFlags.Resize(numPairs * 2);
+    }
+
+    ParallelIndexRange narrowphase = ParallelIndexRange::FromMember<World, &World::DetectContacts>(this);
+    JobHandle narrowphaseJob(threadPool.CreateJob(narrowphase, 0, numPairs));
+    threadPool.Submit(narrowphaseJob);
+    threadPool.Wait(narrowphaseJob);
+  }
+
+  // Resolve in pair order, which only depends on the scene, so replays come out the same no matter how the detection was scheduled.
+  for (size_t i = 0; i < numPairs; ++i) {
+    if (mContactFlags[i]) {
+      //pairs[i].a->OnCollisionStartDelegate(pairs[i].b);
+      CorrectOverlappingObjects(*pairs[i].a, *pairs[i].b);
+      //pairs[i].a->OnCollisionEndDelegate(pairs[i].b);
     }
   }
 
@@ -210,6 +219,29 @@ void World::TickPhysics(size_t deltaMs) {
   }
 }
 
+void World::DetectContacts(size_t begin, size_t end) {
+  const CollisionPair* pairs = mBroadphase.GetPairs();
+
+  for (size_t i = begin; i < end; ++i) {
+    PhysicsObject& currentObject = *pairs[i].a;
+    PhysicsObject& otherObject = *pairs[i].b;
+
+    float t0 = 0.f;
+    float t1 = 1.f;
+    float timeOfImpact = 0.f;
+
+    bool collided = false;
+    if (otherObject.Tag() == PhysicsTag::Static) {
+      collided = StaticContinuousTest(currentObject, otherObject, t0, t1, timeOfImpact);
+    }
+    else {
+      collided = DynamicContinuousTest(currentObject, otherObject, t0, t1, timeOfImpact);
+    }
+
+    mContactFlags[i] = (collided || currentObject.TransformedAABB().Intersects(otherObject.TransformedAABB())) ? 1 : 0;
+  }
+}
+
 void World::TickAudio(size_t deltaMs) {
   if (mAudioDevice != nullptr && mAmbientTrack.data != nullptr) {
     // TODO: This forces the track to loop.
@@ -224,11 +256,17 @@ void World::TickAudio(size_t deltaMs) {
 
 void World::LoadModels() {
   Bundle* bundle = GlobalBundle;
-  if (bundle->Assets().Size() == 0) {
+  if (bundle->NumAssets() == 0) {
     return;
   }
 
-  for (Asset& asset : bundle->Assets()) {
+  for (size_t i = 0; i < bundle->NumAssets(); ++i) {
+    Asset* bundleAsset = bundle->GetAsset(i);
+    if (bundleAsset == nullptr) {
+      continue;
+    }
+
+    Asset& asset = *bundleAsset;
     if (asset.Type() == AssetType::Model) {
       Model& model = mActiveModels.EmplaceBack();
       VertexBuffer& vertBuffer = mVertexBuffers.EmplaceBack();
@@ -286,7 +324,7 @@ void World::DebugLoadTriangle(const float* v1, const float* v2, const float* v3,
 
   if (isTextureMapped) {
     Bundle* bundle = GlobalBundle;
-    if (bundle->Assets().Size() == 0) {
+    if (bundle->NumAssets() == 0) {
       return;
     }
 
@@ -297,7 +335,7 @@ void World::DebugLoadTriangle(const float* v1, const float* v2, const float* v3,
       return;
     }
 
-    mesh.TextureId() = GlobalTexturePool->LoadTexture(*textureAsset);
+    mesh.TextureId() = GlobalTexturePool->LoadTexture(*textureAsset, *TiledTextures ? TextureLayout::Tiled : TextureLayout::Linear);
   }
 
   {
@@ -337,6 +375,14 @@ Array<IndexBuffer>& World::GetIndexBuffers() {
   return mIndexBuffers;
 }
 
+const Array<AABB>& World::GetModelBounds() const {
+  return mModelBounds;
+}
+
+const BoundingVolumeHierarchy& World::GetModelHierarchy() const {
+  return mModelHierarchy;
+}
+
 void World::LoadModel(Model& model, Asset& asset) {
   MemoryDeserializer meshDeserializer(asset.Loader());
 
@@ -354,7 +400,36 @@ void World::LoadModel(Model& model, Asset& asset) {
       return;
     }
 
-    mesh.TextureId() = GlobalTexturePool->LoadTexture(*textureAsset);
+    mesh.TextureId() = GlobalTexturePool->LoadTexture(*textureAsset, *TiledTextures ? TextureLayout::Tiled : TextureLayout::Linear);
+  }
+}
+
+void World::BuildModelHierarchy() {
+  NamedScopedTimer(WorldBuildModelHierarchy);
+
+  const size_t numModels = mActiveModels.Size();
+  mModelBounds.Resize(numModels);
+  mModelProxies.Resize(numModels);
+
+  for (size_t i = 0; i < numModels; ++i) {
+    Model& model = mActiveModels[i];
+    mModelBounds[i] = AABB::TransformAndRealign(model.BoundingBox(), model.ObjectTransform());
+    mModelProxies[i] = mModelHierarchy.Insert(mModelBounds[i], (int32)i);
+
+    if (model.Tag() == PhysicsTag::Dynamic) {
+      mDynamicModels.PushBack((int32)i);
+    }
+  }
+}
+
+void World::RefitModelHierarchy() {
+  NamedScopedTimer(WorldRefitModelHierarchy);
+
+  // Only dynamic models can move, everything static keeps the bounds it was loaded with.
+  for (int32 index : mDynamicModels) {
+    Model& model = mActiveModels[index];
+    mModelBounds[index] = AABB::TransformAndRealign(model.BoundingBox(), model.ObjectTransform());
+    mModelHierarchy.Move(mModelProxies[index], mModelBounds[index]);
   }
 }
 }
@@ -2,6 +2,7 @@
 
 #include "Array.h"
 #include "Asset.h"
+#include "BoundingVolumeHierarchy.h"
 #include "ConsoleVariable.h"
 #include "IndexBuffer.h"
 #include "Model.h"
@@ -10,6 +11,8 @@
 #include "VertexBuffer.h"
 #include "PlatformAudio.h"
 #include "Player.h"
+#include "SweepAndPrune.h"
+#include "ThreadPool.h"
 #include "MP3.h"
 
 namespace ZSharp {
@@ -28,10 +31,13 @@ class World final {
 
   void Reload();
 
-  void TickPhysics(size_t deltaMs);
+  void TickPhysics(size_t deltaMs, ThreadPool& threadPool);
 
   void TickAudio(size_t deltaMs);
 
+  // Rederives the bounds of every dynamic model, call once per frame after anything has moved them.
+  void RefitModelHierarchy();
+
   size_t GetTotalModels() const;
 
   Array<Model>& GetModels();
@@ -40,6 +46,11 @@ class World final {
 
   Array<IndexBuffer>& GetIndexBuffers();
 
+  // World space bounds of each model, kept up to date as physics moves them.
+  const Array<AABB>& GetModelBounds() const;
+
+  const BoundingVolumeHierarchy& GetModelHierarchy() const;
+
   private:
   bool mLoaded = false;
 
@@ -51,6 +62,14 @@ class World final {
   Array<PhysicsObject*> mDynamicObjects;
   Array<PhysicsObject*> mStaticObjects;
 
+  Array<AABB> mModelBounds;
+  Array<int32> mModelProxies;
+  Array<int32> mDynamicModels;
+  BoundingVolumeHierarchy mModelHierarchy;
+
+  SweepAndPrune mBroadphase;
+  Array<uint8> mContactFlags;
+
   PlatformAudioDevice* mAudioDevice = nullptr;
   MP3::PCMAudioFloat mAmbientTrack;
   size_t mAudioPosition = 0;
@@ -62,6 +81,11 @@ class World final {
   void LoadModels();
 
   void LoadModel(Model& model, Asset& asset);
+
+  void BuildModelHierarchy();
+
+  // Narrowphase for a range of broadphase pairs, safe to run on any thread.
+  void DetectContacts(size_t begin, size_t end);
 };
 
 }
@@ -1,5 +1,3 @@
-#ifdef PLATFORM_WINDOWS
-
 #include "PlatformIntrinsics.h"
 
 #include "ZBaseTypes.h"
@@ -7,17 +5,32 @@
 #include "PlatformDefines.h"
 #include "CommonMath.h"
 
+#include <cstdlib>
 #include <cstring>
 
 #ifdef HW_PLATFORM_X86
 
 #include <immintrin.h>
+
+#ifdef _MSC_VER
 #include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
 #include "Common.h"
+#include "ShaderDefinition.h"
+
+FORCE_INLINE void CPUID(int buffer[4], int leaf) {
+#ifdef _MSC_VER
+  __cpuid(buffer, leaf);
+#else
+  __cpuid_count(leaf, 0, buffer[0], buffer[1], buffer[2], buffer[3]);
+#endif
+}
 
 FORCE_INLINE void CPUIDSection00(int buffer[4]) {
-  __cpuid(buffer, 0x00);
+  CPUID(buffer, 0x00);
 
   // Note: GenuineIntel is not written as expected so we need to swap the last couple DWORDS
   ZSharp::Swap(buffer[3], buffer[2]);
@@ -28,7 +41,7 @@ FORCE_INLINE void CPUIDSection00(int buffer[4]) {
 }
 
 FORCE_INLINE void CPUIDSection01(int buffer[4]) {
-  __cpuid(buffer, 0x01);
+  CPUID(buffer, 0x01);
 
   // [0] = EAX
   // [1] = EBX
@@ -37,7 +50,7 @@ FORCE_INLINE void CPUIDSection01(int buffer[4]) {
 }
 
 FORCE_INLINE void CPUIDSection07(int buffer[4]) {
-  __cpuid(buffer, 0x07);
+  CPUID(buffer, 0x07);
 
   // [0] = EAX
   // [1] = EBX
@@ -46,9 +59,9 @@ FORCE_INLINE void CPUIDSection07(int buffer[4]) {
 }
 
 FORCE_INLINE void CPUIDSectionBrand(int buffer[12]) {
-  __cpuid(buffer, 0x80000002);
-  __cpuid(buffer + 4, 0x80000003);
-  __cpuid(buffer + 8, 0x80000004);
+  CPUID(buffer, 0x80000002);
+  CPUID(buffer + 4, 0x80000003);
+  CPUID(buffer + 8, 0x80000004);
 
   // [0] = EAX
   // [1] = EBX
@@ -94,12 +107,16 @@ namespace ZSharp {
 // TODO: Add more as needed here.
 RGBShaderFunc RGBShaderImpl = nullptr;
 UVShaderFunc UVShaderImpl = nullptr;
+UVShaderFunc UVBilinearShaderImpl = nullptr;
+UVShaderFunc UVTrilinearShaderImpl = nullptr;
 CalculateAABBFunc CalculateAABBImpl = nullptr;
 DrawDebugTextFunc DrawDebugTextImpl = nullptr;
 DepthBufferVisualizeFunc DepthBufferVisualizeImpl = nullptr;
 BlendBuffersFunc BlendBuffersImpl = nullptr;
 BilinearScaleImageFunc BilinearScaleImageImpl = nullptr;
 GenerateMipLevelFunc GenerateMipLevelImpl = nullptr;
+FrustumCullAABBFunc FrustumCullAABBImpl = nullptr;
+PNGUnfilterRowFunc PNGUnfilterRowImpl = nullptr;
 
 bool PlatformSupportsSIMDLanes(SIMDLaneWidth width) {
   int bits[4]{};
@@ -199,11 +216,20 @@ float Aligned_128MulSum(const float* a, const float* b) {
 }
 
 void Aligned_Memset(void* __restrict dest, uint32 value, const size_t numBytes) {
+#ifdef _MSC_VER
   __stosd((unsigned long*)dest, value, numBytes >> 2);
+#else
+  size_t count = numBytes >> 2;
+  asm volatile("rep stosl" : "+D"(dest), "+c"(count) : "a"(value) : "memory");
+#endif
 }
 
 void Aligned_Memcpy(void* __restrict dest, const void* __restrict src, size_t numBytes) {
+#ifdef _MSC_VER
   __movsb((unsigned char*)dest, (const unsigned char*)src, numBytes);
+#else
+  asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(numBytes) : : "memory");
+#endif
 }
 
 void Unaligned_128Add(const float* a, const float* b, float* dest) {
@@ -1078,10 +1104,22 @@ void Unaligned_BilinearScaleImage_AVX(uint8* __restrict source, size_t sourceWid
   }
 }
 
+// Texel pair a mip texel averages along a row, a single texel wide level pairs the texel with itself.
+static FORCE_INLINE __m128i LoadMipSourcePair(const uint8* __restrict texel, size_t lastWidth) {
+  if (lastWidth > 1) {
+    return _mm_loadu_si64(texel);
+  }
+  else {
+    __m128i single = _mm_loadu_si32(texel);
+    return _mm_unpacklo_epi32(single, single);
+  }
+}
+
 void Unaligned_GenerateMipLevel_SSE(uint8* __restrict nextMip, size_t nextWidth, size_t nextHeight, uint8* __restrict lastMip, size_t lastWidth, size_t lastHeight) {
-  (void)lastHeight;
   size_t nextMipStride = nextWidth * 4;
   size_t lastMipStride = lastWidth * 4;
+  // Once the height is down to one row, that row is also its own bottom neighbor.
+  size_t bottomRowOffset = (lastHeight > 1) ? lastMipStride : 0;
 
   __m128i shuffleLeftWide = _mm_set_epi8(
     0x80U, 11, 0x80U, 10,
@@ -1104,7 +1142,7 @@ void Unaligned_GenerateMipLevel_SSE(uint8* __restrict nextMip, size_t nextWidth,
       const size_t xStride = x * 4;
 
       uint8* __restrict topLeft = lastMip + (y * 2 * lastMipStride) + (xStride * 2);
-      uint8* __restrict bottomLeft = topLeft + lastMipStride;
+      uint8* __restrict bottomLeft = topLeft + bottomRowOffset;
 
       __m128i topData = _mm_lddqu_si128((__m128i*)topLeft);
       __m128i bottomData = _mm_lddqu_si128((__m128i*)bottomLeft);
@@ -1124,10 +1162,10 @@ void Unaligned_GenerateMipLevel_SSE(uint8* __restrict nextMip, size_t nextWidth,
       const size_t xStride = x * 4;
 
       uint8* __restrict topLeft = lastMip + (y * 2 * lastMipStride) + (xStride * 2);
-      uint8* __restrict bottomLeft = topLeft + lastMipStride;
+      uint8* __restrict bottomLeft = topLeft + bottomRowOffset;
 
-      __m128i topData = _mm_loadu_si64(topLeft);
-      __m128i bottomData = _mm_loadu_si64(bottomLeft);
+      __m128i topData = LoadMipSourcePair(topLeft, lastWidth);
+      __m128i bottomData = LoadMipSourcePair(bottomLeft, lastWidth);
 
       __m128i topLeftData = _mm_shuffle_epi8(topData, shuffleLeftWide);
       __m128i topRightData = _mm_shuffle_epi8(topData, shuffleRightWide);
@@ -1143,9 +1181,10 @@ void Unaligned_GenerateMipLevel_SSE(uint8* __restrict nextMip, size_t nextWidth,
 }
 
 void Unaligned_GenerateMipLevel_AVX(uint8* __restrict nextMip, size_t nextWidth, size_t nextHeight, uint8* __restrict lastMip, size_t lastWidth, size_t lastHeight) {
-  (void)lastHeight;
   size_t nextMipStride = nextWidth * 4;
   size_t lastMipStride = lastWidth * 4;
+  // Once the height is down to one row, that row is also its own bottom neighbor.
+  size_t bottomRowOffset = (lastHeight > 1) ? lastMipStride : 0;
 
   __m256i shuffleLeftWide = _mm256_set_epi8(
     0x80U, 11, 0x80U, 10,
@@ -1176,7 +1215,7 @@ void Unaligned_GenerateMipLevel_AVX(uint8* __restrict nextMip, size_t nextWidth,
       const size_t xStride = x * 4;
 
       uint8* __restrict topLeft = lastMip + (y * 2 * lastMipStride) + (xStride * 2);
-      uint8* __restrict bottomLeft = topLeft + lastMipStride;
+      uint8* __restrict bottomLeft = topLeft + bottomRowOffset;
 
       __m256i topData = _mm256_lddqu_si256((__m256i*)topLeft);
       __m256i bottomData = _mm256_lddqu_si256((__m256i*)bottomLeft);
@@ -1196,10 +1235,10 @@ void Unaligned_GenerateMipLevel_AVX(uint8* __restrict nextMip, size_t nextWidth,
       const size_t xStride = x * 4;
 
       uint8* __restrict topLeft = lastMip + (y * 2 * lastMipStride) + (xStride * 2);
-      uint8* __restrict bottomLeft = topLeft + lastMipStride;
+      uint8* __restrict bottomLeft = topLeft + bottomRowOffset;
 
-      __m128i topData = _mm_loadu_si64(topLeft);
-      __m128i bottomData = _mm_loadu_si64(bottomLeft);
+      __m128i topData = LoadMipSourcePair(topLeft, lastWidth);
+      __m128i bottomData = LoadMipSourcePair(bottomLeft, lastWidth);
 
       __m128i topLeftData = _mm_shuffle_epi8(topData, _mm256_castsi256_si128(shuffleLeftWide));
       __m128i topRightData = _mm_shuffle_epi8(topData, _mm256_castsi256_si128(shuffleRightWide));
@@ -1214,6 +1253,452 @@ void Unaligned_GenerateMipLevel_AVX(uint8* __restrict nextMip, size_t nextWidth,
   }
 }
 
+// PNG pixels are 3 or 4 bytes wide at 8 bits per channel, bytes past bpp are left untouched.
+static FORCE_INLINE __m128i PNGLoadPixel(const uint8* pixel, size_t bpp) {
+  uint32 value = 0;
+  if (bpp == 4) {
+    memcpy(&value, pixel, 4);
+  }
+  else {
+    uint16 low = 0;
+    memcpy(&low, pixel, 2);
+    value = low | (((uint32)pixel[2]) << 16);
+  }
+
+  return _mm_cvtsi32_si128((int32)value);
+}
+
+static FORCE_INLINE void PNGStorePixel(uint8* pixel, __m128i value, size_t bpp) {
+  const uint32 bytes = (uint32)_mm_cvtsi128_si32(value);
+  if (bpp == 4) {
+    memcpy(pixel, &bytes, 4);
+  }
+  else {
+    const uint16 low = (uint16)bytes;
+    memcpy(pixel, &low, 2);
+    pixel[2] = (uint8)(bytes >> 16);
+  }
+}
+
+// Handles 16 bit images and anything else that doesn't fit the pixel at a time paths.
+static void PNGUnfilterRow_Scalar(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp) {
+  for (size_t x = 0; x < length; ++x) {
+    const int32 left = (x < bpp) ? 0 : dest[x - bpp];
+    const int32 up = above[x];
+    const int32 upLeft = (x < bpp) ? 0 : above[x - bpp];
+
+    int32 prediction = 0;
+    switch (filter) {
+      case 1:
+        prediction = left;
+        break;
+      case 2:
+        prediction = up;
+        break;
+      case 3:
+        prediction = (left + up) >> 1;
+        break;
+      case 4:
+      {
+        const int32 p = left + up - upLeft;
+        const int32 pa = abs(p - left);
+        const int32 pb = abs(p - up);
+        const int32 pc = abs(p - upLeft);
+        prediction = ((pa <= pb) && (pa <= pc)) ? left : ((pb <= pc) ? up : upLeft);
+      }
+        break;
+      default:
+        break;
+    }
+
+    dest[x] = (uint8)(row[x] + prediction);
+  }
+}
+
+static void PNGUnfilterSub_SSE(const uint8* __restrict row, uint8* __restrict dest, size_t length, size_t bpp) {
+  size_t x = 0;
+  __m128i last = _mm_setzero_si128();
+
+  // Prefix sum over the pixels in a register, then add in the last pixel of the previous block.
+  if (bpp == 4) {
+    for (; (x + 16) <= length; x += 16) {
+      __m128i sum = _mm_loadu_si128((const __m128i*)(row + x));
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 4));
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 8));
+      sum = _mm_add_epi8(sum, _mm_shuffle_epi32(last, 0xFF));
+      _mm_storeu_si128((__m128i*)(dest + x), sum);
+      last = sum;
+    }
+
+    last = _mm_srli_si128(last, 12);
+  }
+  else {
+    // Five 3 byte pixels per block, the 16th byte is rewritten by the next block.
+    const __m128i broadcastLast = _mm_set_epi8(
+      0x80U, 14, 13, 12,
+      14, 13, 12, 14,
+      13, 12, 14, 13,
+      12, 14, 13, 12);
+
+    for (; (x + 16) <= length; x += 15) {
+      __m128i sum = _mm_loadu_si128((const __m128i*)(row + x));
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 3));
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 6));
+      sum = _mm_add_epi8(sum, _mm_slli_si128(sum, 12));
+      sum = _mm_add_epi8(sum, _mm_shuffle_epi8(last, broadcastLast));
+      _mm_storeu_si128((__m128i*)(dest + x), sum);
+      last = sum;
+    }
+
+    last = _mm_srli_si128(last, 12);
+  }
+
+  for (; x < length; x += bpp) {
+    last = _mm_add_epi8(PNGLoadPixel(row + x, bpp), last);
+    PNGStorePixel(dest + x, last, bpp);
+  }
+}
+
+static void PNGUnfilterAverage_SSE(const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp) {
+  const __m128i ones = _mm_set1_epi8(1);
+  __m128i left = _mm_setzero_si128();
+
+  // _mm_avg_epu8 rounds up, take the carry back off to get the floor.
+  for (size_t x = 0; x < length; x += bpp) {
+    __m128i up = PNGLoadPixel(above + x, bpp);
+    __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), ones));
+    left = _mm_add_epi8(PNGLoadPixel(row + x, bpp), average);
+    PNGStorePixel(dest + x, left, bpp);
+  }
+}
+
+static void PNGUnfilterPaeth_SSE(const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i left = zero;
+  __m128i upLeft = zero;
+
+  // Predictors are widened to 16 bits so the distances can't wrap.
+  for (size_t x = 0; x < length; x += bpp) {
+    __m128i up = _mm_unpacklo_epi8(PNGLoadPixel(above + x, bpp), zero);
+
+    __m128i pa = _mm_sub_epi16(up, upLeft);
+    __m128i pb = _mm_sub_epi16(left, upLeft);
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+    pa = _mm_abs_epi16(pa);
+    pb = _mm_abs_epi16(pb);
+
+    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+    // Ties go to left, then up, then upper left.
+    __m128i nearest = _mm_blendv_epi8(upLeft, up, _mm_cmpeq_epi16(smallest, pb));
+    nearest = _mm_blendv_epi8(nearest, left, _mm_cmpeq_epi16(smallest, pa));
+
+    __m128i pixel = _mm_add_epi8(PNGLoadPixel(row + x, bpp), _mm_packus_epi16(nearest, nearest));
+    PNGStorePixel(dest + x, pixel, bpp);
+
+    left = _mm_unpacklo_epi8(pixel, zero);
+    upLeft = up;
+  }
+}
+
+void Unaligned_PNGUnfilterRow_SSE(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp) {
+  if ((bpp != 3) && (bpp != 4)) {
+    PNGUnfilterRow_Scalar(filter, row, above, dest, length, bpp);
+    return;
+  }
+
+  switch (filter) {
+    case 0:
+      memcpy(dest, row, length);
+      break;
+    case 1:
+      PNGUnfilterSub_SSE(row, dest, length, bpp);
+      break;
+    case 2:
+    {
+      size_t x = 0;
+      for (; (x + 16) <= length; x += 16) {
+        __m128i sum = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(row + x)), _mm_loadu_si128((const __m128i*)(above + x)));
+        _mm_storeu_si128((__m128i*)(dest + x), sum);
+      }
+
+      for (; x < length; ++x) {
+        dest[x] = (uint8)(row[x] + above[x]);
+      }
+    }
+      break;
+    case 3:
+      PNGUnfilterAverage_SSE(row, above, dest, length, bpp);
+      break;
+    case 4:
+      PNGUnfilterPaeth_SSE(row, above, dest, length, bpp);
+      break;
+    default:
+      ZAssert(false);
+      break;
+  }
+}
+
+void Unaligned_PNGUnfilterRow_AVX(uint8 filter, const uint8* __restrict row, const uint8* __restrict above, uint8* __restrict dest, size_t length, size_t bpp) {
+  // Only Up is independent across a whole row, the others carry a dependency from one pixel to the next.
+  if ((filter != 2) || ((bpp != 3) && (bpp != 4))) {
+    Unaligned_PNGUnfilterRow_SSE(filter, row, above, dest, length, bpp);
+    return;
+  }
+
+  size_t x = 0;
+  for (; (x + 32) <= length; x += 32) {
+    __m256i sum = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(row + x)), _mm256_loadu_si256((const __m256i*)(above + x)));
+    _mm256_storeu_si256((__m256i*)(dest + x), sum);
+  }
+
+  for (; x < length; ++x) {
+    dest[x] = (uint8)(row[x] + above[x]);
+  }
+}
+
+static uint32 CRC32_Scalar(const uint8* data, size_t length, uint32 crc) {
+  static uint32 table[256] = {};
+
+  if (table[1] == 0) {
+    for (uint32 i = 0; i < 256; ++i) {
+      uint32 value = i;
+      for (size_t bit = 0; bit < 8; ++bit) {
+        value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+      }
+
+      table[i] = value;
+    }
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+
+  return crc;
+}
+
+uint32 Unaligned_CRC32(const uint8* data, size_t length, uint32 crc) {
+  // PCLMULQDQ ships on every CPU with AVX2, older ones stay on the table.
+  static const bool usePCLMUL = PlatformSupportsSIMDLanes(SIMDLaneWidth::Eight);
+  if ((length < 64) || !usePCLMUL) {
+    return CRC32_Scalar(data, length, crc);
+  }
+
+  // Folds 64 bytes at a time with carry-less multiplies, then reduces down to 32 bits with Barrett reduction.
+  // See: "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel 2009.
+  // The constants are for the bit reflected CRC-32 polynomial.
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i lowMask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i x1 = _mm_loadu_si128((const __m128i*)(data + 0x00));
+  __m128i x2 = _mm_loadu_si128((const __m128i*)(data + 0x10));
+  __m128i x3 = _mm_loadu_si128((const __m128i*)(data + 0x20));
+  __m128i x4 = _mm_loadu_si128((const __m128i*)(data + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int32)crc));
+
+  data += 64;
+  length -= 64;
+
+  for (; length >= 64; data += 64, length -= 64) {
+    __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(data + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(data + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(data + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(data + 0x30)));
+  }
+
+  // Fold the four lanes into one.
+  __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  for (; length >= 16; data += 16, length -= 16) {
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)data)), x5);
+  }
+
+  // 128 bits down to 64.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, lowMask);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits.
+  x2 = _mm_and_si128(x1, lowMask);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, lowMask);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  crc = (uint32)_mm_extract_epi32(x1, 1);
+  return CRC32_Scalar(data, length, crc);
+}
+
+uint32 Unaligned_Adler32(const uint8* data, size_t length, uint32 adler) {
+  const uint32 AdlerMod = 65521;
+  // Largest run that can't overflow the 32 bit sums before taking the modulus.
+  const size_t MaxRun = 5552;
+  const size_t BlockSize = 32;
+
+  uint32 a = adler & 0xFFFF;
+  uint32 b = adler >> 16;
+
+  /*
+  Each 32 byte block adds the byte sum to a, and to b it adds 32 * a from before the block plus the bytes weighted 32..1.
+  The weighted sums come from maddubs, the plain sums from sad against zero.
+  */
+  static const bool useAVX = PlatformSupportsSIMDLanes(SIMDLaneWidth::Eight);
+  size_t blocks = length / BlockSize;
+  length -= blocks * BlockSize;
+
+  while (blocks > 0) {
+    size_t n = MaxRun / BlockSize;
+    n = (n > blocks) ? blocks : n;
+    blocks -= n;
+
+    __m128i blockSums;
+    __m128i byteSums;
+    __m128i previousA = _mm_cvtsi32_si128((int32)(a * n));
+
+    if (useAVX) {
+      const __m256i taps = _mm256_setr_epi8(
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+      const __m256i ones = _mm256_set1_epi16(1);
+      const __m256i zero = _mm256_setzero_si256();
+
+      __m256i vPrevious = _mm256_setzero_si256();
+      __m256i vA = _mm256_setzero_si256();
+      __m256i vB = _mm256_setzero_si256();
+
+      for (size_t i = 0; i < n; ++i, data += BlockSize) {
+        const __m256i bytes = _mm256_loadu_si256((const __m256i*)data);
+        vPrevious = _mm256_add_epi32(vPrevious, vA);
+        vA = _mm256_add_epi32(vA, _mm256_sad_epu8(bytes, zero));
+        vB = _mm256_add_epi32(vB, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, taps), ones));
+      }
+
+      vB = _mm256_add_epi32(vB, _mm256_slli_epi32(vPrevious, 5));
+      byteSums = _mm_add_epi32(_mm256_castsi256_si128(vA), _mm256_extracti128_si256(vA, 1));
+      blockSums = _mm_add_epi32(_mm256_castsi256_si128(vB), _mm256_extracti128_si256(vB, 1));
+    }
+    else {
+      const __m128i tapsLow = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+      const __m128i tapsHigh = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+      const __m128i ones = _mm_set1_epi16(1);
+      const __m128i zero = _mm_setzero_si128();
+
+      __m128i vPrevious = _mm_setzero_si128();
+      __m128i vA = _mm_setzero_si128();
+      __m128i vB = _mm_setzero_si128();
+
+      for (size_t i = 0; i < n; ++i, data += BlockSize) {
+        const __m128i low = _mm_loadu_si128((const __m128i*)data);
+        const __m128i high = _mm_loadu_si128((const __m128i*)(data + 16));
+        vPrevious = _mm_add_epi32(vPrevious, vA);
+        vA = _mm_add_epi32(vA, _mm_add_epi32(_mm_sad_epu8(low, zero), _mm_sad_epu8(high, zero)));
+        vB = _mm_add_epi32(vB, _mm_madd_epi16(_mm_maddubs_epi16(low, tapsLow), ones));
+        vB = _mm_add_epi32(vB, _mm_madd_epi16(_mm_maddubs_epi16(high, tapsHigh), ones));
+      }
+
+      vB = _mm_add_epi32(vB, _mm_slli_epi32(vPrevious, 5));
+      byteSums = vA;
+      blockSums = vB;
+    }
+
+    blockSums = _mm_add_epi32(blockSums, _mm_slli_epi32(previousA, 5));
+    byteSums = _mm_add_epi32(byteSums, _mm_shuffle_epi32(byteSums, _MM_SHUFFLE(1, 0, 3, 2)));
+    blockSums = _mm_add_epi32(blockSums, _mm_shuffle_epi32(blockSums, _MM_SHUFFLE(2, 3, 0, 1)));
+    blockSums = _mm_add_epi32(blockSums, _mm_shuffle_epi32(blockSums, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    a += (uint32)_mm_cvtsi128_si32(byteSums);
+    b += (uint32)_mm_cvtsi128_si32(blockSums);
+    a %= AdlerMod;
+    b %= AdlerMod;
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    a += data[i];
+    b += a;
+  }
+
+  a %= AdlerMod;
+  b %= AdlerMod;
+
+  return (b << 16) | a;
+}
+
+static size_t FirstSetBit(uint32 mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+size_t Unaligned_FindNewline(const char* data, size_t length) {
+  // Called once per line, CPUID is far too slow to ask every time.
+  static const bool useAVX = PlatformSupportsSIMDLanes(SIMDLaneWidth::Eight);
+
+  size_t offset = 0;
+
+  // Never reads past length, the tail of a memory mapped file may sit right at the end of the last page.
+  if (useAVX) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; offset + 32 <= length; offset += 32) {
+      const __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + offset));
+      const uint32 mask = (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline));
+      if (mask != 0) {
+        return offset + FirstSetBit(mask);
+      }
+    }
+  }
+
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; offset + 16 <= length; offset += 16) {
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)(data + offset));
+    const uint32 mask = (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline));
+    if (mask != 0) {
+      return offset + FirstSetBit(mask);
+    }
+  }
+
+  for (; offset < length; ++offset) {
+    if (data[offset] == '\n') {
+      return offset;
+    }
+  }
+
+  return length;
+}
+
 void Unaligned_DrawDebugText_SSE(const uint8 lut[128][8], const String& message, size_t x, size_t y, uint8* buffer, size_t width, const ZColor& color) {
   size_t xOffset = x;
   size_t yOffset = y;
@@ -1320,6 +1805,54 @@ void Aligned_Mat4x4Transform(const float matrix[4][4], float* __restrict data, i
   }
 }
 
+void Aligned_Mat4x4TransformCopy(const float matrix[4][4], const float* __restrict source, float* __restrict dest, int32 stride, int32 length) {
+  __m128 matrixX = _mm_loadu_ps(matrix[0]);
+  __m128 matrixY = _mm_loadu_ps(matrix[1]);
+  __m128 matrixZ = _mm_loadu_ps(matrix[2]);
+  __m128 matrixW = _mm_loadu_ps(matrix[3]);
+
+  __m128 loXY = _mm_unpacklo_ps(matrixX, matrixY);
+  __m128 loZW = _mm_unpacklo_ps(matrixZ, matrixW);
+  __m128 hiXY = _mm_unpackhi_ps(matrixX, matrixY);
+  __m128 hiZW = _mm_unpackhi_ps(matrixZ, matrixW);
+
+  matrixX = _mm_shuffle_ps(loXY, loZW, 0b01000100);
+  matrixY = _mm_shuffle_ps(loXY, loZW, 0b11101110);
+  matrixZ = _mm_shuffle_ps(hiXY, hiZW, 0b01000100);
+  matrixW = _mm_shuffle_ps(hiXY, hiZW, 0b11101110);
+
+  // Attributes past the position are carried over untouched in the same pass.
+  const int32 attributeVectors = (stride - 4) >> 2;
+  const int32 attributeRemainder = (stride - 4) & 3;
+
+  for (int32 i = 0; i < length; i += stride) {
+    const float* __restrict srcData = source + i;
+    float* __restrict destData = dest + i;
+
+    __m128 xyzw = _mm_loadu_ps(srcData);
+
+    __m128 vecX = _mm_shuffle_ps(xyzw, xyzw, 0b00000000);
+    __m128 vecY = _mm_shuffle_ps(xyzw, xyzw, 0b01010101);
+    __m128 vecZ = _mm_shuffle_ps(xyzw, xyzw, 0b10101010);
+    __m128 vecW = _mm_shuffle_ps(xyzw, xyzw, 0b11111111);
+
+    __m128 result = _mm_add_ps(_mm_mul_ps(matrixX, vecX), _mm_mul_ps(matrixY, vecY));
+    result = _mm_add_ps(result, _mm_mul_ps(matrixZ, vecZ));
+    result = _mm_add_ps(result, _mm_mul_ps(matrixW, vecW));
+
+    _mm_storeu_ps(destData, result);
+
+    int32 j = 4;
+    for (int32 k = 0; k < attributeVectors; ++k, j += 4) {
+      _mm_storeu_ps(destData + j, _mm_loadu_ps(srcData + j));
+    }
+
+    for (int32 k = 0; k < attributeRemainder; ++k, ++j) {
+      destData[j] = srcData[j];
+    }
+  }
+}
+
 void Aligned_DepthBufferVisualize_SSE(float* buffer, size_t width, size_t height) {
   const float colorScaleValue = -255.f;
 
@@ -1862,8 +2395,557 @@ void Unaligned_AABB_TransformAndRealign(const float* inMin, const float* inMax,
   _mm_storeu_ps(outMax, outMaxVec);
 }
 
-void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer) {
+// Same classification as the SIMD paths for the boxes left over after the last full vector.
+static void FrustumCullAABB_Scalar(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t begin, size_t end, int32* __restrict outClip) {
+  for (size_t i = begin; i < end; ++i) {
+    int32 clip = FrustumInside;
+
+    for (size_t p = 0; p < 6; ++p) {
+      float nearest = planes[p][3];
+      float farthest = planes[p][3];
+
+      for (size_t axis = 0; axis < 3; ++axis) {
+        const float minDist = planes[p][axis] * boxMin[axis][i];
+        const float maxDist = planes[p][axis] * boxMax[axis][i];
+        nearest += (minDist < maxDist) ? minDist : maxDist;
+        farthest += (minDist < maxDist) ? maxDist : minDist;
+      }
+
+      if (farthest < 0.f) {
+        clip = FrustumOutside;
+        break;
+      }
+      else if ((nearest < 0.f) && (clip == FrustumInside)) {
+        clip = (p == 0) ? FrustumClippedNear : FrustumClippedNDC;
+      }
+    }
+
+    outClip[i] = clip;
+  }
+}
+
+void Unaligned_FrustumCullAABB_SSE(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t count, int32* __restrict outClip) {
+  const size_t simdLength = (count >> 2) << 2;
+
+  for (size_t i = 0; i < simdLength; i += 4) {
+    const __m128 minX = _mm_loadu_ps(boxMin[0] + i);
+    const __m128 minY = _mm_loadu_ps(boxMin[1] + i);
+    const __m128 minZ = _mm_loadu_ps(boxMin[2] + i);
+    const __m128 maxX = _mm_loadu_ps(boxMax[0] + i);
+    const __m128 maxY = _mm_loadu_ps(boxMax[1] + i);
+    const __m128 maxZ = _mm_loadu_ps(boxMax[2] + i);
+
+    __m128 outside = _mm_setzero_ps();
+    __m128 clippedNear = _mm_setzero_ps();
+    __m128 clippedNDC = _mm_setzero_ps();
+
+    for (size_t p = 0; p < 6; ++p) {
+      const __m128 planeX = _mm_set_ps1(planes[p][0]);
+      const __m128 planeY = _mm_set_ps1(planes[p][1]);
+      const __m128 planeZ = _mm_set_ps1(planes[p][2]);
+      const __m128 planeD = _mm_set_ps1(planes[p][3]);
+
+      // Taking the min/max of each axis picks the corners closest to and farthest along the plane normal.
+      const __m128 minDistX = _mm_mul_ps(planeX, minX);
+      const __m128 minDistY = _mm_mul_ps(planeY, minY);
+      const __m128 minDistZ = _mm_mul_ps(planeZ, minZ);
+      const __m128 maxDistX = _mm_mul_ps(planeX, maxX);
+      const __m128 maxDistY = _mm_mul_ps(planeY, maxY);
+      const __m128 maxDistZ = _mm_mul_ps(planeZ, maxZ);
+
+      const __m128 nearest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_min_ps(minDistX, maxDistX), _mm_min_ps(minDistY, maxDistY)), _mm_min_ps(minDistZ, maxDistZ)), planeD);
+      const __m128 farthest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_max_ps(minDistX, maxDistX), _mm_max_ps(minDistY, maxDistY)), _mm_max_ps(minDistZ, maxDistZ)), planeD);
+
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(farthest, _mm_setzero_ps()));
+
+      if (p == 0) {
+        clippedNear = _mm_cmplt_ps(nearest, _mm_setzero_ps());
+      }
+      else {
+        clippedNDC = _mm_or_ps(clippedNDC, _mm_cmplt_ps(nearest, _mm_setzero_ps()));
+      }
+    }
+
+    // Outside wins over a near clip which wins over an NDC clip.
+    __m128 result = _mm_and_ps(clippedNDC, _mm_castsi128_ps(_mm_set1_epi32(FrustumClippedNDC)));
+    result = _mm_blendv_ps(result, _mm_castsi128_ps(_mm_set1_epi32(FrustumClippedNear)), clippedNear);
+    result = _mm_blendv_ps(result, _mm_castsi128_ps(_mm_set1_epi32(FrustumOutside)), outside);
+
+    _mm_storeu_si128((__m128i*)(outClip + i), _mm_castps_si128(result));
+  }
+
+  FrustumCullAABB_Scalar(planes, boxMin, boxMax, simdLength, count, outClip);
+}
+
+void Unaligned_FrustumCullAABB_AVX(const float planes[6][4], const float* const boxMin[3], const float* const boxMax[3],
+  size_t count, int32* __restrict outClip) {
+  const size_t simdLength = (count >> 3) << 3;
+
+  for (size_t i = 0; i < simdLength; i += 8) {
+    const __m256 minX = _mm256_loadu_ps(boxMin[0] + i);
+    const __m256 minY = _mm256_loadu_ps(boxMin[1] + i);
+    const __m256 minZ = _mm256_loadu_ps(boxMin[2] + i);
+    const __m256 maxX = _mm256_loadu_ps(boxMax[0] + i);
+    const __m256 maxY = _mm256_loadu_ps(boxMax[1] + i);
+    const __m256 maxZ = _mm256_loadu_ps(boxMax[2] + i);
+
+    __m256 outside = _mm256_setzero_ps();
+    __m256 clippedNear = _mm256_setzero_ps();
+    __m256 clippedNDC = _mm256_setzero_ps();
+
+    for (size_t p = 0; p < 6; ++p) {
+      const __m256 planeX = _mm256_set1_ps(planes[p][0]);
+      const __m256 planeY = _mm256_set1_ps(planes[p][1]);
+      const __m256 planeZ = _mm256_set1_ps(planes[p][2]);
+      const __m256 planeD = _mm256_set1_ps(planes[p][3]);
+
+      const __m256 minDistX = _mm256_mul_ps(planeX, minX);
+      const __m256 minDistY = _mm256_mul_ps(planeY, minY);
+      const __m256 minDistZ = _mm256_mul_ps(planeZ, minZ);
+      const __m256 maxDistX = _mm256_mul_ps(planeX, maxX);
+      const __m256 maxDistY = _mm256_mul_ps(planeY, maxY);
+      const __m256 maxDistZ = _mm256_mul_ps(planeZ, maxZ);
+
+      const __m256 nearest = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_min_ps(minDistX, maxDistX), _mm256_min_ps(minDistY, maxDistY)), _mm256_min_ps(minDistZ, maxDistZ)), planeD);
+      const __m256 farthest = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_max_ps(minDistX, maxDistX), _mm256_max_ps(minDistY, maxDistY)), _mm256_max_ps(minDistZ, maxDistZ)), planeD);
+
+      outside = _mm256_or_ps(outside, _mm256_cmp_ps(farthest, _mm256_setzero_ps(), _CMP_LT_OQ));
+
+      if (p == 0) {
+        clippedNear = _mm256_cmp_ps(nearest, _mm256_setzero_ps(), _CMP_LT_OQ);
+      }
+      else {
+        clippedNDC = _mm256_or_ps(clippedNDC, _mm256_cmp_ps(nearest, _mm256_setzero_ps(), _CMP_LT_OQ));
+      }
+    }
+
+    __m256 result = _mm256_and_ps(clippedNDC, _mm256_castsi256_ps(_mm256_set1_epi32(FrustumClippedNDC)));
+    result = _mm256_blendv_ps(result, _mm256_castsi256_ps(_mm256_set1_epi32(FrustumClippedNear)), clippedNear);
+    result = _mm256_blendv_ps(result, _mm256_castsi256_ps(_mm256_set1_epi32(FrustumOutside)), outside);
+
+    _mm256_storeu_si256((__m256i*)(outClip + i), _mm256_castps_si256(result));
+  }
+
+  // Finish any remaining group of four before falling back to scalar.
+  const float* tailMin[3] = { boxMin[0] + simdLength, boxMin[1] + simdLength, boxMin[2] + simdLength };
+  const float* tailMax[3] = { boxMax[0] + simdLength, boxMax[1] + simdLength, boxMax[2] + simdLength };
+  Unaligned_FrustumCullAABB_SSE(planes, tailMin, tailMax, count - simdLength, outClip + simdLength);
+}
+
+// The depth written is the reciprocal of the interpolated vertex W, which always lies between the vertex extremes.
+// W is negative in front of the camera so the smallest W gives the nearest (largest) depth.
+// Pad both ends a little to cover the error from the reciprocal approximation.
+static constexpr float HiZEpsilon = 1.f / 512.f;
+
+FORCE_INLINE float HiZNearestDepth(const float* __restrict v1, const float* __restrict v2, const float* __restrict v3) {
+  const float depth = 1.f / fminf(v1[3], fminf(v2[3], v3[3]));
+  return depth + (fabsf(depth) * HiZEpsilon);
+}
+
+FORCE_INLINE float HiZFarthestDepth(const float* __restrict v1, const float* __restrict v2, const float* __restrict v3) {
+  const float depth = 1.f / fmaxf(v1[3], fmaxf(v2[3], v3[3]));
+  return depth - (fabsf(depth) * HiZEpsilon);
+}
+
+// True if every block under the bounding box already holds something closer than the triangle can ever be.
+static bool HiZTriangleOccluded(const float* __restrict hiZ, const int32 hiZWidth, const int32 minX, const int32 minY, const int32 maxX, const int32 maxY, const float nearestDepth) {
+  const int32 blockMaxX = (maxX - 1) >> HiZBlockShift;
+  const int32 blockMaxY = (maxY - 1) >> HiZBlockShift;
+
+  for (int32 by = minY >> HiZBlockShift; by <= blockMaxY; ++by) {
+    const float* __restrict row = hiZ + (by * hiZWidth);
+    for (int32 bx = minX >> HiZBlockShift; bx <= blockMaxX; ++bx) {
+      if (row[bx] <= nearestDepth) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Raise the farthest depth of every block the triangle fully covers.
+// Blocks only partially covered are left alone since some of their pixels may still be further away.
+static void HiZUpdateCovered(float* __restrict hiZ, const int32 hiZWidth, const int32 minX, const int32 minY, const int32 maxX, const int32 maxY,
+  const float* __restrict v1, const float* __restrict v2, const float* __restrict v3) {
+  const float farthestDepth = HiZFarthestDepth(v1, v2, v3);
+
+  const float x0 = v1[0];
+  const float y0 = v1[1];
+  const float x1 = v2[0];
+  const float y1 = v2[1];
+  const float x2 = v3[0];
+  const float y2 = v3[1];
+
+  const int32 blockMaxX = (maxX - 1) >> HiZBlockShift;
+  const int32 blockMaxY = (maxY - 1) >> HiZBlockShift;
+
+  for (int32 by = minY >> HiZBlockShift; by <= blockMaxY; ++by) {
+    float* __restrict row = hiZ + (by * hiZWidth);
+    for (int32 bx = minX >> HiZBlockShift; bx <= blockMaxX; ++bx) {
+      if (row[bx] >= farthestDepth) {
+        continue;
+      }
+
+      // Test the corners one pixel outside of the block so rounding in the raster loop can't leave a pixel uncovered.
+      const float left = (float)((bx << HiZBlockShift) - 1);
+      const float top = (float)((by << HiZBlockShift) - 1);
+      const float right = left + (float)(HiZBlockSize + 1);
+      const float bottom = top + (float)(HiZBlockSize + 1);
+      const float cornersX[4] = { left, right, left, right };
+      const float cornersY[4] = { top, top, bottom, bottom };
+
+      bool covered = true;
+      for (int32 c = 0; (c < 4) && covered; ++c) {
+        // Same edge functions as the raster loops, inside is >= 0.
+        const float w0 = ((cornersX[c] - x1) * (y2 - y1)) - ((cornersY[c] - y1) * (x2 - x1));
+        const float w1 = ((cornersX[c] - x2) * (y0 - y2)) - ((cornersY[c] - y2) * (x0 - x2));
+        const float w2 = ((cornersX[c] - x0) * (y1 - y0)) - ((cornersY[c] - y0) * (x1 - x0));
+        covered = (w0 > 0.f) && (w1 > 0.f) && (w2 > 0.f);
+      }
+
+      if (covered) {
+        row[bx] = farthestDepth;
+      }
+    }
+  }
+}
+
+// Level of detail for a triangle from how many base level texels land on each pixel it covers.
+// Every level halves both dimensions, so the level is half the log2 of the texel to pixel area ratio.
+// Rectangular chains only halve the long side once the short one hits 1, those last few levels are picked a little sharp.
+static float TriangleMipLod(const float* __restrict v1, const float* __restrict v2, const float* __restrict v3, const float baseTexels) {
+  const float pixelArea = fabsf(((v2[0] - v1[0]) * (v3[1] - v1[1])) - ((v3[0] - v1[0]) * (v2[1] - v1[1])));
+
+  // The UVs were divided by W for perspective correct interpolation, undo that to get the footprint in the texture.
+  const float w1 = 1.f / v1[3];
+  const float w2 = 1.f / v2[3];
+  const float w3 = 1.f / v3[3];
+  const float u1 = v1[4] * w1;
+  const float t1 = v1[5] * w1;
+  const float u2u1 = (v2[4] * w2) - u1;
+  const float t2t1 = (v2[5] * w2) - t1;
+  const float u3u1 = (v3[4] * w3) - u1;
+  const float t3t1 = (v3[5] * w3) - t1;
+  const float texelArea = fabsf((u2u1 * t3t1) - (u3u1 * t2t1)) * baseTexels;
+
+  // Magnified or degenerate UVs always want the base level.
+  // A zero pixel area gives an infinite LOD which callers clamp to the end of the chain.
+  if (!(texelArea > pixelArea)) {
+    return 0.f;
+  }
+
+  return 0.5f * log2f(texelArea / pixelArea);
+}
+
+// Point and bilinear sampling use the nearest level, trilinear also blends toward the next one.
+// The blend is an 8 bit fraction so it can go straight into the integer lerps.
+static size_t SelectTriangleMip(const TextureFilter filter, const float lod, const size_t lastMip, int32& blend) {
+  blend = 0;
+
+  if (!(lod < (float)lastMip)) {
+    return lastMip;
+  }
+
+  if (filter == TextureFilter::Trilinear) {
+    const size_t level = (size_t)lod;
+    blend = (int32)((lod - (float)level) * 256.f);
+    return level;
+  }
+
+  return (size_t)(lod + 0.5f);
+}
+
+// Bilinear footprints are 2x2, filtered sampling stops at the last level that is at least that big.
+static size_t LastFilterableMip(const Texture* __restrict texture, const TextureFilter filter) {
+  size_t lastMip = texture->NumMips() - 1;
+
+  if (filter != TextureFilter::Point) {
+    while ((lastMip > 0) && ((texture->Width(lastMip) < 2) || (texture->Height(lastMip) < 2))) {
+      --lastMip;
+    }
+  }
+
+  return lastMip;
+}
+
+// Everything the UV shaders need to address one level of the mip chain.
+// Levels can be any size, so U and V get their own scale and limit.
+struct UVShaderLevel {
+  const uint32* __restrict data;
+  int32 stride;
+  // Last texel a 2x2 bilinear footprint can start on.
+  int32 xLimit;
+  int32 yLimit;
+  // Scales a normalized UV to texel coordinates, also the largest coordinate in the level.
+  float maxU;
+  float maxV;
+};
+
+static UVShaderLevel GetUVShaderLevel(const Texture* __restrict texture, const size_t mipLevel) {
+  UVShaderLevel level;
+  level.data = (const uint32*)texture->Data(mipLevel);
+  level.stride = (int32)texture->Width(mipLevel);
+  level.xLimit = (int32)texture->Width(mipLevel) - 2;
+  level.yLimit = (int32)texture->Height(mipLevel) - 2;
+  level.maxU = (float)(texture->Width(mipLevel) - 1);
+  level.maxV = (float)(texture->Height(mipLevel) - 1);
+  return level;
+}
+
+// Rounded down levels of odd sizes aren't exactly half, trilinear rescales each axis by the real ratio.
+// Single texel axes only show up past LastFilterableMip, so the divide is never by zero when it matters.
+static float NextLevelScale(const float maxNext, const float maxCurrent) {
+  return (maxCurrent > 0.f) ? (maxNext / maxCurrent) : 0.f;
+}
+
+// a * (256 - weight) + b * weight tops out at 255 * 256, so the sum never overflows 16 bits for weights in [0, 256].
+FORCE_INLINE __m128i LerpFixed128(const __m128i a, const __m128i b, const __m128i weight, const __m128i weightInv) {
+  return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, weightInv), _mm_mullo_epi16(b, weight)), 8);
+}
+
+FORCE_INLINE __m256i LerpFixed256(const __m256i a, const __m256i b, const __m256i weight, const __m256i weightInv) {
+  return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, weightInv), _mm256_mullo_epi16(b, weight)), 8);
+}
+
+// Texels are widened to 16 bits per channel, the weights repeat each pixel's fraction across its four channels and always sum to 256.
+FORCE_INLINE __m128i BilinearBlend128(const __m128i t00, const __m128i t10, const __m128i t01, const __m128i t11, const __m128i w00, const __m128i w10, const __m128i w01, const __m128i w11) {
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(t00, w00), _mm_mullo_epi16(t10, w10));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(t01, w01));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(t11, w11));
+  return _mm_srli_epi16(sum, 8);
+}
+
+FORCE_INLINE __m256i BilinearBlend256(const __m256i t00, const __m256i t10, const __m256i t01, const __m256i t11, const __m256i w00, const __m256i w10, const __m256i w01, const __m256i w11) {
+  __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(t00, w00), _mm256_mullo_epi16(t10, w10));
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(t01, w01));
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(t11, w11));
+  return _mm256_srli_epi16(sum, 8);
+}
+
+FORCE_INLINE __m128i GatherTexels128(const uint32* __restrict data, const __m128i offsets) {
+  __m128i tex0 = _mm_loadu_si32(data + _mm_extract_epi32(offsets, 0b00));
+  __m128i tex1 = _mm_loadu_si32(data + _mm_extract_epi32(offsets, 0b01));
+  __m128i tex2 = _mm_loadu_si32(data + _mm_extract_epi32(offsets, 0b10));
+  __m128i tex3 = _mm_loadu_si32(data + _mm_extract_epi32(offsets, 0b11));
+  return _mm_unpacklo_epi64(_mm_unpacklo_epi32(tex0, tex1), _mm_unpacklo_epi32(tex2, tex3));
+}
+
+// Start of row y in a tiled level, see TiledTexelOffset. Columns are then 4 texels apart.
+FORCE_INLINE __m128i TiledRowOffsets128(const __m128i y, const __m128i stride) {
+  const __m128i rowMask = _mm_set1_epi32(3);
+  return _mm_add_epi32(_mm_mullo_epi32(_mm_andnot_si128(rowMask, y), stride), _mm_and_si128(y, rowMask));
+}
+
+FORCE_INLINE __m256i TiledRowOffsets256(const __m256i y, const __m256i stride) {
+  const __m256i rowMask = _mm256_set1_epi32(3);
+  return _mm256_add_epi32(_mm256_mullo_epi32(_mm256_andnot_si256(rowMask, y), stride), _mm256_and_si256(y, rowMask));
+}
+
+/*
+  Bilinear filter 4 pixels in 8.8 fixed point, UVs are texel coordinates that are already >= 0.
+  Linear levels grab a texel and its right neighbor with one 64 bit load per row, tiled levels load all 4 texels separately.
+  The last row and column start their footprint one texel early and put the full weight on the far texel.
+  The results are left widened to 16 bits per channel, pixels 0-1 in lo and 2-3 in hi.
+*/
+template<TextureLayout layout>
+FORCE_INLINE void SampleBilinear128(const UVShaderLevel& level, __m128 uValues, __m128 vValues, __m128i& lo, __m128i& hi) {
+  const __m128 maxU = _mm_set_ps1(level.maxU);
+  const __m128 maxV = _mm_set_ps1(level.maxV);
+  const __m128i stride = _mm_set1_epi32(level.stride);
+  const __m128i fixedOne = _mm_set1_epi32(256);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i loPixels = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 4, 5, 4, 5, 4, 5, 4, 5);
+  const __m128i hiPixels = _mm_setr_epi8(8, 9, 8, 9, 8, 9, 8, 9, 12, 13, 12, 13, 12, 13, 12, 13);
+
+  __m128i uFixed = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(uValues, maxU), _mm_set_ps1(256.f)));
+  __m128i vFixed = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(vValues, maxV), _mm_set_ps1(256.f)));
+
+  __m128i x = _mm_min_epi32(_mm_srli_epi32(uFixed, 8), _mm_set1_epi32(level.xLimit));
+  __m128i y = _mm_min_epi32(_mm_srli_epi32(vFixed, 8), _mm_set1_epi32(level.yLimit));
+
+  // Deriving the other corners from the rounded down product keeps the sum at exactly 256 and every weight >= 0.
+  __m128i uWeight = _mm_sub_epi32(uFixed, _mm_slli_epi32(x, 8));
+  __m128i vWeight = _mm_sub_epi32(vFixed, _mm_slli_epi32(y, 8));
+  __m128i w11 = _mm_srli_epi32(_mm_mullo_epi32(uWeight, vWeight), 8);
+  __m128i w10 = _mm_sub_epi32(uWeight, w11);
+  __m128i w01 = _mm_sub_epi32(vWeight, w11);
+  __m128i w00 = _mm_sub_epi32(_mm_sub_epi32(fixedOne, uWeight), w01);
+
+  __m128i t00Lo;
+  __m128i t00Hi;
+  __m128i t10Lo;
+  __m128i t10Hi;
+  __m128i t01Lo;
+  __m128i t01Hi;
+  __m128i t11Lo;
+  __m128i t11Hi;
+
+  if constexpr (layout == TextureLayout::Linear) {
+    __m128i offsets = _mm_add_epi32(_mm_mullo_epi32(y, stride), x);
+
+    const uint32* __restrict t0 = level.data + _mm_extract_epi32(offsets, 0b00);
+    const uint32* __restrict t1 = level.data + _mm_extract_epi32(offsets, 0b01);
+    const uint32* __restrict t2 = level.data + _mm_extract_epi32(offsets, 0b10);
+    const uint32* __restrict t3 = level.data + _mm_extract_epi32(offsets, 0b11);
+
+    __m128i top01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)t0), _mm_loadl_epi64((const __m128i*)t1));
+    __m128i top23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)t2), _mm_loadl_epi64((const __m128i*)t3));
+    __m128i bottom01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(t0 + level.stride)), _mm_loadl_epi64((const __m128i*)(t1 + level.stride)));
+    __m128i bottom23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(t2 + level.stride)), _mm_loadl_epi64((const __m128i*)(t3 + level.stride)));
+
+    // Group the left texels ahead of the right ones so they unpack against each other.
+    top01 = _mm_shuffle_epi32(top01, _MM_SHUFFLE(3, 1, 2, 0));
+    top23 = _mm_shuffle_epi32(top23, _MM_SHUFFLE(3, 1, 2, 0));
+    bottom01 = _mm_shuffle_epi32(bottom01, _MM_SHUFFLE(3, 1, 2, 0));
+    bottom23 = _mm_shuffle_epi32(bottom23, _MM_SHUFFLE(3, 1, 2, 0));
+
+    t00Lo = _mm_unpacklo_epi8(top01, zero);
+    t10Lo = _mm_unpackhi_epi8(top01, zero);
+    t00Hi = _mm_unpacklo_epi8(top23, zero);
+    t10Hi = _mm_unpackhi_epi8(top23, zero);
+    t01Lo = _mm_unpacklo_epi8(bottom01, zero);
+    t11Lo = _mm_unpackhi_epi8(bottom01, zero);
+    t01Hi = _mm_unpacklo_epi8(bottom23, zero);
+    t11Hi = _mm_unpackhi_epi8(bottom23, zero);
+  }
+  else {
+    __m128i left = _mm_slli_epi32(x, 2);
+    __m128i right = _mm_add_epi32(left, _mm_set1_epi32(4));
+    __m128i top = TiledRowOffsets128(y, stride);
+    __m128i bottom = TiledRowOffsets128(_mm_add_epi32(y, _mm_set1_epi32(1)), stride);
+
+    __m128i t00 = GatherTexels128(level.data, _mm_add_epi32(top, left));
+    __m128i t10 = GatherTexels128(level.data, _mm_add_epi32(top, right));
+    __m128i t01 = GatherTexels128(level.data, _mm_add_epi32(bottom, left));
+    __m128i t11 = GatherTexels128(level.data, _mm_add_epi32(bottom, right));
+
+    t00Lo = _mm_unpacklo_epi8(t00, zero);
+    t00Hi = _mm_unpackhi_epi8(t00, zero);
+    t10Lo = _mm_unpacklo_epi8(t10, zero);
+    t10Hi = _mm_unpackhi_epi8(t10, zero);
+    t01Lo = _mm_unpacklo_epi8(t01, zero);
+    t01Hi = _mm_unpackhi_epi8(t01, zero);
+    t11Lo = _mm_unpacklo_epi8(t11, zero);
+    t11Hi = _mm_unpackhi_epi8(t11, zero);
+  }
+
+  lo = BilinearBlend128(t00Lo, t10Lo, t01Lo, t11Lo,
+    _mm_shuffle_epi8(w00, loPixels), _mm_shuffle_epi8(w10, loPixels),
+    _mm_shuffle_epi8(w01, loPixels), _mm_shuffle_epi8(w11, loPixels));
+  hi = BilinearBlend128(t00Hi, t10Hi, t01Hi, t11Hi,
+    _mm_shuffle_epi8(w00, hiPixels), _mm_shuffle_epi8(w10, hiPixels),
+    _mm_shuffle_epi8(w01, hiPixels), _mm_shuffle_epi8(w11, hiPixels));
+}
+
+// Repeats the fixed point weight of each of 4 pixels across its channels, pairs stay in their own 128 bit lane.
+FORCE_INLINE __m256i SpreadWeights256(const __m256i weights, const __m256i pixels) {
+  __m256i spread = _mm256_permutevar8x32_epi32(weights, pixels);
+  return _mm256_or_si256(spread, _mm256_slli_epi32(spread, 16));
+}
+
+/*
+  Same as the 128 bit version for 8 pixels. Gathers are masked so only covered pixels touch memory.
+  Linear levels gather texel pairs, pixels 0-3 end up in lo and 4-7 in hi with each 128 bit lane holding two pixels.
+  Tiled levels gather single texels, unpacking them leaves pixels 0-1 and 4-5 in lo, 2-3 and 6-7 in hi.
+  Either way packing lo with hi and running it through FinishBilinear256 gives the pixels back in order.
+*/
+template<TextureLayout layout>
+FORCE_INLINE void SampleBilinear256(const UVShaderLevel& level, __m256 uValues, __m256 vValues, const __m256i mask, __m256i& lo, __m256i& hi) {
+  const __m256 maxU = _mm256_set1_ps(level.maxU);
+  const __m256 maxV = _mm256_set1_ps(level.maxV);
+  const __m256i stride = _mm256_set1_epi32(level.stride);
+  const __m256i fixedOne = _mm256_set1_epi32(256);
+  const __m256i zero = _mm256_setzero_si256();
+
+  __m256i uFixed = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_min_ps(uValues, maxU), _mm256_set1_ps(256.f)));
+  __m256i vFixed = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_min_ps(vValues, maxV), _mm256_set1_ps(256.f)));
+
+  __m256i x = _mm256_min_epi32(_mm256_srli_epi32(uFixed, 8), _mm256_set1_epi32(level.xLimit));
+  __m256i y = _mm256_min_epi32(_mm256_srli_epi32(vFixed, 8), _mm256_set1_epi32(level.yLimit));
+
+  __m256i uWeight = _mm256_sub_epi32(uFixed, _mm256_slli_epi32(x, 8));
+  __m256i vWeight = _mm256_sub_epi32(vFixed, _mm256_slli_epi32(y, 8));
+  __m256i w11 = _mm256_srli_epi32(_mm256_mullo_epi32(uWeight, vWeight), 8);
+  __m256i w10 = _mm256_sub_epi32(uWeight, w11);
+  __m256i w01 = _mm256_sub_epi32(vWeight, w11);
+  __m256i w00 = _mm256_sub_epi32(_mm256_sub_epi32(fixedOne, uWeight), w01);
+
+  if constexpr (layout == TextureLayout::Linear) {
+    const __m256i loPixels = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i hiPixels = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    __m256i topOffsets = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+    __m256i bottomOffsets = _mm256_add_epi32(topOffsets, stride);
+
+    const long long* __restrict data = (const long long*)level.data;
+    __m256i loMask = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask));
+    __m256i hiMask = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask, 1));
+
+    __m256i loTop = _mm256_mask_i32gather_epi64(zero, data, _mm256_castsi256_si128(topOffsets), loMask, 4);
+    __m256i hiTop = _mm256_mask_i32gather_epi64(zero, data, _mm256_extracti128_si256(topOffsets, 1), hiMask, 4);
+    __m256i loBottom = _mm256_mask_i32gather_epi64(zero, data, _mm256_castsi256_si128(bottomOffsets), loMask, 4);
+    __m256i hiBottom = _mm256_mask_i32gather_epi64(zero, data, _mm256_extracti128_si256(bottomOffsets, 1), hiMask, 4);
+
+    loTop = _mm256_shuffle_epi32(loTop, _MM_SHUFFLE(3, 1, 2, 0));
+    hiTop = _mm256_shuffle_epi32(hiTop, _MM_SHUFFLE(3, 1, 2, 0));
+    loBottom = _mm256_shuffle_epi32(loBottom, _MM_SHUFFLE(3, 1, 2, 0));
+    hiBottom = _mm256_shuffle_epi32(hiBottom, _MM_SHUFFLE(3, 1, 2, 0));
+
+    lo = BilinearBlend256(_mm256_unpacklo_epi8(loTop, zero), _mm256_unpackhi_epi8(loTop, zero),
+      _mm256_unpacklo_epi8(loBottom, zero), _mm256_unpackhi_epi8(loBottom, zero),
+      SpreadWeights256(w00, loPixels), SpreadWeights256(w10, loPixels),
+      SpreadWeights256(w01, loPixels), SpreadWeights256(w11, loPixels));
+    hi = BilinearBlend256(_mm256_unpacklo_epi8(hiTop, zero), _mm256_unpackhi_epi8(hiTop, zero),
+      _mm256_unpacklo_epi8(hiBottom, zero), _mm256_unpackhi_epi8(hiBottom, zero),
+      SpreadWeights256(w00, hiPixels), SpreadWeights256(w10, hiPixels),
+      SpreadWeights256(w01, hiPixels), SpreadWeights256(w11, hiPixels));
+  }
+  else {
+    const __m256i loPixels = _mm256_setr_epi32(0, 0, 1, 1, 4, 4, 5, 5);
+    const __m256i hiPixels = _mm256_setr_epi32(2, 2, 3, 3, 6, 6, 7, 7);
+
+    __m256i left = _mm256_slli_epi32(x, 2);
+    __m256i right = _mm256_add_epi32(left, _mm256_set1_epi32(4));
+    __m256i top = TiledRowOffsets256(y, stride);
+    __m256i bottom = TiledRowOffsets256(_mm256_add_epi32(y, _mm256_set1_epi32(1)), stride);
+
+    const int* __restrict data = (const int*)level.data;
+    __m256i t00 = _mm256_mask_i32gather_epi32(zero, data, _mm256_add_epi32(top, left), mask, 4);
+    __m256i t10 = _mm256_mask_i32gather_epi32(zero, data, _mm256_add_epi32(top, right), mask, 4);
+    __m256i t01 = _mm256_mask_i32gather_epi32(zero, data, _mm256_add_epi32(bottom, left), mask, 4);
+    __m256i t11 = _mm256_mask_i32gather_epi32(zero, data, _mm256_add_epi32(bottom, right), mask, 4);
+
+    lo = BilinearBlend256(_mm256_unpacklo_epi8(t00, zero), _mm256_unpacklo_epi8(t10, zero),
+      _mm256_unpacklo_epi8(t01, zero), _mm256_unpacklo_epi8(t11, zero),
+      SpreadWeights256(w00, loPixels), SpreadWeights256(w10, loPixels),
+      SpreadWeights256(w01, loPixels), SpreadWeights256(w11, loPixels));
+    hi = BilinearBlend256(_mm256_unpackhi_epi8(t00, zero), _mm256_unpackhi_epi8(t10, zero),
+      _mm256_unpackhi_epi8(t01, zero), _mm256_unpackhi_epi8(t11, zero),
+      SpreadWeights256(w00, hiPixels), SpreadWeights256(w10, hiPixels),
+      SpreadWeights256(w01, hiPixels), SpreadWeights256(w11, hiPixels));
+  }
+}
+
+template<TextureLayout layout>
+FORCE_INLINE __m256i FinishBilinear256(const __m256i lo, const __m256i hi) {
+  __m256i packed = _mm256_packus_epi16(lo, hi);
+
+  // Packing interleaves the two halves a pixel pair at a time, put the pairs back in order.
+  if constexpr (layout == TextureLayout::Linear) {
+    packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+  }
+
+  return packed;
+}
+
+void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const int32 tileBounds[4]) {
   const int32 sMaxWidth = (int32)maxWidth;
+  const int32 hiZWidth = (sMaxWidth + HiZBlockSize - 1) >> HiZBlockShift;
+  const __m128 tileMin = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[1], tileBounds[0]));
+  const __m128 tileMax = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[3], tileBounds[2]));
 
   __m128 initMultiplier = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
   __m128 stepMultiplier = _mm_set_ps1(4.f);
@@ -1897,8 +2979,9 @@ void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __r
     fmins = _mm_round_ps(fmins, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     fmaxs = _mm_round_ps(fmaxs, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
 
-    __m128 fminX = _mm_shuffle_ps(fmins, fmins, 0b00000000);
-    __m128 fminY = _mm_shuffle_ps(fmins, fmins, 0b01010101);
+    // Scissor the bounding box to the tile we own.
+    fmins = _mm_max_ps(fmins, tileMin);
+    fmaxs = _mm_min_ps(fmaxs, tileMax);
 
     __m128i imins = _mm_cvtps_epi32(fmins);
     __m128i imaxs = _mm_cvtps_epi32(fmaxs);
@@ -1912,6 +2995,26 @@ void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __r
     int32 maxX = (int32)maxXY;
     int32 maxY = maxXY >> 32;
 
+    if ((minX >= maxX) || (minY >= maxY)) {
+      continue;
+    }
+
+    const float* __restrict p1 = vertices + indices[i];
+    const float* __restrict p2 = vertices + indices[i + 1];
+    const float* __restrict p3 = vertices + indices[i + 2];
+
+    // Skip the whole triangle if it's behind what has already been drawn everywhere it could land.
+    const float nearestDepth = HiZNearestDepth(p1, p2, p3);
+    if (HiZTriangleOccluded(hiZ, hiZWidth, minX, minY, maxX, maxY, nearestDepth)) {
+      continue;
+    }
+
+    // Start each row on a vector boundary. Tiles are a multiple of the vector width so a row never spills into a neighboring tile.
+    minX &= ~3;
+
+    __m128 fminX = _mm_set_ps1((float)minX);
+    __m128 fminY = _mm_set_ps1((float)minY);
+
     __m128 x1x0 = _mm_sub_ps(x1, x0);
     __m128 x2x1 = _mm_sub_ps(x2, x1);
     __m128 x0x2 = _mm_sub_ps(x0, x2);
@@ -2003,7 +3106,7 @@ void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __r
         __m128 combinedWeights = _mm_or_ps(_mm_or_ps(weights0, weights1), weights2);
 
         // If all mask bits are set then none of these pixels are inside the triangle.
-        if (!_mm_testc_si128(_mm_castps_si128(combinedWeights), weightMask)) {
+        if (!_mm_testc_si128(_mm_castps_si128(combinedWeights), weightMask) && (hiZ[((h >> HiZBlockShift) * hiZWidth) + (w >> HiZBlockShift)] <= nearestDepth)) {
           // Our 4-wide alignment doesn't match at the moment. Possibly revisit in the future.
           __m128i pixelVec = _mm_loadu_si128((__m128i* __restrict)pixels);
           __m128 depthVec = _mm_loadu_ps(pixelDepth);
@@ -2058,11 +3161,16 @@ void Unaligned_Shader_RGB_SSE(const float* __restrict vertices, const int32* __r
       weightInit1 = _mm_sub_ps(weightInit1, yStep1);
       weightInit2 = _mm_sub_ps(weightInit2, yStep2);
     }
+
+    HiZUpdateCovered(hiZ, hiZWidth, minX, minY, maxX, maxY, p1, p2, p3);
   }
 }
 
-void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer) {
+void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const int32 tileBounds[4]) {
   const int32 sMaxWidth = (int32)maxWidth;
+  const int32 hiZWidth = (sMaxWidth + HiZBlockSize - 1) >> HiZBlockShift;
+  const __m128 tileMin = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[1], tileBounds[0]));
+  const __m128 tileMax = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[3], tileBounds[2]));
 
   __m256 rgbScale = _mm256_set1_ps(255.f);
   __m256 initMultiplier = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
@@ -2097,8 +3205,9 @@ void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __r
     fmins = _mm_round_ps(fmins, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     fmaxs = _mm_round_ps(fmaxs, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
 
-    __m256 fminX = _mm256_broadcastss_ps(fmins);
-    __m256 fminY = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(fmins), yShuffle);
+    // Scissor the bounding box to the tile we own.
+    fmins = _mm_max_ps(fmins, tileMin);
+    fmaxs = _mm_min_ps(fmaxs, tileMax);
 
     __m128i imins = _mm_cvtps_epi32(fmins);
     __m128i imaxs = _mm_cvtps_epi32(fmaxs);
@@ -2112,6 +3221,26 @@ void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __r
     int32 maxX = (int32)maxXY;
     int32 maxY = maxXY >> 32;
 
+    if ((minX >= maxX) || (minY >= maxY)) {
+      continue;
+    }
+
+    const float* __restrict p1 = vertices + indices[i];
+    const float* __restrict p2 = vertices + indices[i + 1];
+    const float* __restrict p3 = vertices + indices[i + 2];
+
+    // Skip the whole triangle if it's behind what has already been drawn everywhere it could land.
+    const float nearestDepth = HiZNearestDepth(p1, p2, p3);
+    if (HiZTriangleOccluded(hiZ, hiZWidth, minX, minY, maxX, maxY, nearestDepth)) {
+      continue;
+    }
+
+    // Start each row on a vector boundary. Tiles are a multiple of the vector width so a row never spills into a neighboring tile.
+    minX &= ~7;
+
+    __m256 fminX = _mm256_set1_ps((float)minX);
+    __m256 fminY = _mm256_set1_ps((float)minY);
+
     __m256 x1x0 = _mm256_sub_ps(x1, x0);
     __m256 x2x1 = _mm256_sub_ps(x2, x1);
     __m256 x0x2 = _mm256_sub_ps(x0, x2);
@@ -2192,14 +3321,15 @@ void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __r
     __m256 weights1 = weightInit1;
     __m256 weights2 = weightInit2;
 
-    const int32 simdEnd = minX + (((maxX - minX) >> 3) << 3);
+    // The last vector of each row starts at simdEnd, it must not start at or beyond maxX.
+    const int32 simdEnd = minX + (((maxX - minX - 1) >> 3) << 3);
     const int32 stepDelta = sMaxWidth - simdEnd + minX;
     for (int32 h = minY, w = minX; h < maxY;) {
       // OR all weights
       __m256 combinedWeights = _mm256_or_ps(_mm256_or_ps(weights0, weights1), weights2);
 
       // If all mask bits are set then none of these pixels are inside the triangle.
-      if (!_mm256_testc_ps(combinedWeights, signMask)) {
+      if (!_mm256_testc_ps(combinedWeights, signMask) && (hiZ[((h >> HiZBlockShift) * hiZWidth) + (w >> HiZBlockShift)] <= nearestDepth)) {
         __m256 depthVec = _mm256_loadu_ps(pixelDepth);
 
         __m256 zValues = _mm256_rcp_ps(_mm256_fmadd_ps(weights2, z2z0, _mm256_fmadd_ps(weights1, z1z0, z0)));
@@ -2243,19 +3373,36 @@ void Unaligned_Shader_RGB_AVX(const float* __restrict vertices, const int32* __r
         weights2 = _mm256_sub_ps(weights2, xStep2);
       }
     }
+
+    HiZUpdateCovered(hiZ, hiZWidth, minX, minY, maxX, maxY, p1, p2, p3);
   }
 }
 
-void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, const Texture* __restrict texture, size_t mipLevel) {
+template<TextureFilter filter, TextureLayout layout>
+static void Shader_UV_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
   const int32 sMaxWidth = (int32)maxWidth;
+  const int32 hiZWidth = (sMaxWidth + HiZBlockSize - 1) >> HiZBlockShift;
+  const __m128 tileMin = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[1], tileBounds[0]));
+  const __m128 tileMax = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[3], tileBounds[2]));
   // We want the UV values to be scaled by the width/height.
   // Doing that here saves us from having to do that at each pixel.
   // We must still multiply the stride and channels separately because of rounding error.
-  size_t texHeight = texture->Height(mipLevel);
-  uint32* __restrict textureData = (uint32 * __restrict)texture->Data(mipLevel);
-
-  __m128 yStride = _mm_set_ps1((float)(texHeight));
-  __m128 maxUVValue = _mm_set_ps1((float)(texHeight - 1));
+  // A fixed level is clamped to the chain, otherwise every triangle picks its own below.
+  const size_t lastMip = LastFilterableMip(texture, filter);
+  const bool autoMip = mipLevel == AutoMipLevel;
+  const float baseTexels = (float)(texture->Width(0) * texture->Height(0));
+  size_t triangleMip = autoMip ? 0 : ((mipLevel < lastMip) ? mipLevel : lastMip);
+
+  UVShaderLevel level = GetUVShaderLevel(texture, triangleMip);
+  UVShaderLevel nextLevel = GetUVShaderLevel(texture, (triangleMip < lastMip) ? (triangleMip + 1) : lastMip);
+  int32 levelBlend = 0;
+
+  __m128 maxUValue = _mm_set_ps1(level.maxU);
+  __m128 maxVValue = _mm_set_ps1(level.maxV);
+  __m128 nextUScale = _mm_set_ps1(NextLevelScale(nextLevel.maxU, level.maxU));
+  __m128 nextVScale = _mm_set_ps1(NextLevelScale(nextLevel.maxV, level.maxV));
+  __m128i levelWeight = _mm_setzero_si128();
+  __m128i levelWeightInv = _mm_set1_epi16(256);
 
   __m128 initMultiplier = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
   __m128 stepMultiplier = _mm_set_ps1(4.f);
@@ -2287,8 +3434,9 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
     fmins = _mm_round_ps(fmins, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     fmaxs = _mm_round_ps(fmaxs, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
 
-    __m128 fminX = _mm_shuffle_ps(fmins, fmins, 0b00000000);
-    __m128 fminY = _mm_shuffle_ps(fmins, fmins, 0b01010101);
+    // Scissor the bounding box to the tile we own.
+    fmins = _mm_max_ps(fmins, tileMin);
+    fmaxs = _mm_min_ps(fmaxs, tileMax);
 
     __m128i imins = _mm_cvtps_epi32(fmins);
     __m128i imaxs = _mm_cvtps_epi32(fmaxs);
@@ -2302,6 +3450,47 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
     int32 maxX = (int32)maxXY;
     int32 maxY = maxXY >> 32;
 
+    if ((minX >= maxX) || (minY >= maxY)) {
+      continue;
+    }
+
+    const float* __restrict p1 = vertices + indices[i];
+    const float* __restrict p2 = vertices + indices[i + 1];
+    const float* __restrict p3 = vertices + indices[i + 2];
+
+    // Skip the whole triangle if it's behind what has already been drawn everywhere it could land.
+    const float nearestDepth = HiZNearestDepth(p1, p2, p3);
+    if (HiZTriangleOccluded(hiZ, hiZWidth, minX, minY, maxX, maxY, nearestDepth)) {
+      continue;
+    }
+
+    if (autoMip) {
+      const size_t nextMip = SelectTriangleMip(filter, TriangleMipLod(p1, p2, p3, baseTexels), lastMip, levelBlend);
+      if (nextMip != triangleMip) {
+        triangleMip = nextMip;
+        level = GetUVShaderLevel(texture, triangleMip);
+        maxUValue = _mm_set_ps1(level.maxU);
+        maxVValue = _mm_set_ps1(level.maxV);
+
+        if constexpr (filter == TextureFilter::Trilinear) {
+          nextLevel = GetUVShaderLevel(texture, (triangleMip < lastMip) ? (triangleMip + 1) : lastMip);
+          nextUScale = _mm_set_ps1(NextLevelScale(nextLevel.maxU, level.maxU));
+          nextVScale = _mm_set_ps1(NextLevelScale(nextLevel.maxV, level.maxV));
+        }
+      }
+
+      if constexpr (filter == TextureFilter::Trilinear) {
+        levelWeight = _mm_set1_epi16((int16)levelBlend);
+        levelWeightInv = _mm_set1_epi16((int16)(256 - levelBlend));
+      }
+    }
+
+    // Start each row on a vector boundary. Tiles are a multiple of the vector width so a row never spills into a neighboring tile.
+    minX &= ~3;
+
+    __m128 fminX = _mm_set_ps1((float)minX);
+    __m128 fminY = _mm_set_ps1((float)minY);
+
     __m128 x1x0 = _mm_sub_ps(x1, x0);
     __m128 x2x1 = _mm_sub_ps(x2, x1);
     __m128 x0x2 = _mm_sub_ps(x0, x2);
@@ -2318,21 +3507,22 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
     __m128 z1z0 = _mm_sub_ps(invVert1, invVert0);
     __m128 z2z0 = _mm_sub_ps(invVert2, invVert0);
 
-    __m128 uvScaleFactor = _mm_mul_ps(invArea, maxUVValue);
+    __m128 uScaleFactor = _mm_mul_ps(invArea, maxUValue);
+    __m128 vScaleFactor = _mm_mul_ps(invArea, maxVValue);
 
     __m128 u0 = _mm_shuffle_ps(v1Attrs, v1Attrs, 0b00000000);
-    __m128 invAttr00 = _mm_mul_ps(u0, uvScaleFactor);
-    __m128 invAttr01 = _mm_mul_ps(_mm_shuffle_ps(v2Attrs, v2Attrs, 0b00000000), uvScaleFactor);
-    __m128 invAttr02 = _mm_mul_ps(_mm_shuffle_ps(v3Attrs, v3Attrs, 0b00000000), uvScaleFactor);
-    u0 = _mm_mul_ps(u0, maxUVValue);
+    __m128 invAttr00 = _mm_mul_ps(u0, uScaleFactor);
+    __m128 invAttr01 = _mm_mul_ps(_mm_shuffle_ps(v2Attrs, v2Attrs, 0b00000000), uScaleFactor);
+    __m128 invAttr02 = _mm_mul_ps(_mm_shuffle_ps(v3Attrs, v3Attrs, 0b00000000), uScaleFactor);
+    u0 = _mm_mul_ps(u0, maxUValue);
     __m128 u1u0 = _mm_sub_ps(invAttr01, invAttr00);
     __m128 u2u0 = _mm_sub_ps(invAttr02, invAttr00);
 
     __m128 v0 = _mm_shuffle_ps(v1Attrs, v1Attrs, 0b01010101);
-    __m128 invAttr10 = _mm_mul_ps(v0, uvScaleFactor);
-    __m128 invAttr11 = _mm_mul_ps(_mm_shuffle_ps(v2Attrs, v2Attrs, 0b01010101), uvScaleFactor);
-    __m128 invAttr12 = _mm_mul_ps(_mm_shuffle_ps(v3Attrs, v3Attrs, 0b01010101), uvScaleFactor);
-    v0 = _mm_mul_ps(v0, maxUVValue);
+    __m128 invAttr10 = _mm_mul_ps(v0, vScaleFactor);
+    __m128 invAttr11 = _mm_mul_ps(_mm_shuffle_ps(v2Attrs, v2Attrs, 0b01010101), vScaleFactor);
+    __m128 invAttr12 = _mm_mul_ps(_mm_shuffle_ps(v3Attrs, v3Attrs, 0b01010101), vScaleFactor);
+    v0 = _mm_mul_ps(v0, maxVValue);
     __m128 v1v0 = _mm_sub_ps(invAttr11, invAttr10);
     __m128 v2v0 = _mm_sub_ps(invAttr12, invAttr10);
 
@@ -2376,7 +3566,7 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
         __m128 combinedWeights = _mm_or_ps(_mm_or_ps(weights0, weights1), weights2);
 
         // If all mask bits are set then none of these pixels are inside the triangle.
-        if (!_mm_testc_si128(_mm_castps_si128(combinedWeights), weightMask)) {
+        if (!_mm_testc_si128(_mm_castps_si128(combinedWeights), weightMask) && (hiZ[((h >> HiZBlockShift) * hiZWidth) + (w >> HiZBlockShift)] <= nearestDepth)) {
           // Our 4-wide alignment doesn't match at the moment. Possibly revisit in the future.
           __m128i pixelVec = _mm_loadu_si128((__m128i * __restrict)pixels);
           __m128 depthVec = _mm_loadu_ps(pixelDepth);
@@ -2403,25 +3593,46 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
           __m128 vValues = _mm_add_ps(_mm_add_ps(weightedAttr10, weightedAttr11), weightedAttr12);
 
           // Clamp UV so that we don't index outside of the texture.
-          uValues = _mm_min_ps(uValues, maxUVValue);
+          uValues = _mm_min_ps(uValues, maxUValue);
           uValues = _mm_max_ps(uValues, _mm_setzero_ps());
-          vValues = _mm_min_ps(vValues, maxUVValue);
+          vValues = _mm_min_ps(vValues, maxVValue);
           vValues = _mm_max_ps(vValues, _mm_setzero_ps());
 
-          // We must round prior to multiplying the stride and channels.
-          // If this isn't done, we may jump to a completely different set of pixels because of rounding.
-          vValues = _mm_floor_ps(vValues);
-
-          vValues = _mm_add_ps(_mm_mul_ps(vValues, yStride), uValues);
-
-          __m128i colorValues = _mm_cvtps_epi32(vValues);
-
-          __m128i tex3 = _mm_loadu_si32(textureData + _mm_extract_epi32(colorValues, 0b11));
-          __m128i tex2 = _mm_loadu_si32(textureData + _mm_extract_epi32(colorValues, 0b10));
-          __m128i tex1 = _mm_loadu_si32(textureData + _mm_extract_epi32(colorValues, 0b01));
-          __m128i tex0 = _mm_loadu_si32(textureData + _mm_extract_epi32(colorValues, 0b00));
-
-          __m128i loadedColors = _mm_unpacklo_epi64(_mm_unpacklo_epi32(tex0, tex1), _mm_unpacklo_epi32(tex2, tex3));
+          __m128i loadedColors;
+          if constexpr (filter == TextureFilter::Point) {
+            // U rounds to the nearest texel and V rounds down.
+            // The offset is built from integers, a float loses the column once the row offset passes 24 bits on large textures.
+            __m128i x = _mm_cvtps_epi32(uValues);
+            __m128i y = _mm_cvttps_epi32(vValues);
+            __m128i stride = _mm_set1_epi32(level.stride);
+
+            __m128i colorValues;
+            if constexpr (layout == TextureLayout::Linear) {
+              colorValues = _mm_add_epi32(_mm_mullo_epi32(y, stride), x);
+            }
+            else {
+              colorValues = _mm_add_epi32(TiledRowOffsets128(y, stride), _mm_slli_epi32(x, 2));
+            }
+
+            loadedColors = GatherTexels128(level.data, colorValues);
+          }
+          else {
+            __m128i colorsLo;
+            __m128i colorsHi;
+            SampleBilinear128<layout>(level, uValues, vValues, colorsLo, colorsHi);
+
+            if constexpr (filter == TextureFilter::Trilinear) {
+              if (levelBlend != 0) {
+                __m128i nextColorsLo;
+                __m128i nextColorsHi;
+                SampleBilinear128<layout>(nextLevel, _mm_mul_ps(uValues, nextUScale), _mm_mul_ps(vValues, nextVScale), nextColorsLo, nextColorsHi);
+                colorsLo = LerpFixed128(colorsLo, nextColorsLo, levelWeight, levelWeightInv);
+                colorsHi = LerpFixed128(colorsHi, nextColorsHi, levelWeight, levelWeightInv);
+              }
+            }
+
+            loadedColors = _mm_packus_epi16(colorsLo, colorsHi);
+          }
 
           __m128i writebackColor = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(loadedColors), _mm_castsi128_ps(pixelVec), _mm_castsi128_ps(finalCombinedMask)));
           __m128 writebackDepth = _mm_blendv_ps(zValues, depthVec, _mm_castsi128_ps(finalCombinedMask));
@@ -2439,19 +3650,63 @@ void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __re
       weightInit1 = _mm_sub_ps(weightInit1, yStep1);
       weightInit2 = _mm_sub_ps(weightInit2, yStep2);
     }
+
+    HiZUpdateCovered(hiZ, hiZWidth, minX, minY, maxX, maxY, p1, p2, p3);
   }
 }
 
-void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, const Texture* __restrict texture, size_t mipLevel) {
+// Picks the instance matching the texture layout so addressing is resolved outside of the raster loop.
+// Textures too small for a 2x2 footprint can only be point sampled.
+template<TextureFilter filter>
+static void Dispatch_UV_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  if ((filter != TextureFilter::Point) && ((texture->Width(0) < 2) || (texture->Height(0) < 2))) {
+    Dispatch_UV_SSE<TextureFilter::Point>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
+  else if (texture->Layout() == TextureLayout::Tiled) {
+    Shader_UV_SSE<filter, TextureLayout::Tiled>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
+  else {
+    Shader_UV_SSE<filter, TextureLayout::Linear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
+}
+
+void Unaligned_Shader_UV_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_SSE<TextureFilter::Point>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+void Unaligned_Shader_UV_Bilinear_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_SSE<TextureFilter::Bilinear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+void Unaligned_Shader_UV_Trilinear_SSE(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_SSE<TextureFilter::Trilinear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+template<TextureFilter filter, TextureLayout layout>
+static void Shader_UV_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
   const int32 sMaxWidth = (int32)maxWidth;
+  const int32 hiZWidth = (sMaxWidth + HiZBlockSize - 1) >> HiZBlockShift;
+  const __m128 tileMin = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[1], tileBounds[0]));
+  const __m128 tileMax = _mm_cvtepi32_ps(_mm_set_epi32(0, 0, tileBounds[3], tileBounds[2]));
   // We want the UV values to be scaled by the width/height.
   // Doing that here saves us from having to do that at each pixel.
   // We must still multiply the stride and channels separately because of rounding error.
-  size_t texHeight = texture->Height(mipLevel);
-  uint32* __restrict textureData = (uint32 * __restrict)texture->Data(mipLevel);
-
-  __m256 yStride = _mm256_set1_ps((float)(texHeight));
-  __m256 maxUVValue = _mm256_set1_ps((float)(texHeight - 1));
+  // A fixed level is clamped to the chain, otherwise every triangle picks its own below.
+  const size_t lastMip = LastFilterableMip(texture, filter);
+  const bool autoMip = mipLevel == AutoMipLevel;
+  const float baseTexels = (float)(texture->Width(0) * texture->Height(0));
+  size_t triangleMip = autoMip ? 0 : ((mipLevel < lastMip) ? mipLevel : lastMip);
+
+  UVShaderLevel level = GetUVShaderLevel(texture, triangleMip);
+  UVShaderLevel nextLevel = GetUVShaderLevel(texture, (triangleMip < lastMip) ? (triangleMip + 1) : lastMip);
+  int32 levelBlend = 0;
+
+  __m256 maxUValue = _mm256_set1_ps(level.maxU);
+  __m256 maxVValue = _mm256_set1_ps(level.maxV);
+  __m256 nextUScale = _mm256_set1_ps(NextLevelScale(nextLevel.maxU, level.maxU));
+  __m256 nextVScale = _mm256_set1_ps(NextLevelScale(nextLevel.maxV, level.maxV));
+  __m256i levelWeight = _mm256_setzero_si256();
+  __m256i levelWeightInv = _mm256_set1_epi16(256);
 
   __m256 initMultiplier = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
   __m256 stepMultiplier = _mm256_set1_ps(8.f);
@@ -2481,8 +3736,9 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
     fmins = _mm_round_ps(fmins, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     fmaxs = _mm_round_ps(fmaxs, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
 
-    __m256 fminX = _mm256_broadcastss_ps(fmins);
-    __m256 fminY = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(fmins), yShuffle);
+    // Scissor the bounding box to the tile we own.
+    fmins = _mm_max_ps(fmins, tileMin);
+    fmaxs = _mm_min_ps(fmaxs, tileMax);
 
     __m128i imins = _mm_cvtps_epi32(fmins);
     __m128i imaxs = _mm_cvtps_epi32(fmaxs);
@@ -2496,6 +3752,47 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
     int32 maxX = (int32)maxXY;
     int32 maxY = maxXY >> 32;
 
+    if ((minX >= maxX) || (minY >= maxY)) {
+      continue;
+    }
+
+    const float* __restrict p1 = vertices + indices[i];
+    const float* __restrict p2 = vertices + indices[i + 1];
+    const float* __restrict p3 = vertices + indices[i + 2];
+
+    // Skip the whole triangle if it's behind what has already been drawn everywhere it could land.
+    const float nearestDepth = HiZNearestDepth(p1, p2, p3);
+    if (HiZTriangleOccluded(hiZ, hiZWidth, minX, minY, maxX, maxY, nearestDepth)) {
+      continue;
+    }
+
+    if (autoMip) {
+      const size_t nextMip = SelectTriangleMip(filter, TriangleMipLod(p1, p2, p3, baseTexels), lastMip, levelBlend);
+      if (nextMip != triangleMip) {
+        triangleMip = nextMip;
+        level = GetUVShaderLevel(texture, triangleMip);
+        maxUValue = _mm256_set1_ps(level.maxU);
+        maxVValue = _mm256_set1_ps(level.maxV);
+
+        if constexpr (filter == TextureFilter::Trilinear) {
+          nextLevel = GetUVShaderLevel(texture, (triangleMip < lastMip) ? (triangleMip + 1) : lastMip);
+          nextUScale = _mm256_set1_ps(NextLevelScale(nextLevel.maxU, level.maxU));
+          nextVScale = _mm256_set1_ps(NextLevelScale(nextLevel.maxV, level.maxV));
+        }
+      }
+
+      if constexpr (filter == TextureFilter::Trilinear) {
+        levelWeight = _mm256_set1_epi16((int16)levelBlend);
+        levelWeightInv = _mm256_set1_epi16((int16)(256 - levelBlend));
+      }
+    }
+
+    // Start each row on a vector boundary. Tiles are a multiple of the vector width so a row never spills into a neighboring tile.
+    minX &= ~7;
+
+    __m256 fminX = _mm256_set1_ps((float)minX);
+    __m256 fminY = _mm256_set1_ps((float)minY);
+
     __m256 x1x0 = _mm256_sub_ps(x1, x0);
     __m256 x2x1 = _mm256_sub_ps(x2, x1);
     __m256 x0x2 = _mm256_sub_ps(x0, x2);
@@ -2512,21 +3809,22 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
     __m256 z1z0 = _mm256_sub_ps(invVert1, invVert0);
     __m256 z2z0 = _mm256_sub_ps(invVert2, invVert0);
 
-    __m256 uvScaleFactor = _mm256_mul_ps(invArea, maxUVValue);
+    __m256 uScaleFactor = _mm256_mul_ps(invArea, maxUValue);
+    __m256 vScaleFactor = _mm256_mul_ps(invArea, maxVValue);
 
     __m256 u0 = _mm256_permutevar8x32_ps(v1All, uShuffle);
-    __m256 invAttr00 = _mm256_mul_ps(u0, uvScaleFactor);
-    __m256 invAttr01 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v2All, uShuffle), uvScaleFactor);
-    __m256 invAttr02 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v3All, uShuffle), uvScaleFactor);
-    u0 = _mm256_mul_ps(u0, maxUVValue);
+    __m256 invAttr00 = _mm256_mul_ps(u0, uScaleFactor);
+    __m256 invAttr01 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v2All, uShuffle), uScaleFactor);
+    __m256 invAttr02 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v3All, uShuffle), uScaleFactor);
+    u0 = _mm256_mul_ps(u0, maxUValue);
     __m256 u1u0 = _mm256_sub_ps(invAttr01, invAttr00);
     __m256 u2u0 = _mm256_sub_ps(invAttr02, invAttr00);
 
     __m256 v0 = _mm256_permutevar8x32_ps(v1All, vShuffle);
-    __m256 invAttr10 = _mm256_mul_ps(v0, uvScaleFactor);
-    __m256 invAttr11 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v2All, vShuffle), uvScaleFactor);
-    __m256 invAttr12 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v3All, vShuffle), uvScaleFactor);
-    v0 = _mm256_mul_ps(v0, maxUVValue);
+    __m256 invAttr10 = _mm256_mul_ps(v0, vScaleFactor);
+    __m256 invAttr11 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v2All, vShuffle), vScaleFactor);
+    __m256 invAttr12 = _mm256_mul_ps(_mm256_permutevar8x32_ps(v3All, vShuffle), vScaleFactor);
+    v0 = _mm256_mul_ps(v0, maxVValue);
     __m256 v1v0 = _mm256_sub_ps(invAttr11, invAttr10);
     __m256 v2v0 = _mm256_sub_ps(invAttr12, invAttr10);
 
@@ -2564,14 +3862,15 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
     __m256 weights1 = weightInit1;
     __m256 weights2 = weightInit2;
 
-    const int32 simdEnd = minX + (((maxX - minX) >> 3) << 3);
+    // The last vector of each row starts at simdEnd, it must not start at or beyond maxX.
+    const int32 simdEnd = minX + (((maxX - minX - 1) >> 3) << 3);
     const int32 stepDelta = sMaxWidth - simdEnd + minX;
     for (int32 h = minY, w = minX; h < maxY;) {
       // OR all weights
       __m256 combinedWeights = _mm256_or_ps(_mm256_or_ps(weights0, weights1), weights2);
 
       // If all mask bits are set then none of these pixels are inside the triangle.
-      if (!_mm256_testc_ps(combinedWeights, signMask)) {
+      if (!_mm256_testc_ps(combinedWeights, signMask) && (hiZ[((h >> HiZBlockShift) * hiZWidth) + (w >> HiZBlockShift)] <= nearestDepth)) {
         __m256 depthVec = _mm256_loadu_ps(pixelDepth);
 
         __m256 zValues = _mm256_rcp_ps(_mm256_fmadd_ps(weights2, z2z0, _mm256_fmadd_ps(weights1, z1z0, z0)));
@@ -2584,14 +3883,8 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
         __m256 uValues = _mm256_fmadd_ps(_mm256_mul_ps(weights2, u2u0), zValues, _mm256_fmadd_ps(u0, zValues, _mm256_mul_ps(_mm256_mul_ps(weights1, u1u0), zValues)));
         __m256 vValues = _mm256_fmadd_ps(_mm256_mul_ps(weights2, v2v0), zValues, _mm256_fmadd_ps(v0, zValues, _mm256_mul_ps(_mm256_mul_ps(weights1, v1v0), zValues)));
 
-        // We must round prior to multiplying the stride and channels.
-        // If this isn't done, we may jump to a completely different set of pixels because of rounding.
-        vValues = _mm256_floor_ps(vValues);
-
-        uValues = _mm256_max_ps(_mm256_min_ps(uValues, maxUVValue), _mm256_setzero_ps());
-        vValues = _mm256_max_ps(_mm256_min_ps(vValues, maxUVValue), _mm256_setzero_ps());
-
-        __m256i colorValues = _mm256_cvtps_epi32(_mm256_fmadd_ps(vValues, yStride, uValues));
+        uValues = _mm256_max_ps(_mm256_min_ps(uValues, maxUValue), _mm256_setzero_ps());
+        vValues = _mm256_max_ps(_mm256_min_ps(vValues, maxVValue), _mm256_setzero_ps());
 
         // Note: we're assuming texture data is stored in ARGB format.
         // If it isn't, we need to shuffle and handle alpha here as well.
@@ -2600,7 +3893,40 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
         // NOTE: Gathers are faster in the general case except on some early HW that didn't optimize for it!
         //  If we plan on optimizing for all cases, we will need to take this into account.
         //  This memory read is by far the biggest bottleneck here.
-        __m256i loadedColors = _mm256_mask_i32gather_epi32(finalCombinedMask, (const int*)textureData, colorValues, finalCombinedMask, 4);
+        __m256i loadedColors;
+        if constexpr (filter == TextureFilter::Point) {
+          // Same addressing as the SSE version.
+          __m256i x = _mm256_cvtps_epi32(uValues);
+          __m256i y = _mm256_cvttps_epi32(vValues);
+          __m256i stride = _mm256_set1_epi32(level.stride);
+
+          __m256i colorValues;
+          if constexpr (layout == TextureLayout::Linear) {
+            colorValues = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+          }
+          else {
+            colorValues = _mm256_add_epi32(TiledRowOffsets256(y, stride), _mm256_slli_epi32(x, 2));
+          }
+
+          loadedColors = _mm256_mask_i32gather_epi32(finalCombinedMask, (const int*)level.data, colorValues, finalCombinedMask, 4);
+        }
+        else {
+          __m256i colorsLo;
+          __m256i colorsHi;
+          SampleBilinear256<layout>(level, uValues, vValues, finalCombinedMask, colorsLo, colorsHi);
+
+          if constexpr (filter == TextureFilter::Trilinear) {
+            if (levelBlend != 0) {
+              __m256i nextColorsLo;
+              __m256i nextColorsHi;
+              SampleBilinear256<layout>(nextLevel, _mm256_mul_ps(uValues, nextUScale), _mm256_mul_ps(vValues, nextVScale), finalCombinedMask, nextColorsLo, nextColorsHi);
+              colorsLo = LerpFixed256(colorsLo, nextColorsLo, levelWeight, levelWeightInv);
+              colorsHi = LerpFixed256(colorsHi, nextColorsHi, levelWeight, levelWeightInv);
+            }
+          }
+
+          loadedColors = FinishBilinear256<layout>(colorsLo, colorsHi);
+        }
 
         _mm256_maskstore_epi32((int*)pixels, finalCombinedMask, loadedColors);
         _mm256_maskstore_ps(pixelDepth, finalCombinedMask, zValues);
@@ -2627,11 +3953,38 @@ void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __re
         weights2 = _mm256_sub_ps(weights2, xStep2);
       }
     }
+
+    HiZUpdateCovered(hiZ, hiZWidth, minX, minY, maxX, maxY, p1, p2, p3);
   }
 }
 
+// Picks the instance matching the texture layout so addressing is resolved outside of the raster loop.
+// Textures too small for a 2x2 footprint can only be point sampled.
+template<TextureFilter filter>
+static void Dispatch_UV_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  if ((filter != TextureFilter::Point) && ((texture->Width(0) < 2) || (texture->Height(0) < 2))) {
+    Dispatch_UV_AVX<TextureFilter::Point>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
+  else if (texture->Layout() == TextureLayout::Tiled) {
+    Shader_UV_AVX<filter, TextureLayout::Tiled>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
+  else {
+    Shader_UV_AVX<filter, TextureLayout::Linear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+  }
 }
 
-#endif
+void Unaligned_Shader_UV_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_AVX<TextureFilter::Point>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+void Unaligned_Shader_UV_Bilinear_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_AVX<TextureFilter::Bilinear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+void Unaligned_Shader_UV_Trilinear_AVX(const float* __restrict vertices, const int32* __restrict indices, const int32 end, const float maxWidth, uint8* __restrict framebuffer, float* __restrict depthBuffer, float* __restrict hiZ, const Texture* __restrict texture, size_t mipLevel, const int32 tileBounds[4]) {
+  Dispatch_UV_AVX<TextureFilter::Trilinear>(vertices, indices, end, maxWidth, framebuffer, depthBuffer, hiZ, texture, mipLevel, tileBounds);
+}
+
+}
 
 #endif
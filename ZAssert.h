@@ -5,5 +5,7 @@
 #else
 #ifdef PLATFORM_WINDOWS
 #define ZAssert(condition) if (!(condition)) { __debugbreak(); }
+#else
+#define ZAssert(condition) if (!(condition)) { __builtin_trap(); }
 #endif
 #endif
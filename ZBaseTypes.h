@@ -4,12 +4,21 @@ namespace ZSharp {
   typedef unsigned char uint8;
   typedef unsigned short uint16;
   typedef unsigned int uint32;
+#ifdef _WIN32
   typedef unsigned long long uint64;
+#else
+  // LP64, long is 64 bits and is what the system size_t is built on.
+  typedef unsigned long uint64;
+#endif
 
   typedef char int8;
   typedef short int16;
   typedef int int32;
+#ifdef _WIN32
   typedef long long int64;
+#else
+  typedef long int64;
+#endif
 
   constexpr uint8 min_uint8 = 0x0U;
   constexpr uint16 min_uint16 = 0x0U;
@@ -32,7 +41,7 @@ namespace ZSharp {
   constexpr int32 max_int32 = 0x7FFFFFFF;
   constexpr int64 max_int64 = 0x7FFFFFFFFFFFFFFF;
 
-#ifdef _M_X64
+#if defined(_M_X64) || defined(__x86_64__)
   typedef uint64 size_t;
   typedef int64 ssize_t;
 
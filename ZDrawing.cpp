@@ -134,10 +134,12 @@ void RGBShader(Framebuffer& framebuffer, DepthBuffer& depthBuffer, const VertexB
     end = indexBuffer.GetIndexSize();
   }
   
-  RGBShaderImpl(vertexClipData, indexClipData, end, maxWidth, framebuffer.GetBuffer(), depthBuffer.GetBuffer());
+  const int32 screenBounds[4] = { 0, 0, (int32)frameWidth, (int32)framebuffer.GetHeight() };
+
+  RGBShaderImpl(vertexClipData, indexClipData, end, maxWidth, framebuffer.GetBuffer(), depthBuffer.GetBuffer(), depthBuffer.GetHiZ(), screenBounds);
 }
 
-void TextureMappedShader(Framebuffer& framebuffer, DepthBuffer& depthBuffer, const VertexBuffer& vertexBuffer, const IndexBuffer& indexBuffer, bool wasClipped, const Texture* texture, size_t mipLevel) {
+void TextureMappedShader(Framebuffer& framebuffer, DepthBuffer& depthBuffer, const VertexBuffer& vertexBuffer, const IndexBuffer& indexBuffer, bool wasClipped, const Texture* texture, TextureFilter textureFilter, size_t mipLevel) {
   NamedScopedTimer(DrawFlatTrianglesUV);
 
   const size_t frameWidth = framebuffer.GetWidth();
@@ -158,7 +160,22 @@ void TextureMappedShader(Framebuffer& framebuffer, DepthBuffer& depthBuffer, con
     end = indexBuffer.GetIndexSize();
   }
 
-  UVShaderImpl(vertexClipData, indexClipData, end, maxWidth, framebuffer.GetBuffer(), depthBuffer.GetBuffer(), texture, mipLevel);
+  const int32 screenBounds[4] = { 0, 0, (int32)frameWidth, (int32)framebuffer.GetHeight() };
+
+  UVShaderFunc shaderImpl;
+  switch (textureFilter) {
+    case TextureFilter::Bilinear:
+      shaderImpl = UVBilinearShaderImpl;
+      break;
+    case TextureFilter::Trilinear:
+      shaderImpl = UVTrilinearShaderImpl;
+      break;
+    default:
+      shaderImpl = UVShaderImpl;
+      break;
+  }
+
+  shaderImpl(vertexClipData, indexClipData, end, maxWidth, framebuffer.GetBuffer(), depthBuffer.GetBuffer(), depthBuffer.GetHiZ(), texture, mipLevel, screenBounds);
 }
 
 void WireframeShader(Framebuffer& framebuffer, const VertexBuffer& vertexBuffer, const IndexBuffer& indexBuffer, bool wasClipped, ZColor color) {
@@ -5,6 +5,7 @@
 #include "Framebuffer.h"
 #include "DepthBuffer.h"
 #include "IndexBuffer.h"
+#include "ShaderDefinition.h"
 #include "Texture.h"
 #include "VertexBuffer.h"
 #include "ZColor.h"
@@ -23,6 +24,7 @@ void TextureMappedShader(Framebuffer& framebuffer,
   const IndexBuffer& indexBuffer,
   bool wasClipped,
   const Texture* texture,
+  TextureFilter textureFilter,
   size_t mipLevel);
 
 void WireframeShader(Framebuffer& framebuffer,
@@ -9,6 +9,8 @@
 #include <cstring>
 #include <cwchar>
 #include <cctype>
+#include <cstdio>
+#include <cwctype>
 
 namespace ZSharp {
 
@@ -720,7 +722,7 @@ void String::VariableArg::ToString(String& str, int32 numDigits) const {
     case Type::SIZE_T:
     {
       char buffer[32];
-      size_t length = snprintf(buffer, sizeof(buffer), "%llu", mData.size_value);
+      size_t length = snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)mData.size_value);
       str.Append(buffer, 0, length);
     }
       break;
@@ -753,14 +755,14 @@ void String::VariableArg::ToString(String& str, int32 numDigits) const {
     case Type::INT64:
     {
       char buffer[32];
-      size_t length = snprintf(buffer, sizeof(buffer), "%lld", mData.int64_value);
+      size_t length = snprintf(buffer, sizeof(buffer), "%lld", (long long)mData.int64_value);
       str.Append(buffer, 0, length);
     }
       break;
     case Type::UINT64:
     {
       char buffer[32];
-      size_t length = snprintf(buffer, sizeof(buffer), "%llu", mData.uint64_value);
+      size_t length = snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)mData.uint64_value);
       str.Append(buffer, 0, length);
     }
       break;
@@ -1504,14 +1506,14 @@ void WideString::VariableArg::ToString(WideString& str, int32 numDigits) const {
     case Type::INT64:
     {
       wchar_t buffer[64];
-      size_t length = swprintf(buffer, sizeof(buffer), L"%lld", mData.int64_value);
+      size_t length = swprintf(buffer, sizeof(buffer), L"%lld", (long long)mData.int64_value);
       str.Append(buffer, 0, length);
     }
     break;
     case Type::UINT64:
     {
       wchar_t buffer[64];
-      size_t length = swprintf(buffer, sizeof(buffer), L"%llu", mData.uint64_value);
+      size_t length = swprintf(buffer, sizeof(buffer), L"%llu", (unsigned long long)mData.uint64_value);
       str.Append(buffer, 0, length);
     }
     break;